@@ -0,0 +1,162 @@
+/*** aoj.c -- as-of merge join over timestamped line cursors
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "aoj.h"
+#include "tv.h"
+#include "nifty.h"
+
+/* initial read buffer size, grown for overlong lines */
+#define AOJ_BUFZ	(256U * 1024U)
+
+
+static int
+refill(aoj_cur_t *restrict c)
+{
+/* move the unconsumed tail to the front and read more behind it,
+ * return the number of bytes read, 0 on eof or -1 on error */
+	ssize_t nrd;
+
+	if (c->bix) {
+		memmove(c->buf, c->buf + c->bix, c->bnd - c->bix);
+		c->bnd -= c->bix;
+		c->bix = 0U;
+	}
+	if (UNLIKELY(c->bnd >= c->bsz)) {
+		/* line longer than the buffer, keep room for the nuls */
+		const size_t nuz = 2U * c->bsz;
+		char *nub = realloc(c->buf, nuz + 2U);
+
+		if (UNLIKELY(nub == NULL)) {
+			return -1;
+		}
+		c->buf = nub;
+		c->bsz = nuz;
+	}
+	do {
+		nrd = read(c->fd, c->buf + c->bnd, c->bsz - c->bnd);
+	} while (UNLIKELY(nrd < 0 && errno == EINTR));
+	if (UNLIKELY(nrd <= 0)) {
+		return (int)nrd;
+	}
+	c->bnd += nrd;
+	c->foff += nrd;
+	/* have the kernel fetch the next chunk while we parse this one,
+	 * this fails harmlessly on pipes */
+	(void)posix_fadvise(c->fd, c->foff, c->bsz, POSIX_FADV_WILLNEED);
+	return 1;
+}
+
+
+int
+aoj_open(aoj_cur_t *restrict c, int fd)
+{
+	*c = (aoj_cur_t){.t = 0U, .fd = fd};
+	if (UNLIKELY((c->buf = malloc(AOJ_BUFZ + 2U)) == NULL)) {
+		return -1;
+	}
+	c->bsz = AOJ_BUFZ;
+	c->buf[0U] = '\0';
+	(void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	return 0;
+}
+
+void
+aoj_close(aoj_cur_t *restrict c)
+{
+	free(c->buf);
+	c->buf = NULL;
+	c->t = NATV;
+	return;
+}
+
+tv_t
+aoj_next(aoj_cur_t *restrict c)
+{
+	if (UNLIKELY(c->buf == NULL)) {
+		return c->t = NATV;
+	}
+	do {
+		char *eol;
+
+		/* put back what we shadowed for the previous line */
+		c->buf[c->gix] = c->sav;
+
+		while ((eol = memchr(c->buf + c->bix, '\n',
+				     c->bnd - c->bix)) == NULL) {
+			if (LIKELY(refill(c) > 0)) {
+				continue;
+			} else if (c->bix >= c->bnd) {
+				/* exhausted, free the buffer early */
+				aoj_close(c);
+				return NATV;
+			}
+			/* last line without a newline */
+			eol = c->buf + c->bnd;
+			break;
+		}
+		c->ln = c->buf + c->bix;
+		c->lz = eol - c->ln;
+		c->bix = eol - c->buf + (eol < c->buf + c->bnd);
+		/* terminate the line twice, like getline() followed by the
+		 * nul, parsers tend to step over the newline */
+		*eol++ = '\0';
+		c->gix = eol - c->buf;
+		c->sav = *eol;
+		*eol = '\0';
+	} while (UNLIKELY((c->t = strtotv(c->ln, &c->on)) == NATV));
+	return c->t;
+}
+
+size_t
+aoj_min(const aoj_cur_t *c, size_t nc)
+{
+	size_t k = 0U;
+
+	for (size_t j = 1U; j < nc; j++) {
+		k = c[j].t < c[k].t ? j : k;
+	}
+	return k < nc && c[k].t < NATV ? k : nc;
+}
+
+/* aoj.c ends here */
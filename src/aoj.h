@@ -0,0 +1,98 @@
+/*** aoj.h -- as-of merge join over timestamped line cursors
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_aoj_h_
+#define INCLUDED_aoj_h_
+#include <unistd.h>
+#include "tv.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/**
+ * Cursor over a time-ordered line file.
+ * Lines are handed out in place, i.e. without copying them out of the
+ * read buffer.  The newline and the byte after it are overwritten by
+ * nuls so LN can be parsed with the usual string routines, even ones
+ * that step over the end of the line.  The view stays valid until the
+ * next aoj_next() on the same cursor. */
+typedef struct {
+	/* timestamp of the current line, NATV when exhausted */
+	tv_t t;
+	/* the current line, LZ bytes, nul-terminated */
+	char *ln;
+	size_t lz;
+	/* just past the timestamp */
+	char *on;
+
+	/* private */
+	int fd;
+	char *buf;
+	size_t bsz;
+	size_t bix;
+	size_t bnd;
+	size_t foff;
+	size_t gix;
+	char sav;
+} aoj_cur_t;
+
+/**
+ * Set up cursor C to read from FD, C is positioned before the first line.
+ * Return 0 on success or -1 if the read buffer cannot be allocated. */
+extern int aoj_open(aoj_cur_t *c, int fd);
+
+/**
+ * Release resources held by C, FD is left open. */
+extern void aoj_close(aoj_cur_t *c);
+
+/**
+ * Advance C to the next line that starts with a timestamp and return it.
+ * Lines without a timestamp are skipped, NATV once C is exhausted and
+ * on every call after that. */
+extern tv_t aoj_next(aoj_cur_t *c);
+
+/**
+ * Return the index of the cursor in C[0..NC) whose current line is due
+ * first.  Ties go to the lowest index so callers rank their streams by
+ * the order of C, NC if all cursors are exhausted. */
+extern size_t aoj_min(const aoj_cur_t *c, size_t nc);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_aoj_h_ */
@@ -0,0 +1,234 @@
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
+#if defined HAVE_DFP754_H
+# include <dfp754.h>
+#endif	/* HAVE_DFP754_H */
+#include "dfp754_d32.h"
+#include "dfp754_d64.h"
+#include "tv.h"
+#include "bt.h"
+#include "nifty.h"
+
+#define strtopx		strtod32
+#define strtoqx		strtod64
+
+static struct sex_s sex = {
+	.exe_age = 60U * USECS,
+	.qty = 1.dd,
+	.comb = 0.df,
+	.comt = 0.df,
+};
+static struct eva_s e = {
+	.intv = 10 * MSECS,
+};
+static struct sum_s sum;
+
+static const char *cont;
+static size_t conz;
+
+/* tee files */
+static FILE *xfp;
+static FILE *vfp;
+
+
+static __attribute__((format(printf, 1, 2))) void
+serror(const char *fmt, ...)
+{
+	va_list vap;
+	va_start(vap, fmt);
+	vfprintf(stderr, fmt, vap);
+	va_end(vap);
+	if (errno) {
+		fputc(':', stderr);
+		fputc(' ', stderr);
+		fputs(strerror(errno), stderr);
+	}
+	fputc('\n', stderr);
+	return;
+}
+
+
+static void
+send_eva(void *UNUSED(clo), size_t UNUSED(acc), eva_t v)
+{
+	char buf[256U];
+	size_t len;
+
+	len = evatostr(buf, sizeof(buf), cont, conz, v);
+	fwrite(buf, 1, len, vfp);
+	return;
+}
+
+static void
+push_quo(void *UNUSED(clo), quo_t q)
+{
+	eva_push_quo(&e, q);
+	return;
+}
+
+static void
+push_fill(void *UNUSED(clo), exe_t x, acc_t a)
+{
+	if (xfp) {
+		char buf[512U];
+		size_t len;
+
+		len = exetostr(buf, sizeof(buf), cont, conz, x);
+		len += acctostr(buf + len, sizeof(buf) - len, cont, conz, x.t, a);
+		fwrite(buf, 1, len, xfp);
+	}
+	if (vfp) {
+		eva_push_acc(&e, 0U, x.t, a);
+	}
+	sum_push_exe(&sum, x);
+	sum_push_acc(&sum, x.t, a);
+	return;
+}
+
+
+#include "backtest.yucc"
+
+int
+main(int argc, char *argv[])
+{
+	static yuck_t argi[1U];
+	int rc = 0;
+	FILE *qfp;
+
+	if (yuck_parse(argi, argc, argv) < 0) {
+		rc = 1;
+		goto out;
+	} else if (!argi->nargs) {
+		errno = 0, serror("\
+Error: QUOTES file is mandatory.");
+		rc = 1;
+		goto out;
+	}
+
+	if (argi->pair_arg) {
+		cont = argi->pair_arg;
+		conz = strlen(cont);
+		sex.conx = sex_conx(cont, conz);
+	}
+
+	if (argi->exe_delay_arg) {
+		sex.exe_age = strtoul(argi->exe_delay_arg, NULL, 10);
+		sex.exe_age *= USECS;
+	}
+
+	if (argi->commission_arg) {
+		char *on = argi->commission_arg;
+
+		switch (*on) {
+		default:
+			sex.comb = strtopx(on, &on);
+
+			if (*on == '/') {
+		case '/':
+			sex.comt = strtopx(++on, &on);
+			if (*on == '/') {
+				errno = 0, serror("\
+Error: commission must be given as PXb[/PXt]");
+				rc = 1;
+				goto out;
+			}
+			}
+			break;
+		}
+	}
+
+	if (argi->quantity_arg) {
+		sex.qty = strtoqx(argi->quantity_arg, NULL);
+	}
+
+	sex.absq = argi->absqty_flag;
+	sex.maxq = argi->maxqty_flag;
+
+	if (argi->retry_arg) {
+		if (argi->retry_arg != YUCK_OPTARG_NONE) {
+			sex.rtry = strtoul(argi->retry_arg, NULL, 10);
+		} else {
+			sex.rtry = NATV;
+		}
+	}
+
+	if (argi->interval_arg) {
+		if (!(e.intv = strtoul(argi->interval_arg, NULL, 10))) {
+			errno = 0, serror("\
+Error: interval argument cannot be naught");
+			rc = 1;
+			goto out;
+		}
+		/* turn into milliseconds */
+		e.intv *= NSECS;
+	}
+
+	sum.edgp = argi->edge_flag;
+	sum.grossp = argi->gross_flag;
+
+	if (argi->exe_output_arg &&
+	    UNLIKELY((xfp = fopen(argi->exe_output_arg, "w")) == NULL)) {
+		serror("\
+Error: cannot open output file `%s'", argi->exe_output_arg);
+		rc = 1;
+		goto out;
+	}
+
+	if (argi->eva_output_arg &&
+	    UNLIKELY((vfp = fopen(argi->eva_output_arg, "w")) == NULL)) {
+		serror("\
+Error: cannot open output file `%s'", argi->eva_output_arg);
+		rc = 1;
+		goto clo;
+	}
+
+	if (UNLIKELY((qfp = fopen(*argi->args, "r")) == NULL)) {
+		serror("\
+Error: cannot open QUOTES file `%s'", *argi->args);
+		rc = 1;
+		goto clo;
+	}
+
+	/* wire up the engines, the simulator drives everything */
+	if (vfp) {
+		e.eva = send_eva;
+		sex.quo = push_quo;
+	}
+	sex.fill = push_fill;
+	sum_init(&sum);
+
+	/* offline mode */
+	rc = sex_offline(&sex, qfp, stdin);
+
+	sum_fini(&sum);
+	eva_fini(&e);
+	if (!argi->table_flag) {
+		sum_prnt_matrix(&sum);
+		if (argi->verbose_flag) {
+			sum_prnt_expla();
+		}
+	} else {
+		sum_prnt_table(&sum);
+	}
+
+	fclose(qfp);
+clo:
+	if (vfp) {
+		fclose(vfp);
+	}
+	if (xfp) {
+		fclose(xfp);
+	}
+out:
+	yuck_free(argi);
+	return rc;
+}
@@ -0,0 +1,1380 @@
+/*** bt.c -- backtest engine
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#if defined HAVE_DFP754_H
+# include <dfp754.h>
+#elif defined HAVE_DFP_STDLIB_H
+# include <dfp/stdlib.h>
+#else  /* !HAVE_DFP754_H && !HAVE_DFP_STDLIB_H */
+static inline __attribute__((pure, const)) _Decimal64
+fabsd64(_Decimal64 x)
+{
+	return x >= 0 ? x : -x;
+}
+#endif	/* HAVE_DFP754_H || HAVE_DFP_STDLIB_H */
+#include "dfp754_d32.h"
+#include "dfp754_d64.h"
+#include "bt.h"
+#include "hash.h"
+#include "aoj.h"
+#include "nifty.h"
+
+#define strtopx		strtod32
+#define pxtostr		d32tostr
+#define strtoqx		strtod64
+#define qxtostr		d64tostr
+#define NANPX		NAND32
+#define isnanpx		isnand32
+#define isnanqx		isnand64
+#define fabsqx		fabsd64
+
+
+static inline size_t
+memncpy(void *restrict buf, const void *src, size_t n)
+{
+	return memcpy(buf, src, n), n;
+}
+
+static inline char*
+strcws(const char *x)
+{
+	const unsigned char *y;
+	for (y = (const unsigned char*)x; *y >= ' '; y++);
+	return deconst(y);
+}
+
+static hx_t
+strtohx(const char *x, char **on)
+{
+	char *ep;
+	hx_t res;
+
+	ep = strcws(x);
+	res = hash(x, ep - x);
+	if (LIKELY(on != NULL)) {
+		*on = ep;
+	}
+	return res;
+}
+
+static inline __attribute__((const, pure)) tv_t
+max_tv(tv_t t1, tv_t t2)
+{
+	return t1 > t2 ? t1 : t2;
+}
+
+
+/* serialisers */
+size_t
+exetostr(char *restrict buf, size_t bsz,
+	 const char *cont, size_t conz, exe_t x)
+{
+/* exe encodes delta to metronome and delay */
+	static const char vexe[] = "EXE\t";
+	static const char vrej[] = "REJ\t";
+	size_t len;
+
+	len = tvtostr(buf, bsz, x.t);
+	buf[len++] = '\t';
+	len += memncpy(buf + len, (isnanpx(x.p) ? vrej : vexe), strlenof(vexe));
+	len += memncpy(buf + len, cont, conz);
+	buf[len++] = '\t';
+	len += qxtostr(buf + len, bsz - len, x.q);
+	buf[len++] = '\t';
+	len += pxtostr(buf + len, bsz - len, x.p);
+	/* spread at the time */
+	buf[len++] = '\t';
+	len += pxtostr(buf + len, bsz - len, x.s);
+	/* how long was quote standing */
+	buf[len++] = '\t';
+	len += tvtostr(buf + len, bsz - len, x.g);
+	buf[len++] = '\n';
+	return len;
+}
+
+size_t
+acctostr(char *restrict buf, size_t bsz,
+	 const char *cont, size_t conz, tv_t t, acc_t a)
+{
+	static const char verb[] = "ACC\t";
+	size_t len;
+
+	len = tvtostr(buf, bsz, t);
+	buf[len++] = '\t';
+	len += memncpy(buf + len, verb, strlenof(verb));
+	len += memncpy(buf + len, cont, conz);
+	buf[len++] = '\t';
+	len += qxtostr(buf + len, bsz - len, a.base);
+	buf[len++] = '\t';
+	len += qxtostr(buf + len, bsz - len, a.term);
+	buf[len++] = '\t';
+	len += qxtostr(buf + len, bsz - len, a.comb);
+	buf[len++] = '\t';
+	len += qxtostr(buf + len, bsz - len, a.comt);
+	buf[len++] = '\n';
+	return len;
+}
+
+size_t
+evatostr(char *restrict buf, size_t bsz,
+	 const char *cont, size_t conz, eva_t v)
+{
+	static const char verb[] = "EVA";
+	size_t len;
+
+	len = tvtostr(buf, bsz, v.t);
+	buf[len++] = '\t';
+	len += memncpy(buf + len, verb, strlenof(verb));
+	buf[len++] = '\t';
+	len += memncpy(buf + len, cont, conz);
+	buf[len++] = '\t';
+	len += qxtostr(buf + len, bsz - len, v.nlv);
+	buf[len++] = '\t';
+	len += qxtostr(buf + len, bsz - len, v.comm);
+	buf[len++] = '\n';
+	return len;
+}
+
+static ssize_t
+dtostr4(char *restrict buf, size_t UNUSED(bsz), double x)
+{
+/* works best for X in [0,1] */
+	size_t len = 0U;
+
+	if (x <= 1. && x >= 0.) {
+		unsigned int y = (unsigned int)(x * 100000.);
+
+		y = y / 10 + ((y % 10) >= 5);
+		buf[len++] = (char)((y >= 10000U) ^ '0');
+		buf[len++] = '.';
+		for (size_t i = 0U; i < 4U; i++, y *= 10U) {
+			buf[len++] = (char)((y / 1000U) % 10U ^ '0');
+		}
+		return len;
+	}
+	/* otherwise we say it's NAN */
+	return memncpy(buf, "nan", 3U);
+}
+
+
+
+
+/* simulator */
+static exe_t
+try_exec(ord_t o, quo_t q)
+{
+/* this takes an order + quotes and executes it at market price */
+	const tv_t t = max_tv(o.t, q.t);
+	px_t p;
+	px_t s = q.a - q.b;
+	tv_t age = t - q.t;
+
+	switch (o.r) {
+	case RGM_LONG:
+	case RGM_SHORT:
+		if (o.q > 0.dd && (isnanpx(p = q.a) || p > o.lp)) {
+			/* no can do exec */
+			break;
+		} else if (o.q < 0.dd && (isnanpx(p = q.b) || p < o.lp)) {
+			/* no can do exec */
+			break;
+		}
+		return (exe_t){t, p, o.q, s, age};
+
+	case RGM_CANCEL:
+	case RGM_EMERGCLOSE:
+		if (o.q > 0.dd) {
+			p = q.b;
+		} else if (o.q < 0.dd) {
+			p = q.a;
+		} else {
+			break;
+		}
+		return (exe_t){t, p, -o.q, s, age};
+
+	default:
+		/* otherwise do nothing */
+		break;
+	}
+	return (exe_t){t, NANPX, o.q, s, age};
+}
+
+static acc_t
+alloc(acc_t a, exe_t x, px_t cb/*base comm*/, px_t ct/*terms coommission*/)
+{
+/* allocate execution X to account A. */
+	if (LIKELY(!isnanpx(x.p))) {
+		/* calc accounts */
+		a.base += x.q;
+		a.term -= x.q * x.p;
+		a.comb -= fabsd64(x.q) * cb;
+		a.comt -= fabsd64(x.q * x.p) * ct;
+
+		/* quantize to make them look nicer */
+		a.base = quantized64(a.base, 0.00dd);
+		a.term = quantized64(a.term, 0.00dd);
+		a.comb = quantized64(a.comb, 0.00dd);
+		a.comt = quantized64(a.comt, 0.00dd);
+	}
+	return a;
+}
+
+static ord_t
+yield_ord(const struct sex_s *s, aoj_cur_t *restrict c)
+{
+	char *on;
+	ord_t o;
+	tv_t t;
+
+retry:
+	if (UNLIKELY((t = aoj_next(c)) == NATV)) {
+		return (ord_t){NATV};
+	}
+	/* otherwise snarf the order line */
+	on = c->on + 1U;
+	/* read the order */
+	switch (*on) {
+		px_t p;
+		hx_t hx;
+
+	case 'L'/*ONG*/:
+		o = (ord_t){t, RGM_LONG, .q = s->qty, .lp = INFD32};
+		on += 4U;
+		goto ord;
+	case 'S'/*HORT*/:
+		o = (ord_t){t, RGM_SHORT, .q = -s->qty, .lp = -INFD32};
+		on += 5U;
+		goto ord;
+	case 'C'/*ANCEL*/:
+	case 'E'/*MERG*/:
+		on = strcws(on);
+		if (LIKELY(*on++ == '\t' && (hx = strtohx(on, &on)))) {
+			/* got a tab and a currency indicator */
+			if (UNLIKELY(hx != s->conx && s->conx)) {
+				/* but it's not for us */
+				goto retry;
+			}
+		}
+		o = (ord_t){t, RGM_CANCEL, .q = 0.dd};
+		break;
+	default:
+		goto retry;
+
+	ord:
+		if (UNLIKELY(*on++ != '\t')) {
+			break;
+		}
+		if (UNLIKELY(!(hx = strtohx(on, &on)))) {
+			/* no currency indicator */
+			break;
+		} else if (UNLIKELY(hx != s->conx && s->conx)) {
+			/* not for us this one isn't */
+			goto retry;
+		}
+		/* otherwise snarf the limit price */
+		if ((p = strtopx(++on, &on))) {
+			o.gtd = NATV;
+			o.lp = p;
+		}
+		if (*on != '\t' && (on = strchr(on, '\t')) == NULL) {
+			break;
+		}
+		/* oh and a target price */
+		o.tp = strtopx(++on, &on);
+		if (*on != '\t' && (on = strchr(on, '\t')) == NULL) {
+			break;
+		}
+		/* and finally a stop/loss */
+		o.sl = strtopx(++on, &on);
+		if (*on != '\t' && (on = strchr(on, '\t')) == NULL) {
+			break;
+		}
+	}
+	return o;
+}
+
+static quo_t
+yield_quo(const struct sex_s *s, aoj_cur_t *restrict c)
+{
+	char *on;
+	quo_t q;
+	hx_t h;
+
+retry:
+	if (UNLIKELY((q.t = aoj_next(c)) == NATV)) {
+		return (quo_t){NATV};
+	}
+	/* otherwise snarf the quote line */
+	on = c->on + 1U;
+	/* instrument next */
+	if (UNLIKELY(!(h = strtohx(on, &on)) || *on != '\t')) {
+		goto retry;
+	} else if (UNLIKELY(h != s->conx && s->conx)) {
+		goto retry;
+	}
+	with (const char *str = ++on) {
+		q.b = strtopx(str, &on);
+		q.b = on > str ? q.b : NANPX;
+	}
+	with (const char *str = ++on) {
+		q.a = strtopx(str, &on);
+		q.a = on > str ? q.a : NANPX;
+	}
+	return q;
+}
+
+static void
+grow_oq(struct sex_s *s)
+{
+/* compact the order queue and make it 16 times as big */
+	ord_t *nuq = malloc((s->zoq *= 16U) * sizeof(*s->oq));
+
+	memcpy(nuq, s->oq + s->ioq, (s->noq - s->ioq) * sizeof(*s->oq));
+	s->noq -= s->ioq;
+	s->ioq = 0U;
+	free(s->oq);
+	s->oq = nuq;
+	return;
+}
+
+static void
+enq_ord(struct sex_s *s, ord_t o)
+{
+/* append O to the order queue, indices into the queue stay valid */
+	if (UNLIKELY(s->noq >= s->zoq)) {
+		s->oq = realloc(s->oq, (s->zoq *= 16U) * sizeof(*s->oq));
+	}
+	s->oq[s->noq++] = o;
+	return;
+}
+
+static void
+sex_exec(struct sex_s *s, tv_t t)
+{
+/* go through order queue and try exec'ing orders before T @q */
+	for (size_t i = s->ioq; i < s->noq && s->oq[i].t < t; i++) {
+		ord_t *const oq = s->oq;
+		exe_t x;
+
+		switch (oq[i].r) {
+		case RGM_UNK:
+			/* don't go for dead orders */
+			continue;
+		case RGM_CANCEL:
+		case RGM_EMERGCLOSE:
+			/* adjust for current account base */
+			oq[i].q = s->acc.base;
+			/* cancel all pending limit orders */
+			for (size_t j = s->ioq; j < s->noq; j++) {
+				if (i == j) {
+					continue;
+				} else if (oq[j].t > oq[i].t) {
+					continue;
+				}
+				/* otherwise shred him */
+				oq[j].r = RGM_UNK;
+			}
+		default:
+			break;
+		}
+		/* adapt cancellations to current accounts */
+		oq[i].q = (oq[i].r & RGM_CANCEL) == RGM_CANCEL
+			? s->acc.base
+			: oq[i].q;
+		/* try executing him */
+		x = try_exec(oq[i], s->q);
+		if (isnanpx(x.p) && oq[i].gtd > x.t) {
+			continue;
+		}
+		/* massage execution */
+		x.q -= !s->absq ||
+			(oq[i].r & RGM_CANCEL) == RGM_CANCEL ||
+			x.q > 0.dd && s->acc.base > 0.dd ||
+			x.q < 0.dd && s->acc.base < 0.dd ||
+			isnanpx(x.p)
+			? 0.dd
+			: s->acc.base;
+		x.q = !s->maxq || s->acc.base != x.q ? x.q : 0.dd;
+		/* otherwise send post-trade details */
+		s->acc = alloc(s->acc, x, s->comb, s->comt);
+		s->fill(s->clo, x, s->acc);
+
+		/* instead of dequeuing we're just setting
+		 * an order's regime */
+		with (const ord_t o = oq[i]) {
+			oq[i].r = RGM_UNK;
+			/* check for brackets, this may move the queue */
+			if (o.tp) {
+				enq_ord(s, (ord_t){
+						x.t,
+						.r = (rgm_t)(o.r ^ RGM_CANCEL),
+						.gtd = NATV,
+						.q = -x.q,
+						.lp = o.tp,
+						.sl = o.sl,
+					});
+			}
+		}
+	}
+	/* fast forward dead orders */
+	for (; s->ioq < s->noq && !s->oq[s->ioq].r; s->ioq++);
+	/* gc'ing again */
+	if (UNLIKELY(s->ioq >= s->zoq / 2U)) {
+		memmove(s->oq, s->oq + s->ioq,
+			(s->noq - s->ioq) * sizeof(*s->oq));
+		s->noq -= s->ioq;
+		s->ioq = 0U;
+	}
+	return;
+}
+
+static void
+sex_quo(struct sex_s *s, quo_t q)
+{
+	s->q = q;
+	if (s->quo) {
+		s->quo(s->clo, q);
+	}
+	return;
+}
+
+void
+sex_init(struct sex_s *s)
+{
+	s->q = (quo_t){NATV, NANPX, NANPX};
+	s->acc = (acc_t){
+		.base = 0.dd, .term = 0.dd, .comb = 0.dd, .comt = 0.dd,
+	};
+	s->oq = malloc((s->zoq = 256U) * sizeof(*s->oq));
+	s->ioq = s->noq = 0U;
+	return;
+}
+
+void
+sex_fini(struct sex_s *s)
+{
+	/* finalise with the last known quote */
+	if (s->acc.base) {
+		ord_t o = {s->q.t, RGM_CANCEL, .q = s->acc.base};
+		exe_t x = try_exec(o, s->q);
+		s->acc = alloc(s->acc, x, s->comb, s->comt);
+		s->fill(s->clo, x, s->acc);
+	}
+	free(s->oq);
+	s->oq = NULL;
+	s->ioq = s->noq = s->zoq = 0U;
+	return;
+}
+
+void
+sex_push_ord(struct sex_s *s, ord_t o)
+{
+	/* tune to exe delay */
+	o.t += s->exe_age;
+	o.gtd = o.gtd ?: s->rtry < NATV ? o.t + s->rtry : s->rtry;
+	enq_ord(s, o);
+	return;
+}
+
+void
+sex_push_quo(struct sex_s *s, quo_t q)
+{
+	sex_exec(s, q.t);
+	sex_quo(s, q);
+	return;
+}
+
+uint32_t
+sex_conx(const char *ins, size_t inz)
+{
+	return hash(ins, inz);
+}
+
+int
+sex_offline(struct sex_s *s, FILE *qfp, FILE *ofp)
+{
+	aoj_cur_t qc[1U], oc[1U];
+	bool oeof = false;
+
+	if (UNLIKELY(aoj_open(qc, fileno(qfp)) < 0)) {
+		return -1;
+	} else if (UNLIKELY(aoj_open(oc, fileno(ofp)) < 0)) {
+		aoj_close(qc);
+		return -1;
+	}
+
+	/* we can't do nothing before the first quote, so read that one
+	 * as a reference and fast forward orders beyond that point,
+	 * orders are read ahead in batches as big as the queue */
+	sex_init(s);
+	for (quo_t newq; (newq = yield_quo(s, qc)).t < NATV;
+	     sex_quo(s, newq)) {
+	ord:
+		if (UNLIKELY(oeof)) {
+			/* order file is eof'd, skip fetching more */
+			goto exe;
+		}
+		for (ord_t newo;
+		     s->noq < s->zoq && (newo = yield_ord(s, oc)).t < NATV;
+		     sex_push_ord(s, newo));
+		if (UNLIKELY(s->noq < s->zoq)) {
+			/* out of orders we are */
+			oeof = true;
+		}
+
+	exe:
+		sex_exec(s, newq.t);
+		if (UNLIKELY(oeof)) {
+			/* order file is eof'd, skip fetching more */
+			;
+		} else if (UNLIKELY(!s->noq)) {
+			/* fill up the queue some more and do more exec'ing */
+			goto ord;
+		} else if (s->oq[s->noq - 1U].t < newq.t) {
+			/* there could be more orders between Q and NEWQ
+			 * try exec'ing those as well */
+			if (UNLIKELY(s->noq >= s->ioq + s->zoq / 2U)) {
+				/* resize :( */
+				grow_oq(s);
+			}
+			goto ord;
+		}
+	}
+	sex_fini(s);
+
+	aoj_close(qc);
+	aoj_close(oc);
+	return 0;
+}
+
+/* evaluator */
+eva_t
+eva_acc(tv_t t, acc_t a, quo_t q)
+{
+	eva_t r = {t, a.term, a.comb};
+
+	if (UNLIKELY(!a.base)) {
+		/* um, right */
+		;
+	} else if (a.base > 0.dd) {
+		/* use bids */
+		r.nlv += a.base * q.b;
+	} else if (a.base < 0.dd) {
+		/* use asks */
+		r.nlv += a.base * q.a;
+	}
+	return r;
+}
+
+static void
+eva_flush(struct eva_s *e, tv_t t)
+{
+/* evaluate all non-flat accounts on all grid points strictly before T */
+	const size_t n = e->nacc;
+
+	if (!e->nact || e->nexv >= t) {
+		return;
+	}
+	/* quotes don't change in between grid points */
+	for (size_t i = 0U; i < n; i++) {
+		const px_t p = e->base[i] > 0.dd ? e->q.b : e->q.a;
+
+		e->nlv[i] = e->term[i];
+		e->nlv[i] += e->base[i] * p;
+	}
+	for (; e->nexv < t; e->nexv += e->intv) {
+		for (size_t i = 0U; i < n; i++) {
+			if (e->base[i]) {
+				eva_t v = {e->nexv, e->nlv[i], e->comm[i]};
+				e->eva(e->clo, i, v);
+			}
+		}
+	}
+	return;
+}
+
+static void
+eva_grow(struct eva_s *e, size_t n)
+{
+	size_t nuz = e->zacc ?: 16U;
+
+	while (nuz <= n) {
+		nuz *= 2U;
+	}
+#define REALLOC(x)	x = realloc(x, nuz * sizeof(*x))
+
+	REALLOC(e->base);
+	REALLOC(e->term);
+	REALLOC(e->comm);
+	REALLOC(e->nlv);
+#undef REALLOC
+	e->zacc = nuz;
+	return;
+}
+
+void
+eva_push_quo(struct eva_s *e, quo_t q)
+{
+	eva_flush(e, q.t);
+	e->q = q;
+	return;
+}
+
+void
+eva_push_acc(struct eva_s *e, size_t i, tv_t t, acc_t a)
+{
+	eva_flush(e, t);
+	if (UNLIKELY(i >= e->zacc)) {
+		eva_grow(e, i);
+	}
+	for (; e->nacc <= i; e->nacc++) {
+		e->base[e->nacc] = 0.dd;
+		e->term[e->nacc] = 0.dd;
+		e->comm[e->nacc] = 0.dd;
+	}
+	e->nact -= e->base[i] != 0.dd;
+	e->nact += a.base != 0.dd;
+	e->base[i] = a.base;
+	e->term[i] = a.term;
+	e->comm[i] = a.comb;
+	/* set next valuation timer, everyone shares the same grid */
+	if (a.base && e->nexv < t) {
+		e->nexv = (((t - 1UL) / e->intv) + 1UL) * e->intv;
+	}
+	return;
+}
+
+void
+eva_fini(struct eva_s *e)
+{
+	free(e->base);
+	free(e->term);
+	free(e->comm);
+	free(e->nlv);
+	e->base = e->term = e->comm = e->nlv = NULL;
+	e->nacc = e->zacc = e->nact = 0U;
+	return;
+}
+
+
+/* summariser */
+static const char sstr[3U] = "FLS";
+#define _M(a, i, j)	(a[i + countof(sstr) * j])
+#define CNTS(i, j)	(_M(s->cnts, i, j))
+#define WINS(i, j)	(_M(s->wins, i, j))
+
+static inline qx_t
+calc_rpnl(struct sum_s *s)
+{
+	qx_t this = (s->a.term * s->l.base - s->a.base * s->l.term) /
+		(s->l.base - s->a.base);
+	qx_t pnl = this - s->accpnl;
+
+	/* keep state */
+	s->accpnl = this;
+	return pnl;
+}
+
+static inline qx_t
+calc_rcom(struct sum_s *s)
+{
+	qx_t this = (s->a.comm * s->l.base - s->a.base * s->l.comm) /
+		(s->l.base - s->a.base);
+	qx_t com = this - s->acccom;
+
+	/* keep state */
+	s->acccom = this;
+	return com;
+}
+
+static inline qx_t
+calc_rspr(struct sum_s *s)
+{
+	qx_t this = (s->a.sprd * s->l.base - s->a.base * s->l.sprd) /
+		(s->l.base - s->a.base);
+	qx_t spr = this - s->accspr;
+
+	/* keep state */
+	s->accspr = this;
+	return spr;
+}
+
+static void
+sum_step(struct sum_s *s, tv_t amtr)
+{
+	const tv_t tdif = amtr - s->alst;
+	const qx_t x = !s->edgp ? s->a.base : s->a.base - s->l.base;
+	const size_t side = (x != 0.dd) + (x < 0.dd);
+	const size_t olsd = s->olsd;
+
+	s->tagg[olsd] += tdif;
+
+	CNTS(olsd, side)++;
+	/* check for winners */
+	with (qx_t r = calc_rpnl(s)) {
+		r += calc_rcom(s);
+		r += calc_rspr(s);
+		s->rpnl[olsd] += r;
+		s->best[olsd] = s->best[olsd] >= r ? s->best[olsd] : r;
+		s->wrst[olsd] = s->wrst[olsd] <= r ? s->wrst[olsd] : r;
+		/* hits only metrics */
+		s->rp[olsd] += r > 0.dd ? r : 0.dd;
+		WINS(olsd, side) += r > 0.dd;
+	}
+
+	s->olsd = side;
+	s->l = s->a;
+	s->alst = amtr;
+	return;
+}
+
+void
+sum_init(struct sum_s *s)
+{
+	const unsigned int edgp = s->edgp;
+	const unsigned int grossp = s->grossp;
+
+	memset(s, 0, sizeof(*s));
+	s->edgp = edgp;
+	s->grossp = grossp;
+	s->a.base = s->a.term = s->a.comm = s->a.sprd = 0.dd;
+	s->l = s->a;
+	s->accpnl = s->acccom = s->accspr = 0.dd;
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		s->rpnl[i] = 0.dd;
+		s->rp[i] = 0.dd;
+	}
+	memset(s->best, -1, sizeof(s->best));
+	memset(s->wrst, -1, sizeof(s->wrst));
+	return;
+}
+
+void
+sum_push_exe(struct sum_s *s, exe_t x)
+{
+	if (s->grossp > 1U && LIKELY(!isnanpx(x.p))) {
+		s->a.sprd += fabsqx(x.q) * ((qx_t)x.s / 2.dd);
+	}
+	return;
+}
+
+void
+sum_push_acc(struct sum_s *s, tv_t t, acc_t a)
+{
+	if (s->l.base == a.base) {
+		/* nothing changed */
+		return;
+	}
+	s->a.base = a.base;
+	s->a.term = a.term;
+	s->a.comm = !s->grossp ? a.comb + a.comt : 0.dd;
+
+	if (!s->nacc++) {
+		s->alst = t;
+	}
+	sum_step(s, t);
+	return;
+}
+
+void
+sum_fini(struct sum_s *s)
+{
+	if (UNLIKELY(!s->nacc)) {
+		/* run the summary once for the empty account */
+		s->alst = NATV;
+		sum_step(s, NATV);
+	}
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		s->hits[i] = 0U;
+		s->cagg[i] = 0U;
+
+		/* count wins and states */
+		for (size_t j = 0U; j < countof(sstr); j++) {
+			s->hits[i] += WINS(i, j);
+		}
+		for (size_t j = 0U; j < countof(sstr); j++) {
+			s->cagg[i] += CNTS(j, i);
+		}
+	}
+	return;
+}
+
+void
+sum_merge(struct sum_s *restrict s, const struct sum_s *o)
+{
+	s->nacc += o->nacc;
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		s->tagg[i] += o->tagg[i];
+		s->rpnl[i] += o->rpnl[i];
+		s->rp[i] += o->rp[i];
+		/* best and worst are nan until there's a step */
+		s->best[i] = isnanqx(o->best[i]) || s->best[i] >= o->best[i]
+			? s->best[i] : o->best[i];
+		s->wrst[i] = isnanqx(o->wrst[i]) || s->wrst[i] <= o->wrst[i]
+			? s->wrst[i] : o->wrst[i];
+	}
+	for (size_t i = 0U; i < countof(s->cnts); i++) {
+		s->wins[i] += o->wins[i];
+		s->cnts[i] += o->cnts[i];
+	}
+	return;
+}
+
+void
+sum_prnt_matrix(const struct sum_s *s)
+{
+	char buf[256U];
+	size_t len;
+
+	/* overview */
+	fputs("\thits\tcount\ttime\n", stdout);
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		len = 0U;
+		buf[len++] = sstr[i];
+		buf[len++] = '\t';
+		len += snprintf(buf + len, sizeof(buf) - len, "%zu", s->hits[i]);
+		buf[len++] = '\t';
+		len += snprintf(buf + len, sizeof(buf) - len, "%zu", s->cagg[i]);
+		buf[len++] = '\t';
+		len += tvtostr(buf + len, sizeof(buf) - len, s->tagg[i]);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* single trades */
+	fputs("\n\tavg\tbest\tworst\n", stdout);
+	for (size_t i = 1U; i < countof(sstr); i++) {
+		qx_t avg = quantized64(
+			s->rpnl[i] / (qx_t)s->cagg[i], s->l.term);
+		qx_t B = quantized64(s->best[i], s->l.term);
+		qx_t W = quantized64(s->wrst[i], s->l.term);
+
+		len = 0U;
+		buf[len++] = sstr[i];
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, avg);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, B);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, W);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+	len = memncpy(buf, "L+S\t", 4U);
+	with (qx_t avg = 0.dd, B, W) {
+		size_t cnt = 0U;
+		for (size_t i = 1U; i < countof(sstr); i++) {
+			avg += s->rpnl[i];
+			cnt += s->cagg[i];
+		}
+		avg = quantized64(avg / (qx_t)cnt, s->l.term);
+
+		B = s->best[1U];
+		W = s->wrst[1U];
+		for (size_t i = 2U; i < countof(sstr); i++) {
+			B = s->best[i] > B ? s->best[i] : B;
+			W = s->wrst[i] < W ? s->wrst[i] : W;
+		}
+		B = quantized64(B, s->l.term);
+		W = quantized64(W, s->l.term);
+
+		len += qxtostr(buf + len, sizeof(buf) - len, avg);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, B);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, W);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* single trades skewed averages */
+	fputs("\n\thit-r\thit-sk\tloss-sk\n", stdout);
+	for (size_t i = 1U; i < countof(sstr); i++) {
+		double r = (double)s->hits[i] / (double)s->cagg[i];
+		qx_t P = quantized64(s->rp[i] / (qx_t)s->hits[i], s->l.term);
+		qx_t L = quantized64(
+			(s->rpnl[i] - s->rp[i]) /
+			(qx_t)(s->cagg[i] - s->hits[i]), s->l.term);
+
+		len = 0U;
+		buf[len++] = sstr[i];
+		buf[len++] = '\t';
+		len += dtostr4(buf + len, sizeof(buf) - len, r);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, P);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, L);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+	len = memncpy(buf, "L+S\t", 4U);
+	with (qx_t tot = 0.dd, P = 0.dd, L = 0.dd) {
+		double r;
+		size_t hnt = 0U, cnt = 0U;
+		for (size_t i = 1U; i < countof(sstr); i++) {
+			hnt += s->hits[i];
+			cnt += s->cagg[i];
+			P += s->rp[i];
+			tot += s->rpnl[i];
+		}
+		r = (double)hnt / cnt;
+		L = quantized64((tot - P) / (qx_t)(cnt - hnt), s->l.term);
+		P = quantized64(P / (qx_t)hnt, s->l.term);
+
+		len += dtostr4(buf + len, sizeof(buf) - len, r);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, P);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, L);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* rpnl */
+	fputs("\n\trpnl\trp\trl\n", stdout);
+	for (size_t i = 1U; i < countof(sstr); i++) {
+		qx_t r = quantized64(s->rpnl[i], s->l.term);
+		qx_t P = quantized64(s->rp[i], s->l.term);
+		qx_t L = r - P;
+
+		len = 0U;
+		buf[len++] = sstr[i];
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, r);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, P);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, L);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+	len = memncpy(buf, "L+S\t", 4U);
+	with (qx_t tot = 0.dd, P = 0.dd, L = 0.dd) {
+		for (size_t i = 1U; i < countof(sstr); i++) {
+			tot += s->rpnl[i];
+		}
+		tot = quantized64(tot, s->l.term);
+
+		for (size_t i = 1U; i < countof(sstr); i++) {
+			P += s->rp[i];
+		}
+		P = quantized64(P, s->l.term);
+		L = tot - P;
+
+		len += qxtostr(buf + len, sizeof(buf) - len, tot);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, P);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, L);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* transitions */
+	len = 0U;
+	buf[len++] = '\n';
+	len += memncpy(buf + len, "count", 5U);
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		buf[len++] = '\t';
+		buf[len++] = sstr[i];
+		len += memncpy(buf + len, "new", 3U);
+	}
+	buf[len++] = '\n';
+	fwrite(buf, 1, len, stdout);
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		len = 0U;
+		buf[len++] = sstr[i];
+		len += memncpy(buf + len, "old", 3U);
+		for (size_t j = 0U; j < countof(sstr); j++) {
+			const size_t v = CNTS(i, j);
+			buf[len++] = '\t';
+			len += snprintf(buf + len, sizeof(buf) - len, "%zu", v);
+		}
+		buf[len++] = '\n';
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* hits */
+	len = 0U;
+	buf[len++] = '\n';
+	len += memncpy(buf + len, "hits", 4U);
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		buf[len++] = '\t';
+		buf[len++] = sstr[i];
+		len += memncpy(buf + len, "new", 3U);
+	}
+	buf[len++] = '\n';
+	fwrite(buf, 1, len, stdout);
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		len = 0U;
+		buf[len++] = sstr[i];
+		len += memncpy(buf + len, "old", 3U);
+		for (size_t j = 0U; j < countof(sstr); j++) {
+			const size_t v = WINS(i, j);
+			buf[len++] = '\t';
+			len += snprintf(buf + len, sizeof(buf) - len, "%zu", v);
+		}
+		buf[len++] = '\n';
+		fwrite(buf, 1, len, stdout);
+	}
+	return;
+}
+
+void
+sum_prnt_expla(void)
+{
+	/* print an explanation */
+	static const char x[] = "\
+\f\n\
+Legend:\n\
+F\tflat\n\
+L\tlong\n\
+S\tshort\n\
+L+S\tlong and short together\n\
+Xold\tX was the old position\n\
+Xnew\tX is the new position\n\
+\n\
+hits\ta position that, when left, turned out to be profitable\n\
+count\tthe number of positions entered, profitable or not\n\
+time\ttotal time spent in the designated position\n\
+\n\
+avg\taverage profit/loss per position\n\
+best\tbest position\n\
+worst\tworst position\n\
+\n\
+hit-r\thit rate, ratio of hits versus count\n\
+hit-sk\taverage profit on a hit\n\
+loss-sk\taverage loss on a non-hit\n\
+\n\
+rpnl\trealised profit or loss\n\
+rp\trealised profit\n\
+rl\trealised loss\n\
+";
+
+	fwrite(x, sizeof(*x), countof(x), stdout);
+	return;
+}
+
+void
+sum_prnt_table(const struct sum_s *s)
+{
+	char buf[512U];
+	size_t len;
+
+	/* overview */
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		len = 0U;
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "hits", 4U);
+		buf[len++] = '\t';
+		len += snprintf(buf + len, sizeof(buf) - len, "%zu", s->hits[i]);
+		buf[len++] = '\n';
+
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "count", 5U);
+		buf[len++] = '\t';
+		len += snprintf(buf + len, sizeof(buf) - len, "%zu", s->cagg[i]);
+		buf[len++] = '\n';
+
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "time", 4U);
+		buf[len++] = '\t';
+		len += tvtostr(buf + len, sizeof(buf) - len, s->tagg[i]);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* single trades */
+	for (size_t i = 1U; i < countof(sstr); i++) {
+		qx_t avg = quantized64(
+			s->rpnl[i] / (qx_t)s->cagg[i], s->l.term);
+		qx_t B = quantized64(s->best[i], s->l.term);
+		qx_t W = quantized64(s->wrst[i], s->l.term);
+
+		len = 0U;
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "avg", 3U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, avg);
+		buf[len++] = '\n';
+
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "best", 4U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, B);
+		buf[len++] = '\n';
+
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "worst", 5U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, W);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+	with (qx_t avg = 0.dd, B, W) {
+		size_t cnt = 0U;
+		for (size_t i = 1U; i < countof(sstr); i++) {
+			avg += s->rpnl[i];
+			cnt += s->cagg[i];
+		}
+		avg = quantized64(avg / (qx_t)cnt, s->l.term);
+
+		B = s->best[1U];
+		W = s->wrst[1U];
+		for (size_t i = 2U; i < countof(sstr); i++) {
+			B = s->best[i] > B ? s->best[i] : B;
+			W = s->wrst[i] < W ? s->wrst[i] : W;
+		}
+		B = quantized64(B, s->l.term);
+		W = quantized64(W, s->l.term);
+
+		len = 0U;
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "avg", 3U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, avg);
+		buf[len++] = '\n';
+
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "best", 4U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, B);
+		buf[len++] = '\n';
+
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "worst", 5U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, W);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* single trades skewed averages */
+	for (size_t i = 1U; i < countof(sstr); i++) {
+		double r = (double)s->hits[i] / (double)s->cagg[i];
+		qx_t P = quantized64(s->rp[i] / (qx_t)s->hits[i], s->l.term);
+		qx_t L = quantized64(
+			(s->rpnl[i] - s->rp[i]) /
+			(qx_t)(s->cagg[i] - s->hits[i]), s->l.term);
+
+		len = 0U;
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "hit-r", 5U);
+		buf[len++] = '\t';
+		len += dtostr4(buf + len, sizeof(buf) - len, r);
+		buf[len++] = '\n';
+
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "hit-sk", 6U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, P);
+		buf[len++] = '\n';
+
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "loss-sk", 7U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, L);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+	with (qx_t tot = 0.dd, P = 0.dd, L = 0.dd) {
+		double r;
+		size_t hnt = 0U, cnt = 0U;
+		for (size_t i = 1U; i < countof(sstr); i++) {
+			hnt += s->hits[i];
+			cnt += s->cagg[i];
+			P += s->rp[i];
+			tot += s->rpnl[i];
+		}
+		r = (double)hnt / cnt;
+		L = quantized64((tot - P) / (qx_t)(cnt - hnt), s->l.term);
+		P = quantized64(P / (qx_t)hnt, s->l.term);
+
+		len = 0U;
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "hit-r", 5U);
+		buf[len++] = '\t';
+		len += dtostr4(buf + len, sizeof(buf) - len, r);
+		buf[len++] = '\n';
+
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "hit-sk", 6U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, P);
+		buf[len++] = '\n';
+
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "loss-sk", 7U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, L);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* rpnl */
+	for (size_t i = 1U; i < countof(sstr); i++) {
+		qx_t r = quantized64(s->rpnl[i], s->l.term);
+		qx_t P = quantized64(s->rp[i], s->l.term);
+		qx_t L = r - P;
+
+		len = 0U;
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "rpnl", 4U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, r);
+		buf[len++] = '\n';
+
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "rp", 2U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, P);
+		buf[len++] = '\n';
+
+		buf[len++] = sstr[i];
+		buf[len++] = '_';
+		len += memncpy(buf + len, "rl", 2U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, L);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+	with (qx_t tot = 0.dd, P = 0.dd, L = 0.dd) {
+		for (size_t i = 1U; i < countof(sstr); i++) {
+			tot += s->rpnl[i];
+		}
+		tot = quantized64(tot, s->l.term);
+
+		for (size_t i = 1U; i < countof(sstr); i++) {
+			P += s->rp[i];
+		}
+		P = quantized64(P, s->l.term);
+		L = tot - P;
+
+		len = 0U;
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "rpnl", 4U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, tot);
+		buf[len++] = '\n';
+
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "rp", 2U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, P);
+		buf[len++] = '\n';
+
+		len += memncpy(buf + len, "L+S_", 4U);
+		len += memncpy(buf + len, "rl", 2U);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, L);
+		buf[len++] = '\n';
+
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* transitions */
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		len = 0U;
+		for (size_t j = 0U; j < countof(sstr); j++) {
+			const size_t v = CNTS(i, j);
+
+			len += memncpy(buf + len, "count_", 6U);
+			buf[len++] = sstr[i];
+			len += memncpy(buf + len, "old_", 4U);
+			buf[len++] = sstr[j];
+			len += memncpy(buf + len, "new", 3U);
+			buf[len++] = '\t';
+			len += snprintf(buf + len, sizeof(buf) - len, "%zu", v);
+			buf[len++] = '\n';
+		}
+		fwrite(buf, 1, len, stdout);
+	}
+
+	/* hits */
+	for (size_t i = 0U; i < countof(sstr); i++) {
+		len = 0U;
+		for (size_t j = 0U; j < countof(sstr); j++) {
+			const size_t v = WINS(i, j);
+
+			len += memncpy(buf + len, "hits_", 5U);
+			buf[len++] = sstr[i];
+			len += memncpy(buf + len, "old_", 4U);
+			buf[len++] = sstr[j];
+			len += memncpy(buf + len, "new", 3U);
+			buf[len++] = '\t';
+			len += snprintf(buf + len, sizeof(buf) - len, "%zu", v);
+			buf[len++] = '\n';
+		}
+		fwrite(buf, 1, len, stdout);
+	}
+	return;
+}
+
+
+
+/* bt.c ends here */
@@ -0,0 +1,276 @@
+/*** bt.h -- backtest engine
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_bt_h_
+#define INCLUDED_bt_h_
+#include <stdio.h>
+#include <stdint.h>
+#include "tv.h"
+#include "px.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/**
+ * Quotes, top-level bid and ask. */
+typedef struct {
+	tv_t t;
+	px_t b;
+	px_t a;
+} quo_t;
+
+/**
+ * Executions, rejected ones carry a NAN price. */
+typedef struct {
+	tv_t t;
+	px_t p;
+	qx_t q;
+	/* spread at the time */
+	px_t s;
+	/* quote age */
+	tv_t g;
+} exe_t;
+
+/**
+ * Accounts, as maintained by the simulator. */
+typedef struct {
+	qx_t base;
+	qx_t term;
+	qx_t comb;
+	qx_t comt;
+} acc_t;
+
+/**
+ * Regimes, chosen so that transitions work, i.e.
+ * LONG ^ CLOSE -> SHORT  SHORT ^ CLOSE -> LONG */
+typedef enum {
+	RGM_UNK = 0b0000U,
+	RGM_LONG = 0b0001U,
+	RGM_SHORT = 0b0010U,
+	RGM_CANCEL = 0b0011U,
+	RGM_TIMEOUT = 0b0100U,
+	RGM_LONGRVRS = 0b0101U,
+	RGM_SHORTRVRS = 0b0110U,
+	/* make this one coincide with RGM_CANCEL in the LSBs */
+	RGM_EMERGCLOSE = 0b111U,
+} rgm_t;
+
+/**
+ * Orders. */
+typedef struct {
+	tv_t t;
+	rgm_t r;
+	tv_t gtd;
+	qx_t q;
+	px_t lp;
+	px_t tp;
+	px_t sl;
+	/* number of rejected executions */
+	unsigned int nr;
+} ord_t;
+
+/**
+ * Evaluations. */
+typedef struct {
+	/* timestamp of valuation */
+	tv_t t;
+	/* valuation in terms */
+	qx_t nlv;
+	/* commission route-through */
+	qx_t comm;
+} eva_t;
+
+
+/**
+ * Execution simulator, orders in, executions and accounts out. */
+struct sex_s {
+	tv_t exe_age;
+	qx_t qty;
+	px_t comb;
+	px_t comt;
+	unsigned int absq;
+	unsigned int maxq;
+	tv_t rtry;
+	/* instrument to filter quotes and orders for, as returned by
+	 * sex_conx(), or 0 for all */
+	uint32_t conx;
+
+	/* sinks, QUO is called for every quote as it becomes current,
+	 * FILL for every execution (or rejection) along with the
+	 * account after allocation */
+	void(*quo)(void *clo, quo_t);
+	void(*fill)(void *clo, exe_t, acc_t);
+	void *clo;
+
+	/* state */
+	quo_t q;
+	acc_t acc;
+	/* order queue, pending orders are OQ[IOQ..NOQ) */
+	ord_t *oq;
+	size_t ioq;
+	size_t noq;
+	size_t zoq;
+};
+
+/**
+ * Set up the state of simulator S, no quote is known yet. */
+extern void sex_init(struct sex_s*);
+/**
+ * Close the open position at the last known quote and free S's state. */
+extern void sex_fini(struct sex_s*);
+/**
+ * Queue order O, placed at O.T.
+ * The execution delay and the retry horizon are applied here. */
+extern void sex_push_ord(struct sex_s*, ord_t o);
+/**
+ * Try the queued orders placed before Q against the current quote,
+ * then make Q the current quote. */
+extern void sex_push_quo(struct sex_s*, quo_t q);
+/**
+ * Return the filter value for instrument INS of size INZ, see CONX. */
+extern uint32_t sex_conx(const char *ins, size_t inz);
+
+/**
+ * Simulate orders from OFP against quotes in QFP.
+ * Both streams are read through their descriptors, so nothing must
+ * have been read from them through stdio before. */
+extern int sex_offline(struct sex_s*, FILE *qfp, FILE *ofp);
+
+
+/**
+ * Continuous evaluator, accounts and quotes in, evaluations out.
+ * Any number of accounts can be evaluated against the one quote
+ * stream, they are identified by their index and kept in
+ * struct-of-arrays form.
+ * The state (everything after CLO) must be zero-initialised. */
+struct eva_s {
+	tv_t intv;
+	void(*eva)(void *clo, size_t acc, eva_t);
+	void *clo;
+
+	/* state */
+	tv_t nexv;
+	quo_t q;
+	/* number of accounts, allocated accounts, non-flat accounts */
+	size_t nacc;
+	size_t zacc;
+	size_t nact;
+	qx_t *base;
+	qx_t *term;
+	qx_t *comm;
+	qx_t *nlv;
+};
+
+extern eva_t eva_acc(tv_t t, acc_t a, quo_t q);
+extern void eva_push_quo(struct eva_s*, quo_t);
+extern void eva_push_acc(struct eva_s*, size_t acc, tv_t, acc_t);
+extern void eva_fini(struct eva_s*);
+
+
+/**
+ * Account summariser, accounts in, statistics out.
+ * Must be initialised with sum_init(). */
+struct sum_s {
+	unsigned int edgp;
+	unsigned int grossp;
+
+	/* state */
+	size_t nacc;
+	tv_t alst;
+	size_t olsd;
+	struct {
+		qx_t base;
+		/* terms account gross */
+		qx_t term;
+		/* terms account commissions */
+		qx_t comm;
+		/* terms account spread *gains* */
+		qx_t sprd;
+	} a, l;
+	qx_t accpnl;
+	qx_t acccom;
+	qx_t accspr;
+
+	/* stats per side, flat, long, short */
+	tv_t tagg[3U];
+	qx_t rpnl[3U];
+	qx_t rp[3U];
+	qx_t best[3U];
+	qx_t wrst[3U];
+	/* higher valence metrics */
+	size_t wins[3U * 3U];
+	size_t cnts[3U * 3U];
+	size_t hits[3U];
+	size_t cagg[3U];
+};
+
+extern void sum_init(struct sum_s*);
+extern void sum_fini(struct sum_s*);
+/**
+ * Account for the spread gains of execution X (only with grossp > 1). */
+extern void sum_push_exe(struct sum_s*, exe_t x);
+/**
+ * Account for accounts A at time T. */
+extern void sum_push_acc(struct sum_s*, tv_t t, acc_t a);
+/**
+ * Merge the statistics of the unfinished summary O into S.
+ * Both must stem from independent account streams with the same
+ * settings, S's position in its stream is kept as is. */
+extern void sum_merge(struct sum_s*, const struct sum_s *o);
+
+extern void sum_prnt_matrix(const struct sum_s*);
+extern void sum_prnt_table(const struct sum_s*);
+extern void sum_prnt_expla(void);
+
+
+/**
+ * Serialisers, return the number of bytes written to BUF. */
+extern size_t
+exetostr(char *buf, size_t bsz,
+	 const char *cont, size_t conz, exe_t x);
+extern size_t
+acctostr(char *buf, size_t bsz,
+	 const char *cont, size_t conz, tv_t t, acc_t a);
+extern size_t
+evatostr(char *buf, size_t bsz,
+	 const char *cont, size_t conz, eva_t v);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_bt_h_ */
@@ -0,0 +1,197 @@
+/*** cal.c -- UTC calendar boundaries
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <string.h>
+#include "cal.h"
+#include "tv.h"
+#include "nifty.h"
+
+#define DAYS	(86400ULL * NSECS)
+
+/* month boundaries, MBND[I] is the start of month I % 12 in year
+ * 1970 + I / 12, as many years as tv_t can hold, later months are NATV */
+static tv_t mbnd[(2555U - 1970U) * 12U];
+/* number of boundaries computed so far */
+static size_t nmbnd;
+
+
+static tv_t
+mon_start(size_t i)
+{
+/* days since the epoch of the first of month I, Hinnant's algorithm
+ * for the proleptic Gregorian calendar, years >= 1970 only */
+	const unsigned int m = i % 12U + 1U;
+	const unsigned int y = 1970U + i / 12U - (m <= 2U);
+	const unsigned int era = y / 400U;
+	const unsigned int yoe = y - era * 400U;
+	const unsigned int doy = (153U * (m > 2U ? m - 3U : m + 9U) + 2U) / 5U;
+	const unsigned int doe = yoe * 365U + yoe / 4U - yoe / 100U + doy;
+	const tv_t d = era * 146097ULL + doe - 719468ULL;
+
+	return d < NATV / DAYS ? d * DAYS : NATV;
+}
+
+static void
+fill_mon(size_t i)
+{
+/* compute boundaries up to month I, in whole years */
+	i = i < countof(mbnd) ? i : countof(mbnd) - 1U;
+	for (; nmbnd <= i; nmbnd++) {
+		mbnd[nmbnd] = mon_start(nmbnd);
+	}
+	for (; nmbnd % 12U; nmbnd++) {
+		mbnd[nmbnd] = mon_start(nmbnd);
+	}
+	return;
+}
+
+static size_t
+find_mon(tv_t t)
+{
+/* return the index of the month T falls in */
+	size_t lo = 0U, hi;
+
+	while (!nmbnd || mbnd[nmbnd - 1U] <= t) {
+		if (UNLIKELY(nmbnd >= countof(mbnd))) {
+			return countof(mbnd) - 1U;
+		}
+		fill_mon(nmbnd);
+	}
+	/* find the last boundary <= T in [LO, HI) */
+	for (hi = nmbnd; hi - lo > 1U;) {
+		const size_t m = (lo + hi) / 2U;
+
+		if (mbnd[m] <= t) {
+			lo = m;
+		} else {
+			hi = m;
+		}
+	}
+	return lo;
+}
+
+static size_t
+ui2str0(char *restrict buf, unsigned int x, size_t w)
+{
+/* print X zero-padded to W digits */
+	for (size_t i = w; i > 0U; x /= 10U) {
+		buf[--i] = (x % 10U) ^ '0';
+	}
+	return w;
+}
+
+
+tv_t
+cal_next(tv_t t, tvu_t iv)
+{
+	size_t m;
+
+	switch (iv.u) {
+	default:
+	case UNIT_NONE:
+		return NATV;
+	case UNIT_NSECS:
+		return (t / iv.t + 1U) * iv.t;
+	case UNIT_SECS:
+		return (t / NSECS / iv.t + 1U) * iv.t * NSECS;
+	case UNIT_DAYS:
+		return (t / DAYS + iv.t) * DAYS;
+	case UNIT_MONTHS:
+		m = find_mon(t) + iv.t;
+		break;
+	case UNIT_YEARS:
+		m = (find_mon(t) / 12U + iv.t) * 12U;
+		break;
+	}
+	if (UNLIKELY(m >= countof(mbnd))) {
+		return NATV;
+	}
+	fill_mon(m);
+	return mbnd[m];
+}
+
+void
+cal_fill(tv_t t)
+{
+	(void)find_mon(t);
+	return;
+}
+
+ssize_t
+tvutostr(char *restrict buf, size_t bsz, tvu_t t)
+{
+	size_t len = 0U;
+	size_t m;
+
+	switch (t.u) {
+	default:
+	case UNIT_NONE:
+		memcpy(buf, "ALL", 3U);
+		return 3U;
+	case UNIT_SECS:
+		return tvtostr(buf, bsz, t.t);
+	case UNIT_DAYS:
+	case UNIT_MONTHS:
+	case UNIT_YEARS:
+		break;
+	}
+
+	if (UNLIKELY(bsz < 10U)) {
+		return 0U;
+	}
+	/* T is the end of the candle, its last full second names it */
+	t.t = (t.t / NSECS - 1U) * NSECS;
+	m = find_mon(t.t);
+
+	len += ui2str0(buf + len, 1970U + m / 12U, 4U);
+	if (t.u == UNIT_YEARS) {
+		return len;
+	}
+	buf[len++] = '-';
+	len += ui2str0(buf + len, m % 12U + 1U, 2U);
+	if (t.u == UNIT_MONTHS) {
+		return len;
+	}
+	buf[len++] = '-';
+	len += ui2str0(buf + len, (t.t - mbnd[m]) / DAYS + 1U, 2U);
+	return len;
+}
+
+/* cal.c ends here */
@@ -0,0 +1,69 @@
+/*** cal.h -- UTC calendar boundaries
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_cal_h_
+#define INCLUDED_cal_h_
+#include <unistd.h>
+#include "tv.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/**
+ * Return the candle boundary after T for interval IV.
+ * Seconds and nanoseconds are aligned to multiples of IV; days, months
+ * and years start at the UTC day, month or year T falls in and advance
+ * by IV units from there.  NATV if IV is no interval at all. */
+extern tv_t cal_next(tv_t t, tvu_t iv);
+
+/**
+ * Make sure the table of month boundaries covers T.
+ * The table is extended lazily by cal_next() and tvutostr() which is
+ * not safe with several threads, call this before starting them. */
+extern void cal_fill(tv_t t);
+
+/**
+ * Print the candle ending at T.T in the format of unit T.U, that is
+ * the whole timestamp for seconds or the UTC date for days, months and
+ * years, YYYY-MM-DD, YYYY-MM and YYYY respectively. */
+extern ssize_t tvutostr(char *buf, size_t bsz, tvu_t t);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_cal_h_ */
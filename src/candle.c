@@ -12,6 +12,7 @@
 #include <sys/socket.h>
 #include <fcntl.h>
 #include <sys/time.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <assert.h>
 #if defined HAVE_DFP754_H
@@ -20,29 +21,23 @@
 #include "dfp754_d32.h"
 #include "dfp754_d64.h"
 #include "tv.h"
+#include "cal.h"
+#include "cnd.h"
 #include "nifty.h"
 
-typedef _Decimal32 px_t;
-typedef _Decimal64 qx_t;
 #define strtopx		strtod32
 #define pxtostr		d32tostr
 #define strtoqx		strtod64
 #define qxtostr		d64tostr
+#define NANQX		NAND64
 
-/* relevant tick dimensions */
-typedef struct {
-	px_t b;
-	px_t a;
-} quo_t;
+static struct cnd_s cnd = {
+	.nintv = 1U,
+};
+/* intervals as specified on the command line */
+static const char *intn[CND_MAX_INTV];
 
-typedef struct {
-	qx_t b;
-	qx_t a;
-} qty_t;
 
-static tvu_t intv;
-
-
 static __attribute__((format(printf, 1, 2))) void
 serror(const char *fmt, ...)
 {
@@ -59,310 +54,245 @@ serror(const char *fmt, ...)
 	return;
 }
 
-static inline __attribute__((pure, const)) tv_t
-min_tv(tv_t t1, tv_t t2)
-{
-	return t1 <= t2 ? t1 : t2;
-}
-
-static inline __attribute__((pure, const)) tv_t
-max_tv(tv_t t1, tv_t t2)
-{
-	return t1 >= t2 ? t1 : t2;
-}
-
-static inline __attribute__((pure, const)) px_t
-min_px(px_t p1, px_t p2)
-{
-	return p1 <= p2 ? p1 : p2;
-}
-
-static inline __attribute__((pure, const)) px_t
-max_px(px_t p1, px_t p2)
-{
-	return p1 >= p2 ? p1 : p2;
-}
-
-static inline __attribute__((pure, const)) qx_t
-min_qx(qx_t q1, qx_t q2)
-{
-	return q1 <= q2 ? q1 : q2;
-}
-
-static inline __attribute__((pure, const)) qx_t
-max_qx(qx_t q1, qx_t q2)
-{
-	return q1 >= q2 ? q1 : q2;
-}
-
-
-/* next candle time */
-static tv_t nxct;
-
-static px_t minask;
-static px_t maxbid;
-/* only used for draw-up/draw-down */
-static px_t maxask;
-static px_t minbid;
-static px_t minspr;
-static px_t maxspr;
-static px_t maxdu;
-static px_t maxdd;
-static qx_t maxasz = 0.dd;
-static qx_t maxbsz = 0.dd;
-/* buy and sell imbalances */
-static qx_t maxbim = 0.dd;
-static qx_t maxsim = 0.dd;
-static tv_t _1st = NATV;
-static tv_t last;
-static tv_t mindlt = NATV;
-static tv_t maxdlt;
-
-static char cont[64];
-static size_t conz;
-
-static void prnt_cndl(void);
-
-static tv_t
-next_cndl(tv_t t)
-{
-	struct tm *tm;
-	time_t u;
-
-	switch (intv.u) {
-	default:
-	case UNIT_NONE:
-		return NATV;
-	case UNIT_NSECS:
-		return (t / intv.t + 1U) * intv.t;
-	case UNIT_SECS:
-		return (t / NSECS / intv.t + 1U) * intv.t * NSECS;
-	case UNIT_DAYS:
-		t /= 24ULL * 60ULL * 60ULL * NSECS;
-		t++;
-		t *= 24ULL * 60ULL * 60ULL * NSECS;
-		return t;
-	case UNIT_MONTHS:
-	case UNIT_YEARS:
-		break;
-	}
-
-	u = t / NSECS;
-	tm = gmtime(&u);
-	tm->tm_mday = 1;
-	tm->tm_yday = 0;
-	tm->tm_hour = 0;
-	tm->tm_min = 0;
-	tm->tm_sec = 0;
-
-	switch (intv.u) {
-	case UNIT_MONTHS:
-		*tm = (struct tm){
-			.tm_year = tm->tm_year,
-			.tm_mon = tm->tm_mon + 1,
-			.tm_mday = 1,
-		};
-		break;
-	case UNIT_YEARS:
-		*tm = (struct tm){
-			.tm_year = tm->tm_year + 1,
-			.tm_mon = 0,
-			.tm_mday = 1,
-		};
-		break;
-	}
-	return mktime(tm) * NSECS;
-}
+/* candles printed so far */
+static size_t ncndl;
+
+/* on-disk state, in host byte order, followed by NINTV intervals, their
+ * NINTV next candle times and NINTV candles and finally the segment,
+ * ZCNDL and ZHDR are the sizes of a candle and of this header in bytes
+ * so states from a different build or architecture are rejected */
+struct stat_hdr_s {
+	char magic[4U];
+	uint32_t nintv;
+	uint32_t zcndl;
+	uint32_t zhdr;
+	uint64_t offs;
+	uint64_t ncndl;
+	tv_t nxsg;
+};
+
+static const char stat_magic[4U] = {'C', 'N', 'v', '2'};
 
 static int
-push_init(char *ln, size_t UNUSED(lz))
-{
-	size_t iz;
-	char *on;
-
-	/* instrument name, don't hash him */
-	if (UNLIKELY((on = strchr(ln, '\t')) == NULL)) {
-		return -1;
-	}
-	iz = on++ - ln;
-
-	/* snarf quotes */
-	if (!(maxbid = strtopx(on, &on)) || *on++ != '\t' ||
-	    !(minask = strtopx(on, &on)) || (*on != '\t' && *on != '\n')) {
-		return -1;
-	}
-	/* calc initial spread */
-	minspr = maxspr = minask - maxbid;
-
-	/* snarf quantities */
-	if (*on == '\t') {
-		maxbsz = strtoqx(++on, &on);
-		maxasz = strtoqx(++on, &on);
-
-		maxsim = maxbim = maxasz - maxbsz;
-	}
-
-	/* more resetting */
-	maxdd = maxdu = 0.df;
-	/* just so we can kick off max-du and max-dd calcs */
-	minbid = maxbid;
-	maxask = minask;
-
-	mindlt = NATV;
-	maxdlt = 0ULL;
-
-	memcpy(cont, ln, conz = iz);
-	return 0;
-}
-
-static int
-push_beef(char *ln, size_t lz)
+push_beef(char *ln, size_t UNUSED(lz))
 {
 	tv_t t;
-	quo_t q;
-	qty_t Q;
+	px_t b, a;
+	qx_t bq = NANQX, aq = NANQX;
+	const char *ins;
+	size_t iz;
 	char *on;
-	int rc = 0;
 
 	/* metronome is up first */
 	if (UNLIKELY((t = strtotv(ln, &on)) == NATV)) {
 		return -1;
 	} else if (UNLIKELY(*on++ != '\t')) {
 		return -1;
-	} else if (UNLIKELY(t < last)) {
-		fputs("Warning: non-chronological\n", stderr);
-		rc = -1;
-		goto out;
-	} else if (UNLIKELY(t > nxct)) {
-		prnt_cndl();
-		nxct = next_cndl(t);
-		_1st = last = t;
-		return push_init(on, lz - (on - ln));
 	}
 
 	/* instrument name, don't hash him */
-	if (UNLIKELY((on = strchr(on, '\t')) == NULL)) {
+	if (UNLIKELY((on = strchr(ins = on, '\t')) == NULL)) {
 		return -1;
 	}
-	on++;
+	iz = on++ - ins;
 
 	/* snarf quotes */
-	if (!(q.b = strtopx(on, &on)) || *on++ != '\t' ||
-	    !(q.a = strtopx(on, &on)) || (*on != '\t' && *on != '\n')) {
+	if (!(b = strtopx(on, &on)) || *on++ != '\t' ||
+	    !(a = strtopx(on, &on)) || (*on != '\t' && *on != '\n')) {
 		return -1;
 	}
 
 	/* snarf quantities */
-	Q.b = strtoqx(++on, &on);
-	Q.a = strtoqx(++on, &on);
-
-	maxbid = max_px(maxbid, q.b);
-	minask = min_px(minask, q.a);
-	with (px_t s = q.a - q.b) {
-		minspr = min_px(minspr, s);
-		maxspr = max_px(maxspr, s);
-	}
-
-	with (px_t du = q.a - minbid, dd = q.b - maxask) {
-		maxdu = max_px(maxdu, du);
-		maxdd = min_px(maxdd, dd);
-		/* for next round */
-		minbid = min_px(minbid, q.b);
-		maxask = max_px(maxask, q.a);
-	}
-
-	with (tv_t dlt = t - last) {
-		mindlt = min_tv(mindlt, dlt);
-		maxdlt = max_tv(maxdlt, dlt);
+	if (*on == '\t') {
+		bq = strtoqx(++on, &on);
+		aq = strtoqx(++on, &on);
 	}
 
-	maxbsz = max_qx(maxbsz, Q.b);
-	maxasz = max_qx(maxasz, Q.a);
-	with (qx_t imb = Q.a - Q.b) {
-		maxsim = max_qx(maxsim, imb);
-		maxbim = min_qx(maxbim, imb);
+	if (UNLIKELY(cnd_push(&cnd, t, ins, iz, b, a, bq, aq) < 0)) {
+		fputs("Warning: non-chronological\n", stderr);
+		return -1;
 	}
-
-out:
-	/* and store state */
-	last = t;
-	return rc;
+	return 0;
 }
 
 static void
-prnt_cndl(void)
+prnt_cndl(void *UNUSED(clo), size_t i, tv_t end, const struct cndl_s *c)
 {
-	static size_t ncndl;
 	char buf[4096U];
 	size_t len = 0U;
 
-	if (UNLIKELY(_1st == NATV)) {
-		return;
-	}
-
 	switch (ncndl++) {
 	default:
 		break;
 	case 0U:
-		fputs("cndl\tccy\t_1st\tlast\tmindlt\tmaxdlt\tminask\tmaxbid\tminspr\tmaxspr\tmaxbsz\tmaxasz\tmaxbim\tmaxsim\tmaxdu\tmaxdd\n", stdout);
+		fputs("cndl\tccy\t_1st\tlast\tmindlt\tmaxdlt\tminask\tmaxbid\tminspr\tmaxspr\tmaxbsz\tmaxasz\tmaxbim\tmaxsim\tmaxdu\tmaxdd", stdout);
+		if (cnd.nintv > 1U) {
+			fputs("\tintv", stdout);
+		}
+		fputc('\n', stdout);
 		break;
 	}
 
 	/* candle identifier */
-	len = tvutostr(buf, sizeof(buf), (tvu_t){nxct, intv.u});
+	len = tvutostr(buf, sizeof(buf), (tvu_t){end, cnd.intv[i].u});
 
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 
 	buf[len++] = '\t';
-	len += tvtostr(buf + len, sizeof(buf) - len, _1st);
+	len += tvtostr(buf + len, sizeof(buf) - len, c->_1st);
 	buf[len++] = '\t';
-	len += tvtostr(buf + len, sizeof(buf) - len, last);
+	len += tvtostr(buf + len, sizeof(buf) - len, c->last);
 	buf[len++] = '\t';
-	if (mindlt != NATV) {
-		len += tvtostr(buf + len, sizeof(buf) - len, mindlt);
+	if (c->mindlt != NATV) {
+		len += tvtostr(buf + len, sizeof(buf) - len, c->mindlt);
 	}
 	buf[len++] = '\t';
-	if (maxdlt != 0) {
-		len += tvtostr(buf + len, sizeof(buf) - len, maxdlt);
+	if (c->maxdlt != 0) {
+		len += tvtostr(buf + len, sizeof(buf) - len, c->maxdlt);
 	}
 
 	buf[len++] = '\t';
-	len += pxtostr(buf + len, sizeof(buf) - len, minask);
+	len += pxtostr(buf + len, sizeof(buf) - len, c->minask);
 	buf[len++] = '\t';
-	len += pxtostr(buf + len, sizeof(buf) - len, maxbid);
+	len += pxtostr(buf + len, sizeof(buf) - len, c->maxbid);
 	buf[len++] = '\t';
-	len += pxtostr(buf + len, sizeof(buf) - len, minspr);
+	len += pxtostr(buf + len, sizeof(buf) - len, c->minspr);
 	buf[len++] = '\t';
-	len += pxtostr(buf + len, sizeof(buf) - len, maxspr);
+	len += pxtostr(buf + len, sizeof(buf) - len, c->maxspr);
 
 	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, maxbsz);
+	len += qxtostr(buf + len, sizeof(buf) - len, c->maxbsz);
 	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, maxasz);
+	len += qxtostr(buf + len, sizeof(buf) - len, c->maxasz);
 	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, -maxbim);
+	len += qxtostr(buf + len, sizeof(buf) - len, -c->maxbim);
 	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, maxsim);
+	len += qxtostr(buf + len, sizeof(buf) - len, c->maxsim);
 
 	buf[len++] = '\t';
-	len += pxtostr(buf + len, sizeof(buf) - len, maxdu);
+	len += pxtostr(buf + len, sizeof(buf) - len, c->maxdu);
 	buf[len++] = '\t';
-	len += pxtostr(buf + len, sizeof(buf) - len, maxdd);
+	len += pxtostr(buf + len, sizeof(buf) - len, c->maxdd);
+
+	if (cnd.nintv > 1U) {
+		const size_t z = strlen(intn[i]);
+
+		buf[len++] = '\t';
+		len += (memcpy(buf + len, intn[i], z), z);
+	}
 
 	buf[len++] = '\n';
 	fwrite(buf, sizeof(*buf), len, stdout);
 	return;
 }
 
-
+static int
+rdstat(const char *fn, uint64_t *offs)
+{
+/* restore state from FN, no FN means there is nothing to resume */
+	struct stat_hdr_s hdr;
+	tvu_t iv[CND_MAX_INTV];
+	FILE *fp;
+	int rc = 0;
+
+	if ((fp = fopen(fn, "r")) == NULL) {
+		return errno == ENOENT ? 0 : -1;
+	} else if (UNLIKELY(fread(&hdr, sizeof(hdr), 1U, fp) < 1U ||
+			    memcmp(hdr.magic, stat_magic, sizeof(hdr.magic)) ||
+			    hdr.zhdr != sizeof(hdr) ||
+			    hdr.zcndl != sizeof(cnd.seg))) {
+		errno = 0;
+		rc = -1;
+		goto out;
+	} else if (UNLIKELY(hdr.nintv != cnd.nintv ||
+			    fread(iv, sizeof(*iv), cnd.nintv, fp) < cnd.nintv)) {
+		errno = 0;
+		rc = -1;
+		goto out;
+	}
+	for (size_t i = 0U; i < cnd.nintv; i++) {
+		if (UNLIKELY(iv[i].t != cnd.intv[i].t ||
+			     iv[i].u != cnd.intv[i].u)) {
+			/* must be the same intervals to make sense */
+			errno = 0;
+			rc = -1;
+			goto out;
+		}
+	}
+	if (UNLIKELY(fread(cnd.nxct, sizeof(*cnd.nxct), cnd.nintv, fp) < cnd.nintv ||
+		     fread(cnd.cur, sizeof(*cnd.cur), cnd.nintv, fp) < cnd.nintv ||
+		     fread(&cnd.seg, sizeof(cnd.seg), 1U, fp) < 1U)) {
+		errno = 0;
+		rc = -1;
+		goto out;
+	}
+	*offs = hdr.offs;
+	ncndl = hdr.ncndl;
+	cnd.nxsg = hdr.nxsg;
+out:
+	fclose(fp);
+	return rc;
+}
+
+static int
+wrstat(const char *fn, uint64_t offs)
+{
+	struct stat_hdr_s hdr = {
+		.nintv = cnd.nintv, .offs = offs, .ncndl = ncndl, .nxsg = cnd.nxsg,
+		.zcndl = sizeof(cnd.seg), .zhdr = sizeof(hdr),
+	};
+	FILE *fp;
+	int rc = 0;
+
+	if (UNLIKELY((fp = fopen(fn, "w")) == NULL)) {
+		return -1;
+	}
+	memcpy(hdr.magic, stat_magic, sizeof(hdr.magic));
+	if (UNLIKELY(fwrite(&hdr, sizeof(hdr), 1U, fp) < 1U ||
+		     fwrite(cnd.intv, sizeof(*cnd.intv), cnd.nintv, fp) < cnd.nintv ||
+		     fwrite(cnd.nxct, sizeof(*cnd.nxct), cnd.nintv, fp) < cnd.nintv ||
+		     fwrite(cnd.cur, sizeof(*cnd.cur), cnd.nintv, fp) < cnd.nintv ||
+		     fwrite(&cnd.seg, sizeof(cnd.seg), 1U, fp) < 1U)) {
+		rc = -1;
+	}
+	rc = fclose(fp) < 0 ? -1 : rc;
+	return rc;
+}
+
+static int
+skip(uint64_t offs)
+{
+/* position stdin at OFFS, by seeking if possible */
+	struct stat st;
+
+	if (fstat(STDIN_FILENO, &st) < 0 || !S_ISREG(st.st_mode)) {
+		/* read and forget then */
+		char buf[4096U];
+
+		for (size_t nrd; offs > 0U; offs -= nrd) {
+			const size_t z = offs < sizeof(buf) ? offs : sizeof(buf);
+
+			if ((nrd = fread(buf, 1, z, stdin)) < z) {
+				return -1;
+			}
+		}
+		return 0;
+	} else if (UNLIKELY((uint64_t)st.st_size < offs)) {
+		/* file must have been truncated or replaced */
+		return -1;
+	}
+	return lseek(STDIN_FILENO, offs, SEEK_SET) < 0 ? -1 : 0;
+}
+
+
 #include "candle.yucc"
 
 int
 main(int argc, char *argv[])
 {
 	static yuck_t argi[1U];
-
+	uint64_t offs = 0U;
 	int rc = 0;
 
 	if (yuck_parse(argi, argc, argv) < 0) {
@@ -371,15 +301,47 @@ main(int argc, char *argv[])
 	}
 
 	if (argi->interval_arg) {
-		intv = strtotvu(argi->interval_arg, NULL);
-		if (!intv.t) {
-			errno = 0, serror("\
+		char *on = argi->interval_arg;
+
+		cnd.nintv = 0U;
+		for (char *eo; on != NULL; on = eo) {
+			if ((eo = strchr(on, ',')) != NULL) {
+				*eo++ = '\0';
+			}
+			if (UNLIKELY(cnd.nintv >= countof(cnd.intv))) {
+				errno = 0, serror("\
+Error: too many intervals, at most %zu supported.", countof(cnd.intv));
+				rc = 1;
+				goto out;
+			}
+			cnd.intv[cnd.nintv] = strtotvu(on, NULL);
+			if (!cnd.intv[cnd.nintv].t) {
+				errno = 0, serror("\
 Error: cannot read interval argument, must be positive.");
+				rc = 1;
+				goto out;
+			} else if (!cnd.intv[cnd.nintv].u) {
+				errno = 0, serror("\
+Error: unknown suffix in interval argument, must be s, m, h, d, w, mo, y.");
+				rc = 1;
+				goto out;
+			}
+			intn[cnd.nintv++] = on;
+		}
+	}
+	cnd.cndl = prnt_cndl;
+	cnd_init(&cnd);
+
+	if (argi->resume_arg) {
+		if (UNLIKELY(rdstat(argi->resume_arg, &offs) < 0)) {
+			serror("\
+Error: cannot resume from state file `%s'", argi->resume_arg);
 			rc = 1;
 			goto out;
-		} else if (!intv.u) {
+		} else if (UNLIKELY(skip(offs) < 0)) {
 			errno = 0, serror("\
-Error: unknown suffix in interval argument, must be s, m, h, d, w, mo, y.");
+Error: QUOTES is shorter than recorded in state file `%s'",
+					  argi->resume_arg);
 			rc = 1;
 			goto out;
 		}
@@ -391,14 +353,31 @@ Error: unknown suffix in interval argument, must be s, m, h, d, w, mo, y.");
 		ssize_t nrd;
 
 		while ((nrd = getline(&line, &llen, stdin)) > 0) {
+			if (argi->resume_arg && line[nrd - 1] != '\n') {
+				/* line's still being written, leave it */
+				break;
+			}
 			(void)push_beef(line, nrd);
+			offs += nrd;
 		}
 
 		/* finalise our findings */
 		free(line);
+	}
 
-		/* print the final candle */
-		prnt_cndl();
+	if (argi->resume_arg && !argi->flush_flag) {
+		/* unfinished candles go to the state file */
+		if (UNLIKELY(wrstat(argi->resume_arg, offs) < 0)) {
+			serror("\
+Error: cannot write state file `%s'", argi->resume_arg);
+			rc = 1;
+		}
+	} else {
+		/* print the final candles */
+		cnd_fini(&cnd);
+		if (argi->resume_arg) {
+			(void)unlink(argi->resume_arg);
+		}
 	}
 
 out:
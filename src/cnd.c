@@ -0,0 +1,271 @@
+/*** cnd.c -- candle maker
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <string.h>
+#if defined HAVE_DFP754_H
+# include <dfp754.h>
+#endif	/* HAVE_DFP754_H */
+#include "dfp754_d32.h"
+#include "dfp754_d64.h"
+#include "cnd.h"
+#include "cal.h"
+#include "nifty.h"
+
+#define isnanqx		isnand64
+
+
+static inline __attribute__((pure, const)) tv_t
+min_tv(tv_t t1, tv_t t2)
+{
+	return t1 <= t2 ? t1 : t2;
+}
+
+static inline __attribute__((pure, const)) tv_t
+max_tv(tv_t t1, tv_t t2)
+{
+	return t1 >= t2 ? t1 : t2;
+}
+
+static inline __attribute__((pure, const)) px_t
+min_px(px_t p1, px_t p2)
+{
+	return p1 <= p2 ? p1 : p2;
+}
+
+static inline __attribute__((pure, const)) px_t
+max_px(px_t p1, px_t p2)
+{
+	return p1 >= p2 ? p1 : p2;
+}
+
+static inline __attribute__((pure, const)) qx_t
+min_qx(qx_t q1, qx_t q2)
+{
+	return q1 <= q2 ? q1 : q2;
+}
+
+static inline __attribute__((pure, const)) qx_t
+max_qx(qx_t q1, qx_t q2)
+{
+	return q1 >= q2 ? q1 : q2;
+}
+
+
+static void
+merge_cndl(struct cndl_s *restrict c, const struct cndl_s *s)
+{
+/* merge the later candle S into C */
+	if (c->_1st == NATV) {
+		*c = *s;
+		return;
+	}
+
+	/* the gap between C and S counts as tick delta too */
+	with (tv_t dlt = s->_1st - c->last) {
+		c->mindlt = min_tv(c->mindlt, min_tv(s->mindlt, dlt));
+		c->maxdlt = max_tv(c->maxdlt, max_tv(s->maxdlt, dlt));
+	}
+	c->last = s->last;
+
+	c->minask = min_px(c->minask, s->minask);
+	c->maxbid = max_px(c->maxbid, s->maxbid);
+	c->minspr = min_px(c->minspr, s->minspr);
+	c->maxspr = max_px(c->maxspr, s->maxspr);
+
+	/* draw-ups and -downs can also straddle C and S,
+	 * measure S's extremes against everything in C */
+	with (px_t du = s->maxask - c->minbid, dd = s->minbid - c->maxask) {
+		c->maxdu = max_px(max_px(c->maxdu, s->maxdu), du);
+		c->maxdd = min_px(min_px(c->maxdd, s->maxdd), dd);
+	}
+	c->minbid = min_px(c->minbid, s->minbid);
+	c->maxask = max_px(c->maxask, s->maxask);
+
+	c->maxbsz = max_qx(c->maxbsz, s->maxbsz);
+	c->maxasz = max_qx(c->maxasz, s->maxasz);
+	c->maxsim = max_qx(c->maxsim, s->maxsim);
+	c->maxbim = min_qx(c->maxbim, s->maxbim);
+	return;
+}
+
+static void
+push_sgmt(struct cnd_s *s)
+{
+	if (UNLIKELY(s->seg._1st == NATV)) {
+		return;
+	}
+	for (size_t i = 0U; i < s->nintv; i++) {
+		merge_cndl(s->cur + i, &s->seg);
+	}
+	return;
+}
+
+static void
+emit_cndl(struct cnd_s *s, size_t i)
+{
+	if (UNLIKELY(s->cur[i]._1st == NATV)) {
+		return;
+	}
+	s->cndl(s->clo, i, s->nxct[i], s->cur + i);
+	return;
+}
+
+static void
+roll_cndl(struct cnd_s *s, tv_t t)
+{
+/* tick at T is beyond a candle boundary, hand the segment to all
+ * candles and finish off those whose interval T is beyond */
+	push_sgmt(s);
+
+	s->nxsg = NATV;
+	for (size_t i = 0U; i < s->nintv; i++) {
+		if (t > s->nxct[i]) {
+			emit_cndl(s, i);
+			s->cur[i]._1st = NATV;
+			s->nxct[i] = cal_next(t, s->intv[i]);
+		}
+		s->nxsg = min_tv(s->nxsg, s->nxct[i]);
+	}
+	return;
+}
+
+
+void
+cnd_init(struct cnd_s *s)
+{
+	for (size_t i = 0U; i < s->nintv; i++) {
+		s->nxct[i] = 0U;
+		s->cur[i]._1st = NATV;
+	}
+	s->seg = (struct cndl_s){
+		._1st = NATV,
+		.mindlt = NATV,
+		.maxasz = 0.dd,
+		.maxbsz = 0.dd,
+		.maxbim = 0.dd,
+		.maxsim = 0.dd,
+	};
+	s->nxsg = 0U;
+	return;
+}
+
+void
+cnd_fini(struct cnd_s *s)
+{
+	push_sgmt(s);
+	for (size_t i = 0U; i < s->nintv; i++) {
+		emit_cndl(s, i);
+	}
+	return;
+}
+
+int
+cnd_push(struct cnd_s *s, tv_t t, const char *ins, size_t iz,
+	 px_t b, px_t a, qx_t bq, qx_t aq)
+{
+	struct cndl_s *const g = &s->seg;
+
+	if (UNLIKELY(t < g->last)) {
+		g->last = t;
+		return -1;
+	} else if (UNLIKELY(t > s->nxsg)) {
+		roll_cndl(s, t);
+
+		/* start a new segment */
+		g->_1st = g->last = t;
+		g->maxbid = b;
+		g->minask = a;
+		/* calc initial spread */
+		g->minspr = g->maxspr = a - b;
+		if (!isnanqx(bq) && !isnanqx(aq)) {
+			g->maxbsz = bq;
+			g->maxasz = aq;
+			g->maxsim = g->maxbim = aq - bq;
+		}
+		/* more resetting */
+		g->maxdd = g->maxdu = 0.df;
+		/* just so we can kick off max-du and max-dd calcs */
+		g->minbid = b;
+		g->maxask = a;
+
+		g->mindlt = NATV;
+		g->maxdlt = 0ULL;
+
+		iz = iz < sizeof(g->cont) ? iz : sizeof(g->cont);
+		memcpy(g->cont, ins, g->conz = iz);
+		return 0;
+	}
+
+	/* sizes default to naught within a segment */
+	bq = !isnanqx(bq) ? bq : 0.dd;
+	aq = !isnanqx(aq) ? aq : 0.dd;
+
+	g->maxbid = max_px(g->maxbid, b);
+	g->minask = min_px(g->minask, a);
+	with (px_t sp = a - b) {
+		g->minspr = min_px(g->minspr, sp);
+		g->maxspr = max_px(g->maxspr, sp);
+	}
+
+	with (px_t du = a - g->minbid, dd = b - g->maxask) {
+		g->maxdu = max_px(g->maxdu, du);
+		g->maxdd = min_px(g->maxdd, dd);
+		/* for next round */
+		g->minbid = min_px(g->minbid, b);
+		g->maxask = max_px(g->maxask, a);
+	}
+
+	with (tv_t dlt = t - g->last) {
+		g->mindlt = min_tv(g->mindlt, dlt);
+		g->maxdlt = max_tv(g->maxdlt, dlt);
+	}
+
+	g->maxbsz = max_qx(g->maxbsz, bq);
+	g->maxasz = max_qx(g->maxasz, aq);
+	with (qx_t imb = aq - bq) {
+		g->maxsim = max_qx(g->maxsim, imb);
+		g->maxbim = min_qx(g->maxbim, imb);
+	}
+
+	/* and store state */
+	g->last = t;
+	return 0;
+}
+
+/* cnd.c ends here */
@@ -0,0 +1,115 @@
+/*** cnd.h -- candle maker
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_cnd_h_
+#define INCLUDED_cnd_h_
+#include <stddef.h>
+#include "tv.h"
+#include "px.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+#define CND_MAX_INTV	(16U)
+
+/**
+ * Candles, statistics of the quotes within one interval. */
+struct cndl_s {
+	tv_t _1st;
+	tv_t last;
+	tv_t mindlt;
+	tv_t maxdlt;
+	px_t minask;
+	px_t maxbid;
+	/* only used for draw-up/draw-down */
+	px_t maxask;
+	px_t minbid;
+	px_t minspr;
+	px_t maxspr;
+	px_t maxdu;
+	px_t maxdd;
+	qx_t maxasz;
+	qx_t maxbsz;
+	/* buy and sell imbalances */
+	qx_t maxbim;
+	qx_t maxsim;
+	size_t conz;
+	char cont[64];
+};
+
+/**
+ * Candle maker, quotes in, candles for up to CND_MAX_INTV intervals out.
+ * Candles are finished in the order of their intervals.
+ * Must be initialised with cnd_init() after NINTV and INTV are set. */
+struct cnd_s {
+	size_t nintv;
+	tvu_t intv[CND_MAX_INTV];
+	/* sink, called with the interval index and the time the candle
+	 * ends, candles without quotes are skipped */
+	void(*cndl)(void *clo, size_t i, tv_t end, const struct cndl_s*);
+	void *clo;
+
+	/* state */
+	/* next candle times */
+	tv_t nxct[CND_MAX_INTV];
+	/* candles in the making, one per interval */
+	struct cndl_s cur[CND_MAX_INTV];
+	/* ticks since the last candle boundary of any interval,
+	 * these get merged into every candle when the next boundary
+	 * is hit */
+	struct cndl_s seg;
+	/* next boundary of any interval */
+	tv_t nxsg;
+};
+
+extern void cnd_init(struct cnd_s*);
+/**
+ * Hand out the candles still in the making, at the end of the stream. */
+extern void cnd_fini(struct cnd_s*);
+/**
+ * Account for the quote B/A of sizes BQ/AQ on instrument INS at T.
+ * Sizes are NAN if unknown.  Return -1 if T is before the previous
+ * quote, the quote is ignored then. */
+extern int
+cnd_push(struct cnd_s*, tv_t t, const char *ins, size_t iz,
+	 px_t b, px_t a, qx_t bq, qx_t aq);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_cnd_h_ */
@@ -0,0 +1,141 @@
+/*** dbl.c -- fast decimal to double conversion
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "dbl.h"
+#include "nifty.h"
+
+/* powers of ten that are exact in a double */
+static const double tens[] = {
+	1e0d, 1e1d, 1e2d, 1e3d, 1e4d, 1e5d, 1e6d, 1e7d, 1e8d, 1e9d, 1e10d, 1e11d,
+	1e12d, 1e13d, 1e14d, 1e15d, 1e16d, 1e17d, 1e18d, 1e19d, 1e20d, 1e21d, 1e22d,
+};
+
+static inline __attribute__((const)) unsigned int
+digitp(char c)
+{
+	return (unsigned char)(c ^ '0') < 10U;
+}
+
+
+double
+strtodbl(const char *str, char **endptr)
+{
+	const char *sp = str;
+	uint_fast64_t m = 0U;
+	size_t nd = 0U;
+	int e = 0;
+	bool negp;
+	double r;
+
+	/* white space, as in isspace(3) in the C locale */
+	for (; *sp == ' ' || (unsigned char)(*sp - '\t') < 5U; sp++);
+	negp = *sp == '-';
+	sp += *sp == '-' || *sp == '+';
+	if (UNLIKELY(*sp == '0' && (sp[1U] | 0x20) == 'x')) {
+		/* hex floats */
+		goto slow;
+	}
+	/* integral part */
+	for (; digitp(*sp); sp++, nd++) {
+		m = 10U * m + (*sp ^ '0');
+	}
+	if (*sp == '.') {
+		const char *fp = ++sp;
+
+		for (; digitp(*sp); sp++) {
+			m = 10U * m + (*sp ^ '0');
+		}
+		nd += sp - fp;
+		e -= (int)(sp - fp);
+	}
+	if (UNLIKELY(!nd || nd > 19U)) {
+		/* inf, nan, nothing at all, or M might have wrapped */
+		goto slow;
+	}
+	if ((*sp | 0x20) == 'e') {
+		const char *ep = sp + 1U;
+		const bool enegp = *ep == '-';
+		int x = 0;
+
+		ep += *ep == '-' || *ep == '+';
+		/* only an exponent if there's digits */
+		if (digitp(*ep)) {
+			for (; digitp(*ep); ep++) {
+				if (UNLIKELY((x = 10 * x + (*ep ^ '0')) > 9999)) {
+					goto slow;
+				}
+			}
+			sp = ep;
+			e += enegp ? -x : x;
+		}
+	}
+	if (UNLIKELY(m >> 53U)) {
+		/* M isn't exact */
+		goto slow;
+	}
+
+	/* M and 10^|E| are exact, one rounding step is correct */
+	r = (double)m;
+	if (e < 0) {
+		if (UNLIKELY(e < -22)) {
+			goto slow;
+		}
+		r /= tens[-e];
+	} else if (e > 22) {
+		/* move excess powers into M as long as that's exact */
+		if (UNLIKELY(e > 22 + 15 || (r *= tens[e - 22]) >= 0x1p53)) {
+			goto slow;
+		}
+		r *= tens[22];
+	} else {
+		r *= tens[e];
+	}
+	if (endptr != NULL) {
+		*endptr = deconst(sp);
+	}
+	return negp ? -r : r;
+
+slow:
+	return strtod(str, endptr);
+}
+
+/* dbl.c ends here */
@@ -22,50 +22,37 @@
 #include "dfp754_d32.h"
 #include "dfp754_d64.h"
 #include "hash.h"
+#include "hxtbl.h"
 #include "tv.h"
+#include "bt.h"
+#include "aoj.h"
 #include "nifty.h"
 
-typedef _Decimal32 px_t;
-typedef _Decimal64 qx_t;
 #define strtopx		strtod32
-#define pxtostr		d32tostr
 #define strtoqx		strtod64
-#define qxtostr		d64tostr
+#define NANPX		NAND32
 
-/* relevant tick dimensions */
-typedef struct {
-	tv_t t;
-	px_t p;
-} tik_t;
-
-typedef struct {
-	px_t b;
-	px_t a;
-} quo_t;
+static struct eva_s e = {
+	.intv = 10 * MSECS,
+};
+static const char *cont;
+static size_t conz;
+/* number of account files */
+static unsigned int nacf;
 
+/* next account record of each account file */
 typedef struct {
-	qx_t base;
-	qx_t term;
-	qx_t comm;
-} acc_t;
+	size_t i;
+	acc_t a;
+} rec_t;
 
-typedef struct {
-	/* timestamp of valuation */
-	tv_t t;
-	/* valuation in terms */
-	qx_t nlv;
-	/* commission route-through */
-	qx_t comm;
-} eva_t;
-
-static tv_t intv = 10 * MSECS;
-static const char *cont;
-static size_t conz;
+/* accounts, identified by their file and their tag */
+static struct hxtbl_s atbl;
+static size_t zacc;
+static char **tags;
+static size_t *tagz;
 
-static FILE *qfp;
-static FILE *afp;
 
-
 static __attribute__((format(printf, 1, 2))) void
 serror(const char *fmt, ...)
 {
@@ -82,173 +69,140 @@ serror(const char *fmt, ...)
 	return;
 }
 
-static inline __attribute__((pure, const)) tv_t
-min_tv(tv_t t1, tv_t t2)
-{
-	return t1 < t2 ? t1 : t2;
-}
-
-
-static hx_t
-strtohx(const char *x, char **on)
-{
-	char *ep;
-	hx_t res;
-
-	if (UNLIKELY((ep = strchr(x, '\t')) == NULL)) {
-		return 0;
-	}
-	res = hash(x, ep - x);
-	if (LIKELY(on != NULL)) {
-		*on = ep;
-	}
-	return res;
-}
 
-
-static ssize_t
-send_eva(eva_t x)
+static void
+send_eva(void *UNUSED(clo), size_t i, eva_t v)
 {
-/* exe encodes delta to metronome and delay */
-	static const char verb[] = "EVA";
 	char buf[256U];
 	size_t len;
 
-	len = tvtostr(buf, sizeof(buf), x.t);
-	buf[len++] = '\t';
-	len += (memcpy(buf + len, verb, strlenof(verb)), strlenof(verb));
-	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
-	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, x.nlv);
-	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, x.comm);
-	buf[len++] = '\n';
-	return fwrite(buf, 1, len, stdout);
+	len = evatostr(buf, sizeof(buf), tags[i], tagz[i], v);
+	fwrite(buf, 1, len, stdout);
+	return;
 }
 
-static eva_t
-eva(tv_t t, acc_t a, quo_t q)
+static size_t
+find_acc(unsigned int f, const char *tag, size_t tgz)
 {
-	eva_t r = {t, a.term, a.comm};
-
-	if (UNLIKELY(!a.base)) {
-		/* um, right */
-		;
-	} else if (a.base > 0.dd) {
-		/* use bids */
-		r.nlv += a.base * q.b;
-	} else if (a.base < 0.dd) {
-		/* use asks */
-		r.nlv += a.base * q.a;
+/* return the account index of TAG in account file F */
+	/* mix the file in so equal tags in different files differ */
+	const hx_t hx = hash(tag, tgz) ^ (hx_t)f * 0x9e3779b1U;
+	const size_t n = atbl.n;
+	size_t i;
+
+	if ((i = hxtbl_put(&atbl, hx)) < n) {
+		return i;
+	} else if (UNLIKELY(i >= zacc)) {
+		zacc = zacc ? 2U * zacc : 64U;
+		tags = realloc(tags, zacc * sizeof(*tags));
+		tagz = realloc(tagz, zacc * sizeof(*tagz));
+	}
+	/* new account, label it PAIR:FILE:TAG but leave out the pair if
+	 * not given and the file if there's only one */
+	with (char *lbl = malloc(conz + 16U + tgz)) {
+		size_t len = 0U;
+
+		if (cont) {
+			memcpy(lbl, cont, conz);
+			len = conz;
+			lbl[len++] = ':';
+		}
+		if (nacf > 1U) {
+			len += snprintf(lbl + len, 16U, "%u:", f + 1U);
+		}
+		memcpy(lbl + len, tag, tgz);
+		len += tgz;
+		/* no dangling colon without a tag */
+		len -= !tgz && len;
+		lbl[len] = '\0';
+		tags[i] = lbl;
+		tagz[i] = len;
 	}
-	return r;
+	return i;
 }
 
-
-static tv_t nexv = NATV;
-static quo_t q;
-static acc_t a;
-
-static tv_t
-next_quo(void)
+static quo_t
+next_quo(aoj_cur_t *restrict c)
 {
-	static quo_t newq;
-	static char *line;
-	static size_t llen;
-	tv_t newm;
+	quo_t q;
 	char *on;
 
-	/* assign previous next_quo as current quo */
-	q = newq;
-
-	if (UNLIKELY(getline(&line, &llen, qfp) <= 0)) {
-		free(line);
-		return NATV;
+retry:
+	if (UNLIKELY((q.t = aoj_next(c)) == NATV)) {
+		return q;
 	}
-
-	newm = strtotv(line, &on);
 	/* instrument next */
-	on = strchr(++on, '\t');
-	newq.b = strtopx(++on, &on);
-	newq.a = strtopx(++on, &on);
-	return newm;
+	if (UNLIKELY((on = strchr(c->on + 1U, '\t')) == NULL)) {
+		goto retry;
+	}
+	with (const char *str = ++on) {
+		q.b = strtopx(str, &on);
+		q.b = on > str ? q.b : NANPX;
+	}
+	with (const char *str = ++on) {
+		q.a = strtopx(str, &on);
+		q.a = on > str ? q.a : NANPX;
+	}
+	return q;
 }
 
 static tv_t
-next_acc(void)
+next_acc(aoj_cur_t *restrict c, rec_t *restrict r, unsigned int f)
 {
-	static acc_t newa = {
-		.base = 0.dd, .term = 0.dd, .comm = 0.dd,
-	};
-	static char *line;
-	static size_t llen;
-	static tv_t newm;
 	char *on;
-	hx_t UNUSED(hx);
-
-	/* assign previous next_quo as current quo */
-	a = newa;
-
-	/* set next valuation timer */
-	if (a.base) {
-		nexv = (((newm - 1UL) / intv) + 1UL) * intv;
-	} else {
-		nexv = NATV;
-	}
+	char *tag;
 
 again:
-	if (UNLIKELY(getline(&line, &llen, afp) <= 0)) {
-		free(line);
+	if (UNLIKELY(aoj_next(c) == NATV)) {
 		return NATV;
 	}
-
-	/* snarf metronome */
-	newm = strtotv(line, &on);
 	/* make sure we're talking accounts */
-	if (UNLIKELY(memcmp(++on, "ACC\t", 4U))) {
+	if (UNLIKELY(memcmp(on = c->on + 1U, "ACC\t", 4U))) {
 		goto again;
 	}
 	on += 4U;
 
-	/* get currency indicator */
-	hx = strtohx(on, &on);
+	/* currency indicator, or account tag */
+	if (UNLIKELY((on = strchr(tag = on, '\t')) == NULL)) {
+		goto again;
+	}
+	r->i = find_acc(f, tag, on - tag);
 	/* snarf the base amount */
-	newa.base = strtoqx(++on, &on);
-	newa.term = strtoqx(++on, &on);
-	newa.comm = strtoqx(++on, &on);
-	return newm;
+	r->a.base = strtoqx(++on, &on);
+	r->a.term = strtoqx(++on, &on);
+	r->a.comb = strtoqx(++on, &on);
+	r->a.comt = 0.dd;
+	return c->t;
 }
 
 static int
-offline(void)
+offline(aoj_cur_t *c, size_t nc)
 {
-	tv_t qmtr;
-	tv_t amtr;
-
-	qmtr = next_quo();
-	amtr = next_acc();
+/* C[0..NC) are the account files, C[NC] the quotes, accounts rank
+ * before quotes of the same time */
+	rec_t *r = malloc(nc * sizeof(*r));
+	quo_t q;
 
-	do {
-		while (qmtr < amtr && qmtr <= nexv) {
-			qmtr = next_quo();
-		}
-		if (nexv < amtr && nexv < qmtr && a.base) {
-			const tv_t metr = min_tv(qmtr, amtr);
-			eva_t v = eva(nexv, a, q);
-
-			for (; nexv < metr; v.t = nexv += intv) {
-				send_eva(v);
-			}
-		}
-		if (amtr <= qmtr) {
-			amtr = next_acc();
+	for (size_t j = 0U; j < nc; j++) {
+		next_acc(c + j, r + j, j);
+	}
+	q = next_quo(c + nc);
+
+	/* merge all streams by time and feed them to the evaluator */
+	for (size_t k; (k = aoj_min(c, nc + 1U)) <= nc;) {
+		if (k < nc) {
+			eva_push_acc(&e, r[k].i, c[k].t, r[k].a);
+			next_acc(c + k, r + k, k);
+		} else {
+			eva_push_quo(&e, q);
+			q = next_quo(c + nc);
 		}
-	} while (amtr < NATV || qmtr < NATV);
+	}
+	free(r);
 	return 0;
 }
 
-
+
 #include "eva.yucc"
 
 int
@@ -256,6 +210,7 @@ main(int argc, char *argv[])
 {
 	static yuck_t argi[1U];
 	int rc = 0;
+	int qfd;
 
 	if (yuck_parse(argi, argc, argv) < 0) {
 		rc = 1;
@@ -273,35 +228,83 @@ Error: QUOTES file is mandatory.");
 	}
 
 	if (argi->interval_arg) {
-		if (!(intv = strtoul(argi->interval_arg, NULL, 10))) {
+		if (!(e.intv = strtoul(argi->interval_arg, NULL, 10))) {
 			errno = 0, serror("\
 Error: interval argument cannot be naught");
 			rc = 1;
 			goto out;
 		}
 		/* turn into milliseconds */
-		intv *= NSECS;
+		e.intv *= NSECS;
 	}
 
-	if (UNLIKELY((afp = stdin) == NULL)) {
-		errno = 0, serror("\
-Error: cannot open ACCOUNTS file");
-		rc = 1;
-		goto out;
-	}		
-
-	if (UNLIKELY((qfp = fopen(*argi->args, "r")) == NULL)) {
+	if (UNLIKELY((qfd = open(*argi->args, O_RDONLY)) < 0)) {
 		serror("\
 Error: cannot open QUOTES file `%s'", *argi->args);
 		rc = 1;
 		goto out;
 	}
 
-	/* offline mode */
-	rc = offline();
+	with (size_t nc = argi->nargs > 1U ? argi->nargs - 1U : 1U) {
+		/* account files first, quotes last */
+		aoj_cur_t *c = calloc(nc + 1U, sizeof(*c));
+		int *fd = calloc(nc, sizeof(*fd));
 
-	fclose(qfp);
-	fclose(afp);
+		nacf = nc;
+
+		if (UNLIKELY(aoj_open(c + nc, qfd) < 0)) {
+			serror("\
+Error: cannot read QUOTES file `%s'", *argi->args);
+			rc = 1;
+			goto clo;
+		}
+		for (size_t j = 1U; j < argi->nargs; j++) {
+			const char *fn = argi->args[j];
+
+			if (UNLIKELY((fd[j - 1U] = open(fn, O_RDONLY)) < 0)) {
+				serror("\
+Error: cannot open ACCOUNTS file `%s'", fn);
+				rc = 1;
+				goto clo;
+			}
+		}
+		for (size_t j = 0U; j < nc; j++) {
+			/* stdin if there's no account files */
+			if (UNLIKELY(aoj_open(c + j, fd[j]) < 0)) {
+				serror("\
+Error: cannot read ACCOUNTS file `%s'",
+				       j + 1U < argi->nargs
+				       ? argi->args[j + 1U] : "-");
+				rc = 1;
+				goto clo;
+			}
+		}
+
+		/* offline mode */
+		e.eva = send_eva;
+		rc = offline(c, nc);
+
+	clo:
+		for (size_t j = 0U; j < nc; j++) {
+			if (fd[j] > STDIN_FILENO) {
+				close(fd[j]);
+			}
+		}
+		for (size_t j = 0U; j <= nc; j++) {
+			aoj_close(c + j);
+		}
+		free(fd);
+		free(c);
+	}
+
+	eva_fini(&e);
+	for (size_t i = 0U; i < atbl.n; i++) {
+		free(tags[i]);
+	}
+	free(tags);
+	free(tagz);
+	hxtbl_fini(&atbl);
+	close(qfd);
 out:
 	yuck_free(argi);
 	return rc;
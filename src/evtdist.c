@@ -17,6 +17,8 @@
 #include <math.h>
 #include <tgmath.h>
 #include "tv.h"
+#include "cal.h"
+#include "lhist.h"
 #include "nifty.h"
 
 typedef struct {
@@ -109,24 +111,6 @@ tztostr(char *restrict buf, size_t bsz, const tv_t *rv, size_t nv)
 }
 
 
-static inline __attribute__((pure, const)) tv_t
-min_tv(tv_t t1, tv_t t2)
-{
-	return t1 <= t2 ? t1 : t2;
-}
-
-static inline __attribute__((pure, const)) tv_t
-max_tv(tv_t t1, tv_t t2)
-{
-	return t1 >= t2 ? t1 : t2;
-}
-
-static inline __attribute__((pure, const)) uint32_t
-ilog2(const uint32_t x)
-{
-	return 31U - __builtin_clz(x);
-}
-
 static inline double
 log1pexpf(double x)
 {
@@ -240,104 +224,50 @@ static tv_t nxct;
 static tv_t last;
 static size_t ip, np;
 
-/* stats */
-static union {
-	size_t start[0U];
-
-#define MAKE_SLOTS(n)				\
-	struct {				\
-		size_t dlt[1U << (n)];		\
-						\
-		tv_t tlo[1U << (n)];		\
-		tv_t thi[1U << (n)];		\
-	} _##n
-
-	MAKE_SLOTS(0);
-	MAKE_SLOTS(5);
-	MAKE_SLOTS(9);
-	MAKE_SLOTS(13);
-	MAKE_SLOTS(17);
-	MAKE_SLOTS(21);
-} cnt;
-
+/* stats, erlang mode bins elapsed times in seconds */
+static struct lhist_s h;
+/* poisson mode counts events per base interval */
 static size_t *dlt;
-static tv_t *tlo;
-static tv_t *thi;
 static size_t cntz;
 static double agg;
 
-static void(*prnt_cndl)(void);
-static char buf[sizeof(cnt)];
-
-static tv_t
-next_cndl(tv_t t)
-{
-	struct tm *tm;
-	time_t u;
-
-	switch (intv.u) {
-	default:
-	case UNIT_NONE:
-		return NATV;
-	case UNIT_NSECS:
-		return (t / intv.t + 1U) * intv.t;
-	case UNIT_SECS:
-		return (t / NSECS / intv.t + 1U) * intv.t * NSECS;
-	case UNIT_DAYS:
-		t /= 24ULL * 60ULL * 60ULL * NSECS;
-		t += intv.t;
-		t *= 24ULL * 60ULL * 60ULL * NSECS;
-		return t;
-	case UNIT_MONTHS:
-	case UNIT_YEARS:
-		break;
-	}
+/* sufficient statistics for the fits, maintained as events come in,
+ * erlang fits represent a bin by its count CNT and maximum HI */
+struct suff_s {
+	/* number of observations, and those in slot 0 */
+	size_t n;
+	size_t n0;
+	/* erlang: sum of CNT * HI in nanoseconds, and that of slot 0 */
+	double t;
+	double t0;
+	/* erlang: sum of CNT * log(HI) outside slot 0 */
+	double lt;
+	/* poisson: number of events */
+	size_t w;
+};
+
+static struct suff_s suff;
+/* ring of the last K candles' statistics */
+static struct suff_s *wndw;
+static size_t nwndw;
+static size_t iwndw;
 
-	u = t / NSECS;
-	tm = gmtime(&u);
-	tm->tm_mday = 1;
-	tm->tm_yday = 0;
-	tm->tm_hour = 0;
-	tm->tm_min = 0;
-	tm->tm_sec = 0;
-
-	switch (intv.u) {
-	case UNIT_MONTHS:
-		*tm = (struct tm){
-			.tm_year = tm->tm_year,
-			.tm_mon = tm->tm_mon + intv.t,
-			.tm_mday = 1,
-		};
-		break;
-	case UNIT_YEARS:
-		*tm = (struct tm){
-			.tm_year = tm->tm_year + intv.t,
-			.tm_mon = 0,
-			.tm_mday = 1,
-		};
-		break;
-	}
-	return mktime(tm) * NSECS;
-}
+static void(*prnt_cndl)(void);
+static char *buf;
+static size_t bufz;
 
 static inline void
 rset_cndl(void)
 {
-	if (!allp) {
+	suff = (struct suff_s){0U};
+	if (dlt != NULL) {
+		memset(dlt, 0, cntz * sizeof(*dlt));
+	} else if (!allp) {
 		/* just reset all stats pages */
-		memset(cnt.start, 0, cntz);
+		lhist_rset(&h);
 	} else {
-		memset(cnt.start, 0, (1 << highbits) * sizeof(*dlt));
-	}
-	return;
-}
-
-static inline void
-rset_rngs(void)
-{
-	if (!allp) {
-		memset(tlo, -1, (1U << highbits) * sizeof(*tlo));
-		return;
+		/* keep the bin spans */
+		memset(h.cnt, 0, h.n * sizeof(*h.cnt));
 	}
 	return;
 }
@@ -358,12 +288,12 @@ push_erlagg(char *ln, size_t UNUSED(lz))
 			prnt_cndl();
 		}
 		agg = 0.;
-		nxct = next_cndl(t);
+		nxct = cal_next(t, intv);
 	} else if (UNLIKELY(t > nxct)) {
 		if (UNLIKELY(!nxct)) {
-			nxct = next_cndl(t);
+			nxct = cal_next(t, intv);
 		}
-		for (; nxct < t; nxct = next_cndl(nxct)) {
+		for (; nxct < t; nxct = cal_next(nxct, intv)) {
 			prnt_cndl();
 			agg = NAN;
 		}
@@ -408,8 +338,7 @@ push_erlng(char *ln, size_t UNUSED(lz))
 			prnt_cndl();
 		}
 		rset_cndl();
-		rset_rngs();
-		nxct = next_cndl(t);
+		nxct = cal_next(t, intv);
 	} else if (LIKELY(ip++ < np)) {
 		return 0;
 	} else if (t - last < pbase.t) {
@@ -419,26 +348,31 @@ push_erlng(char *ln, size_t UNUSED(lz))
 		/* measure time */
 		const tv_t dt = t - last;
 		size_t acc = !elapsp ? 1ULL : dt;
-		unsigned int slot = ilog2(dt / NSECS + 1U);
-		/* determine sub slot, if applicable */
-		unsigned int width = (1U << slot), base = width - 1U;
-		unsigned int subs;
-
-		{
-			/* translate in terms of base */
-			subs = (dt - base * NSECS) << (highbits - 5U);
-			/* divide by width */
-			subs /= width * NSECS;
-
-			slot <<= highbits;
-			slot >>= 5U;
-			slot ^= subs;
+		const size_t slot = lhist_slot(&h, dt);
+		const size_t k = lhist_bin(&h, slot);
+		const size_t c0 = h.cnt[k];
+		const tv_t h0 = h.hi[k];
+
+		lhist_binc(&h, k, acc, dt);
+
+		/* swap the bin's old contribution for the new one */
+		suff.n += acc;
+		with (double d = (double)h.cnt[k] * (double)h.hi[k] -
+		      (double)c0 * (double)h0) {
+			suff.t += d;
+			if (UNLIKELY(!slot)) {
+				suff.n0 += acc;
+				suff.t0 += d;
+			}
+		}
+		if (UNLIKELY(!slot)) {
+			;
+		} else if (LIKELY(h.hi[k] == h0)) {
+			suff.lt += (double)acc * log((double)h0);
+		} else {
+			suff.lt += (double)h.cnt[k] * log((double)h.hi[k]);
+			suff.lt -= c0 ? (double)c0 * log((double)h0) : 0;
 		}
-		/* poisson fit */
-		dlt[slot] += acc;
-
-		tlo[slot] = min_tv(tlo[slot], dt);
-		thi[slot] = max_tv(thi[slot], dt);
 	}
 	/* and store state */
 	last = t;
@@ -463,7 +397,7 @@ push_poiss(char *ln, size_t UNUSED(lz))
 			prnt_cndl();
 		}
 		rset_cndl();
-		nxct = next_cndl(t);
+		nxct = cal_next(t, intv);
 		/* make sure we use the trimmed t value */
 		t /= pbase.t;
 	} else if (UNLIKELY((t /= pbase.t) < last)) {
@@ -474,9 +408,13 @@ Warning: non-chronological");
 		this++;
 	} else {
 		dlt[0U] += t - last - 1U;
+		suff.n += t - last - 1U;
+		suff.n0 += t - last - 1U;
 	final:
 		if (LIKELY(this < cntz)) {
 			dlt[this]++;
+			suff.n++;
+			suff.w += this;
 		} else {
 			errno = 0, serror("\
 Warning: base interval too big, consider setting --base to a smaller value.\n\
@@ -492,6 +430,28 @@ Got %zu events but can only track %zu.", this, cntz);
 
 
 /* fitters */
+static struct suff_s
+wndw_suff(void)
+{
+/* statistics to fit, those of the last K candles if windowed */
+	struct suff_s r = suff;
+
+	if (!nwndw) {
+		return r;
+	}
+	wndw[iwndw++ % nwndw] = suff;
+	r = (struct suff_s){0U};
+	for (size_t i = 0U, n = iwndw < nwndw ? iwndw : nwndw; i < n; i++) {
+		r.n += wndw[i].n;
+		r.n0 += wndw[i].n0;
+		r.t += wndw[i].t;
+		r.t0 += wndw[i].t0;
+		r.lt += wndw[i].lt;
+		r.w += wndw[i].w;
+	}
+	return r;
+}
+
 static inline double
 dzip(const zip_t m, double x)
 {
@@ -557,62 +517,39 @@ dpareto(const pareto_t m, double x)
 }
 
 static gamma_t
-fit_erlang(void)
+fit_erlang(const struct suff_s *st)
 {
-	size_t td = 0U;
-	double su = 0;
-
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		td += dlt[i];
-	}
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (UNLIKELY(!dlt[i])) {
-			continue;
-		}
-		su += (double)dlt[i] * (double)thi[i];
-	}
-
-	const double ltd = log((double)td);
+	const double ltd = log((double)st->n);
 	gamma_t m = {
-		ltd, (double)(np + 1U), (double)(td * (np + 1U) * NSECS) / su,
+		ltd, (double)(np + 1U), (double)(st->n * (np + 1U) * NSECS) / st->t,
 	};
 	/* reconstruct
 	 * so that fitted model and empirical model have same support */
 	with (size_t tmp = 0U) {
-		for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-			if (!dlt[i]) {
+		for (size_t i = 0U, n = h.n; i < n; i++) {
+			if (!h.cnt[i]) {
 				continue;
 			}
-			tmp += exp(m.logn + dgamma(m, (double)thi[i] / NSECS));
+			tmp += exp(m.logn + dgamma(m, (double)h.hi[i] / NSECS));
 		}
 		/* get at least the same count in the count */
-		m.logn += ltd - log((double)tmp);
+		m.logn += log((double)suff.n) - log((double)tmp);
 	}
 	return m;
 }
 
 static gamma_t
-fit_gamma(void)
+fit_gamma(const struct suff_s *st)
 {
-	size_t td = 0U;
-	double ls = 0, su = 0;
 	const double lms = log((double)NSECS);
+	/* slot 0 has log(0) in it, leave it out */
+	const double ls = st->lt - lms * (double)(st->n - st->n0);
+	const double su = st->t - st->t0;
 
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		td += dlt[i];
-	}
-	for (size_t i = 1U, n = 1U << highbits; i < n; i++) {
-		if (!dlt[i]) {
-			continue;
-		}
-		ls += (double)dlt[i] * (log((double)thi[i]) - lms);
-		su += (double)dlt[i] * (double)thi[i];
-	}
-
-	const double ltd = log((double)td);
-	double s = log(su) - ltd - lms - ls / (double)td;
+	const double ltd = log((double)st->n);
+	double s = log(su) - ltd - lms - ls / (double)st->n;
 	double k = (3 - s + sqrt((s - 3)*(s - 3) + 24*s)) / (12 * s);
-	double r = (double)td * k / su;
+	double r = (double)st->n * k / su;
 
 	/* assimilate k and r */
 	with (double tmp = sqrt(k / r)) {
@@ -624,69 +561,49 @@ fit_gamma(void)
 	/* reconstruct
 	 * so that fitted model and empirical model have same support */
 	with (size_t tmp = 0U) {
-		for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-			if (!dlt[i]) {
+		for (size_t i = 0U, n = h.n; i < n; i++) {
+			if (!h.cnt[i]) {
 				continue;
 			}
-			tmp += exp(m.logn + dgamma(m, (double)thi[i] / NSECS));
+			tmp += exp(m.logn + dgamma(m, (double)h.hi[i] / NSECS));
 		}
 		/* get at least the same count in the count */
-		m.logn += ltd - log((double)tmp);
+		m.logn += log((double)suff.n) - log((double)tmp);
 	}
 	return m;
 }
 
 static zip_t
-fit_zip(void)
+fit_zip(const struct suff_s *st)
 {
-	size_t d = 0U, w = 0U;
-
-	for (size_t i = 0U; i < cntz; i++) {
-		d += dlt[i];
-	}
-	for (size_t i = 1U; i < cntz; i++) {
-		w += dlt[i] * i;
-	}
-
 	/* run 10 iterations of the MLE estimator */
 	double lambda = 2;
-	const double mu = (double)w / (double)d;
-	const double z = (double)dlt[0U] / (double)d;
+	const double mu = (double)st->w / (double)st->n;
+	const double z = (double)st->n0 / (double)st->n;
 	for (size_t i = 0U; i < 10U; i++) {
 		lambda = mu * (1 - exp(-lambda)) / (1 - z);
 	}
-	return (zip_t){log((double)d), (double)lambda, (double)(1 - mu / lambda)};
+	return (zip_t){
+		log((double)suff.n), (double)lambda, (double)(1 - mu / lambda)
+	};
 }
 
 static pareto_t
-fit_lomax(void)
+fit_lomax(const struct suff_s *st)
 {
-	size_t d = 0U;
-
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		d += dlt[i];
-	}
-
-	const double ld = log((double)d);
-	double sh = 0;
-	for (size_t i = 1U, n = 1U << highbits; i < n; i++) {
-		if (UNLIKELY(!dlt[i])) {
-			continue;
-		}
-		sh += dlt[i] * log((double)thi[i]);
-	}
+	const double ld = log((double)st->n);
 
-	pareto_t r = {ld, (double)((double)d / sh), 0};
+	pareto_t r = {ld, (double)((double)st->n / st->lt), 0};
 	/* correction for zero inflation, reproduce */
 	with (size_t tmp = 0U) {
-		for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-			if (!dlt[i]) {
+		for (size_t i = 0U, n = h.n; i < n; i++) {
+			if (!h.cnt[i]) {
 				continue;
 			}
-			tmp += exp(r.logn + dpareto(r, (double)thi[i]));
+			tmp += exp(r.logn + dpareto(r, (double)h.hi[i]));
 		}
 		/* get at least the same count in the count */
-		r.logn += ld - log((double)tmp);
+		r.logn += log((double)suff.n) - log((double)tmp);
 	}
 	return r;
 }
@@ -715,10 +632,10 @@ prnt_agg(void)
 
 	len = 0U;
 	/* candle instance */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	/* count */
 	buf[len++] = '\t';
-	len += snprintf(buf + len, sizeof(buf) - len, "%.0f", agg);
+	len += snprintf(buf + len, bufz - len, "%.0f", agg);
 	buf[len++] = '\n';
 
 	fwrite(buf, sizeof(*buf), len, stdout);
@@ -730,9 +647,9 @@ prnt_cndl_mtrx(void)
 {
 	static size_t ncndl;
 	size_t len = 0U;
-	const gamma_t me = fit_erlang();
-	const gamma_t mg = fit_gamma();
-	const pareto_t ml = fit_lomax();
+	struct suff_s st;
+	gamma_t me, mg;
+	pareto_t ml;
 
 	if (UNLIKELY(!nxct)) {
 		return;
@@ -740,73 +657,78 @@ prnt_cndl_mtrx(void)
 		static const char hdr[] = "cndl\tmetric";
 
 		len = memncpy(buf, hdr, strlenof(hdr));
-		for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
+		for (size_t i = 0U, n = h.n; i < n; i++) {
 			buf[len++] = '\t';
 			buf[len++] = 'v';
-			len += ztostr(buf + len, sizeof(buf) - len, i);
+			len += ztostr(buf + len, bufz - len, i);
 		}
 		buf[len++] = '\n';
 		fwrite(buf, sizeof(*buf), len, stdout);
 		len = 0U;
 	}
 
+	st = wndw_suff();
+	me = fit_erlang(&st);
+	mg = fit_gamma(&st);
+	ml = fit_lomax(&st);
+
 	/* delta t */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	/* type t */
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += tztostr(buf + len, sizeof(buf) - len, tlo, 1U << highbits);
+	len += tztostr(buf + len, bufz - len, h.lo, h.n);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	/* type t */
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += tztostr(buf + len, sizeof(buf) - len, thi, 1U << highbits);
+	len += tztostr(buf + len, bufz - len, h.hi, h.n);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	/* type t */
 	len += memncpy(buf + len, "\tcnt", strlenof("\tcnt"));
-	len += zztostr(buf + len, sizeof(buf) - len, dlt, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, h.cnt, h.n);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	/* type t */
 	len += memncpy(buf + len, "\ttheo_erlang", strlenof("\ttheo_erlang"));
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!dlt[i] && !allp) {
+	for (size_t i = 0U, n = h.n; i < n; i++) {
+		if (!h.cnt[i] && !allp) {
 			continue;
 		}
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len,
-			      mtozu(me.logn, dgamma(me, (double)thi[i] / NSECS)));
+		len += ztostr(buf + len, bufz - len,
+			      mtozu(me.logn, dgamma(me, (double)h.hi[i] / NSECS)));
 	}
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	/* type t */
 	len += memncpy(buf + len, "\ttheo_gamma", strlenof("\ttheo_gamma"));
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!dlt[i] && !allp) {
+	for (size_t i = 0U, n = h.n; i < n; i++) {
+		if (!h.cnt[i] && !allp) {
 			continue;
 		}
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len,
-			      mtozu(mg.logn, dgamma(mg, (double)thi[i] / NSECS)));
+		len += ztostr(buf + len, bufz - len,
+			      mtozu(mg.logn, dgamma(mg, (double)h.hi[i] / NSECS)));
 	}
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	/* type t */
 	len += memncpy(buf + len, "\ttheo_lomax", strlenof("\ttheo_lomax"));
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!dlt[i] && !allp) {
+	for (size_t i = 0U, n = h.n; i < n; i++) {
+		if (!h.cnt[i] && !allp) {
 			continue;
 		}
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len,
-			      mtozu(ml.logn, dpareto(ml, (double)thi[i])));
+		len += ztostr(buf + len, bufz - len,
+			      mtozu(ml.logn, dpareto(ml, (double)h.hi[i])));
 	}
 	buf[len++] = '\n';
 
@@ -819,9 +741,9 @@ prnt_cndl_molt(void)
 {
 	static size_t ncndl;
 	size_t len = 0U;
-	const gamma_t me = fit_erlang();
-	const gamma_t mg = fit_gamma();
-	const pareto_t ml = fit_lomax();
+	struct suff_s st;
+	gamma_t me, mg;
+	pareto_t ml;
 
 	if (UNLIKELY(!nxct)) {
 		return;
@@ -830,31 +752,41 @@ prnt_cndl_molt(void)
 		fwrite(hdr, sizeof(*hdr), strlenof(hdr), stdout);
 	}
 
+	/* sparse bins are kept in order of appearance */
+	lhist_sort(&h);
+	st = wndw_suff();
+	me = fit_erlang(&st);
+	mg = fit_gamma(&st);
+	ml = fit_lomax(&st);
+
 	/* delta t */
 	len = 0U;
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!dlt[i] && !allp) {
+	for (size_t i = 0U, n = h.n; i < n; i++) {
+		if (!h.cnt[i] && !allp) {
 			continue;
+		} else if (UNLIKELY(len + 256U > bufz)) {
+			fwrite(buf, sizeof(*buf), len, stdout);
+			len = 0U;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
+		len += tvutostr(buf + len, bufz - len,
 				(tvu_t){nxct, intv.u});
 		/* type t */
 		buf[len++] = '\t';
-		len += tvtostr(buf + len, sizeof(buf) - len, tlo[i]);
+		len += tvtostr(buf + len, bufz - len, h.lo[i]);
 		buf[len++] = '\t';
-		len += tvtostr(buf + len, sizeof(buf) - len, thi[i]);
+		len += tvtostr(buf + len, bufz - len, h.hi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, dlt[i]);
+		len += ztostr(buf + len, bufz - len, h.cnt[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len,
-			      mtozu(me.logn, dgamma(me, (double)thi[i] / NSECS)));
+		len += ztostr(buf + len, bufz - len,
+			      mtozu(me.logn, dgamma(me, (double)h.hi[i] / NSECS)));
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len,
-			      mtozu(mg.logn, dgamma(mg, (double)thi[i] / NSECS)));
+		len += ztostr(buf + len, bufz - len,
+			      mtozu(mg.logn, dgamma(mg, (double)h.hi[i] / NSECS)));
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len,
-			      mtozu(ml.logn, dpareto(ml, (double)thi[i])));
+		len += ztostr(buf + len, bufz - len,
+			      mtozu(ml.logn, dpareto(ml, (double)h.hi[i])));
 		buf[len++] = '\n';
 	}
 	fwrite(buf, sizeof(*buf), len, stdout);
@@ -866,7 +798,8 @@ prnt_cndl_mtrx_poiss(void)
 {
 	static size_t ncndl;
 	size_t len = 0U;
-	const zip_t m = fit_zip();
+	struct suff_s st;
+	zip_t m;
 
 	if (UNLIKELY(!nxct)) {
 		return;
@@ -879,33 +812,36 @@ prnt_cndl_mtrx_poiss(void)
 				continue;
 			}
 			buf[len++] = '\t';
-			len += ztostr(buf + len, sizeof(buf) - len, i);
+			len += ztostr(buf + len, bufz - len, i);
 		}
 		buf[len++] = '\n';
 		fwrite(buf, sizeof(*buf), len, stdout);
 		len = 0U;
 	}
 
+	st = wndw_suff();
+	m = fit_zip(&st);
+
 	/* delta t */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	len += memncpy(buf + len, "\tcnt", strlenof("\tcnt"));
 	for (size_t i = 0U; i < cntz; i++) {
 		if (!dlt[i] && !allp) {
 			continue;
 		}
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, dlt[i]);
+		len += ztostr(buf + len, bufz - len, dlt[i]);
 	}
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){nxct, intv.u});
 	len += memncpy(buf + len, "\ttheo_zip", strlenof("\ttheo_zip"));
 	for (size_t i = 0U; i < cntz; i++) {
 		if (!dlt[i] && !allp) {
 			continue;
 		}
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len,
+		len += ztostr(buf + len, bufz - len,
 			      mtozu(m.logn, dzip(m, (double)i)));
 	}
 	buf[len++] = '\n';
@@ -919,7 +855,8 @@ prnt_cndl_molt_poiss(void)
 {
 	static size_t ncndl;
 	size_t len = 0U;
-	const zip_t m = fit_zip();
+	struct suff_s st;
+	zip_t m;
 
 	if (UNLIKELY(!nxct)) {
 		return;
@@ -928,6 +865,9 @@ prnt_cndl_molt_poiss(void)
 		fwrite(hdr, sizeof(*hdr), strlenof(hdr), stdout);
 	}
 
+	st = wndw_suff();
+	m = fit_zip(&st);
+
 	/* delta t */
 	len = 0U;
 	for (size_t i = 0U; i < cntz; i++) {
@@ -935,15 +875,15 @@ prnt_cndl_molt_poiss(void)
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
+		len += tvutostr(buf + len, bufz - len,
 				(tvu_t){nxct, intv.u});
 		/* type t */
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, i);
+		len += ztostr(buf + len, bufz - len, i);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, dlt[i]);
+		len += ztostr(buf + len, bufz - len, dlt[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len,
+		len += ztostr(buf + len, bufz - len,
 			      mtozu(m.logn, dzip(m, (double)i)));
 		buf[len++] = '\n';
 	}
@@ -996,42 +936,20 @@ Error: invalid suffix in base argument.");
 	/* set resolution */
 	highbits = (argi->verbose_flag << 2U) ^ (argi->verbose_flag > 0U);
 
-	switch (highbits) {
-#define ASS_PTRS(n)				\
-		dlt = cnt._##n.dlt;		\
-						\
-		tlo = cnt._##n.tlo;		\
-		thi = cnt._##n.thi;		\
-						\
-		cntz = sizeof(cnt._##n)
-
-	case 0U:
-		ASS_PTRS(0);
-		break;
-
-	case 5U:
-		ASS_PTRS(5);
-		break;
-
-	case 9U:
-		ASS_PTRS(9);
-		break;
-
-	case 13U:
-		ASS_PTRS(13);
-		break;
-
-	case 17U:
-		ASS_PTRS(17);
-		break;
-
-	case 21U:
-		ASS_PTRS(21);
-		break;
-
-	default:
-		errno = 0, serror("\
+	/* only the table and --all need every bin */
+	with (int sparsep = highbits > 9U && !allp && !argi->table_flag) {
+		if (UNLIKELY(lhist_init(&h, highbits, NSECS, sparsep) < 0)) {
+			errno = 0, serror("\
 Error: verbose flag can only be used one to five times.");
+			return -1;
+		}
+		/* 6 matrix lines of at most 24 characters per bin,
+		 * molten lines are flushed as they go */
+		bufz = !sparsep ? 192U * h.n + 4096U : 65536U;
+	}
+	if (UNLIKELY((buf = malloc(bufz)) == NULL)) {
+		serror("\
+Error: cannot allocate print buffer");
 		return -1;
 	}
 
@@ -1041,19 +959,7 @@ Error: verbose flag can only be used one to five times.");
 
 	if (allp) {
 		/* set up lo and hi */
-		tlo[0U] = 0;
-		for (size_t i = 1U, n = (1U << highbits); i < n; i++) {
-			const size_t sh = highbits > 5U ? highbits - 5U : 0U;
-			const size_t w = (1ULL << sh) - 1ULL;
-			const size_t s = ((1ULL << (i >> sh)) - 1U);
-			const size_t l = (s + 1U);
-
-			tlo[i] = s * NSECS + (((i & w) * l * NSECS) >> sh);
-		}
-		for (size_t i = 0U, n = (1U << highbits) - 1U; i < n; i++) {
-			thi[i] = tlo[i + 1U];
-		}
-		thi[(1U << highbits) - 1U] = NATV;
+		lhist_span(&h);
 	}
 	return 0;
 }
@@ -1093,9 +999,15 @@ Error: invalid suffix in base argument.");
 	prnt_cndl = !argi->table_flag
 		? prnt_cndl_molt_poiss : prnt_cndl_mtrx_poiss;
 
-	/* just reuse erlang's memory */
-	dlt = cnt.start;
-	cntz = sizeof(cnt) / sizeof(dlt);
+	/* track up to 3 * 2^21 events per base interval */
+	cntz = 3U << 21U;
+	bufz = 32U * cntz;
+	if (UNLIKELY((dlt = calloc(cntz, sizeof(*dlt))) == NULL ||
+		     (buf = malloc(bufz)) == NULL)) {
+		serror("\
+Error: cannot allocate event counts");
+		return -1;
+	}
 	ztostr = zutostr;
 	return 0;
 }
@@ -1120,6 +1032,12 @@ Error: invalid suffix to --offset argument.");
 
 	/* set candle printer */
 	prnt_cndl = prnt_agg;
+	bufz = 4096U;
+	if (UNLIKELY((buf = malloc(bufz)) == NULL)) {
+		serror("\
+Error: cannot allocate print buffer");
+		return -1;
+	}
 	return 0;
 }
 
@@ -1151,6 +1069,24 @@ Error: unknown suffix in interval argument, must be s, m, h, d, w, mo, y.");
 
 	allp = argi->all_flag;
 
+	if (argi->window_arg) {
+		nwndw = strtoul(argi->window_arg, NULL, 10);
+		if (!nwndw) {
+			errno = 0, serror("\
+Error: window must be positive.");
+			rc = EXIT_FAILURE;
+			goto out;
+		} else if (nwndw == 1U) {
+			/* that's the same as no window */
+			nwndw = 0U;
+		} else if (UNLIKELY((wndw = calloc(nwndw, sizeof(*wndw))) == NULL)) {
+			serror("\
+Error: cannot allocate window of %zu candles", nwndw);
+			rc = EXIT_FAILURE;
+			goto out;
+		}
+	}
+
 	switch (argi->cmd) {
 	case EVTDIST_CMD_ERLANG:
 		if (setup_erlang((void*)argi) < 0) {
@@ -1206,6 +1142,10 @@ Error: unknown suffix in interval argument, must be s, m, h, d, w, mo, y.");
 	}
 
 out:
+	free(wndw);
+	free(buf);
+	free(dlt);
+	lhist_fini(&h);
 	yuck_free(argi);
 	return rc;
 }
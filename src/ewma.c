@@ -44,12 +44,16 @@
 #include <errno.h>
 #include <math.h>
 #include "tv.h"
+#include "dbl.h"
 #include "hash.h"
 #include "nifty.h"
 
 #define MAX_COLS	(256U)
+#define MAX_BANK	(16U)
 
-static double dcay;
+/* log-decays, one per halflife */
+static double lcay[MAX_BANK];
+static size_t nbank = 1U;
 static tv_t metr;
 
 
@@ -70,7 +74,7 @@ serror(const char *fmt, ...)
 }
 
 
-static double cols[2U][MAX_COLS];
+static double cols[MAX_BANK][2U][MAX_COLS];
 static const char *istr;
 static size_t ilen;
 
@@ -84,20 +88,28 @@ init(size_t UNUSED(ncol))
 static void
 bang(const double d[], size_t n)
 {
-	const double l = pow(dcay, *d);
+	double l[MAX_BANK];
 
-	/* naughth moment */
-	**cols *= l, **cols += 1;
-	/* first moment */
-	for (size_t i = 1U; i < n; i++) {
-		cols[0U][i] *= l;
-		cols[0U][i] += d[i];
+	/* decay multipliers, dcay^d as exp(d * log(dcay)) */
+	for (size_t b = 0U; b < nbank; b++) {
+		l[b] = *d != 0. ? exp(*d * lcay[b]) : 1.;
 	}
-	/* second moment */
-	for (size_t i = 1U; i < n; i++) {
-		const double x = d[i] - cols[0U][i] / **cols;
-		cols[1U][i] *= l;
-		cols[1U][i] += x * x;
+	for (size_t b = 0U; b < nbank; b++) {
+		double (*c)[MAX_COLS] = cols[b];
+
+		/* naughth moment */
+		**c *= l[b], **c += 1;
+		/* first moment */
+		for (size_t i = 1U; i < n; i++) {
+			c[0U][i] *= l[b];
+			c[0U][i] += d[i];
+		}
+		/* second moment */
+		for (size_t i = 1U; i < n; i++) {
+			const double x = d[i] - c[0U][i] / **c;
+			c[1U][i] *= l[b];
+			c[1U][i] += x * x;
+		}
 	}
 	return;
 }
@@ -126,7 +138,7 @@ snarf(double *restrict tgt, char *line, size_t llen)
 	/* keep track of optional interim */
 	istr = ln, ilen = 0U;
 	for (char *on; ln < eol && *ln != '\n'; ln = on) {
-		strtod(ln, &on);
+		strtodbl(ln, &on);
 		if (on > ln ||
 		    (on = memchr(ln + 1U, *istr, eol - (ln + 1U))) == NULL) {
 			break;
@@ -137,7 +149,7 @@ snarf(double *restrict tgt, char *line, size_t llen)
 
 	/* go for the rest */
 	for (char *on; ln < eol && *ln != '\n'; i++, ln = on) {
-		tgt[i] = strtod(ln, &on);
+		tgt[i] = strtodbl(ln, &on);
 		if (UNLIKELY(on <= ln)) {
 			break;
 		}
@@ -148,20 +160,25 @@ snarf(double *restrict tgt, char *line, size_t llen)
 static void
 prnt(size_t ncol)
 {
-	char buf[4096U];
+	static char buf[MAX_BANK * MAX_COLS * 32U + 4096U];
 	size_t len = 0U;
 
 	len += tvtostr(buf + len, sizeof(buf) - len, metr);
 	/* print interim */
 	len += (memcpy(buf + len, istr, ilen), ilen);
-	for (size_t i = 1U; i < ncol; i++) {
-		const double m = cols[0U][i] / **cols;
-		const double v = sqrt(cols[1U][i] / **cols);
+	/* halflife by halflife, in the order given */
+	for (size_t b = 0U; b < nbank; b++) {
+		const double (*c)[MAX_COLS] = cols[b];
+
+		for (size_t i = 1U; i < ncol; i++) {
+			const double m = c[0U][i] / **c;
+			const double v = sqrt(c[1U][i] / **c);
 
-		buf[len++] = '\t';
-		len += snprintf(buf + len, sizeof(buf) - len, "%g", m);
-		buf[len++] = '\t';
-		len += snprintf(buf + len, sizeof(buf) - len, "%g", v);
+			buf[len++] = '\t';
+			len += snprintf(buf + len, sizeof(buf) - len, "%g", m);
+			buf[len++] = '\t';
+			len += snprintf(buf + len, sizeof(buf) - len, "%g", v);
+		}
 	}
 	buf[len++] = '\n';
 	fwrite(buf, 1, len, stdout);
@@ -220,35 +237,55 @@ main(int argc, char *argv[])
 	}
 
 	if (argi->halflife_arg) {
-		tvu_t half = strtotvu(argi->halflife_arg, NULL);
+		char *on = argi->halflife_arg;
+
+		nbank = 0U;
+		for (char *eo; on != NULL; on = eo) {
+			tvu_t half;
 
-		if (!half.t) {
-			errno = 0, serror("\
+			if ((eo = strchr(on, ',')) != NULL) {
+				*eo++ = '\0';
+			}
+			if (UNLIKELY(nbank >= countof(lcay))) {
+				errno = 0, serror("\
+Error: too many halflives, at most %zu supported.", countof(lcay));
+				rc = 1;
+				goto out;
+			}
+			half = strtotvu(on, NULL);
+			if (!half.t) {
+				errno = 0, serror("\
 Error: cannot read halflife argument, must be positive.");
-			rc = 1;
-			goto out;
-		} else if (!half.u) {
-			errno = 0, serror("\
+				rc = 1;
+				goto out;
+			} else if (!half.u) {
+				errno = 0, serror("\
 Error: unknown suffix in interval argument, must be s, m, h, d, w.");
-			rc = 1;
-			goto out;
-		}
-		/* calculate decay */
-		switch (half.u) {
-		case UNIT_DAYS:
-			half.t *= 86400LLU;
-		case UNIT_SECS:
-			half.t *= NSECS;
-		case UNIT_NSECS:
-			/* good */
-			break;
-		default:
-			errno = 0, serror("\
+				rc = 1;
+				goto out;
+			}
+			/* coerce to nanoseconds */
+			switch (half.u) {
+			case UNIT_DAYS:
+				half.t *= 86400LLU;
+			case UNIT_SECS:
+				half.t *= NSECS;
+			case UNIT_NSECS:
+				/* good */
+				break;
+			default:
+				errno = 0, serror("\
 Error: halflife timescale must be coercible to nanoseconds.");
-			rc = 1;
-			goto out;
+				rc = 1;
+				goto out;
+			}
+			/* calculate decay, keep its log for bang() */
+			lcay[nbank++] =
+				log(1. - log(2.) * (double)NSECS / (double)half.t);
 		}
-		dcay = 1. - log(2.) * (double)NSECS / (double)half.t;
+	} else {
+		/* no decay at all */
+		*lcay = -INFINITY;
 	}
 
 	rc = from_stdin() < 0;
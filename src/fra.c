@@ -23,6 +23,7 @@
 #include "dfp754_d64.h"
 #include "hash.h"
 #include "tv.h"
+#include "aoj.h"
 #include "nifty.h"
 
 #define MAX_PREDS	(4096U)
@@ -80,102 +81,82 @@ send_fra(tv_t fmtr, quo_t quo, quo_t fra, const char *id, size_t iz)
 }
 
 
-static FILE *qfp;
-static FILE *ffp;
 static quo_t quo;
 static quo_t fra;
 static char *cont;
 static size_t conz;
 
 static tv_t
-next_quo(void)
+next_quo(aoj_cur_t *restrict c)
 {
-	static char *line;
-	static size_t llen;
-	tv_t newm;
 	char *on;
 
-	if (UNLIKELY(qfp == NULL)) {
-		return NATV;
-	} else if (UNLIKELY(getline(&line, &llen, qfp) <= 0)) {
-		free(line);
-		fclose(qfp);
-		qfp = NULL;
+retry:
+	if (UNLIKELY(aoj_next(c) == NATV)) {
 		return NATV;
 	}
-
-	newm = strtotv(line, &on);
 	/* instrument next */
-	on = strchr(++on, '\t');
+	if (UNLIKELY((on = strchr(c->on + 1U, '\t')) == NULL)) {
+		goto retry;
+	}
 	quo.b = strtopx(++on, &on);
 	quo.a = strtopx(++on, &on);
-	return newm;
+	return c->t;
 }
 
 static tv_t
-next_fra(void)
+next_fra(aoj_cur_t *restrict c)
 {
-	static char *line;
-	static size_t llen;
-	tv_t newm;
 	char *on;
 
-	if (UNLIKELY(ffp == NULL)) {
-		return NATV;
-	} else if (UNLIKELY(getline(&line, &llen, ffp) <= 0)) {
-		free(line);
-		fclose(ffp);
-		ffp = NULL;
+retry:
+	if (UNLIKELY(aoj_next(c) == NATV)) {
 		return NATV;
 	}
-
-	/* snarf metronome */
-	newm = strtotv(line, &on);
 	/* anything that comes now is a FRA identifier */
-	if (UNLIKELY((cont = ++on) == NULL)) {
-		return NATV;
-	} else if (UNLIKELY((on = strchr(cont, '\t')) == NULL)) {
-		return NATV;
+	if (UNLIKELY((on = strchr(cont = c->on + 1U, '\t')) == NULL)) {
+		goto retry;
 	}
 	/* stash identifier */
 	conz = on++ - cont;
 	/* overread underlying */
 	if (UNLIKELY((on = strchr(on, '\t')) == NULL)) {
-		return NATV;
+		goto retry;
 	}
 	/* snarf the base amount */
 	fra = (quo_t){strtopx(++on, &on), strtopx(++on, &on)};
-	return newm;
+	return c->t;
 }
 
 static int
-offline(void)
+offline(aoj_cur_t c[static 2U])
 {
-	quo_t base;
-	tv_t qmtr;
-	tv_t fmtr;
+/* C[0] are the quotes, C[1] the forward pricings, a FRA is priced off
+ * the last quote at or before its time */
+	quo_t base = {NAND32, NAND32};
 
-	fmtr = next_fra();
+	next_quo(c + 0U);
+	next_fra(c + 1U);
 
-	while (fmtr < NATV) {
-		while ((qmtr = next_quo()) <= fmtr) {
+	for (size_t k; (k = aoj_min(c, 2U)) < 2U;) {
+		if (k == 0U) {
 			/* stash */
 			base = quo;
-		}
-		if (UNLIKELY(qmtr == NATV)) {
+			next_quo(c + 0U);
+		} else if (UNLIKELY(c[0U].t == NATV)) {
 			/* it's better if we have quotes after
 			 * the last forward pricing */
 			break;
+		} else {
+			/* print fra now */
+			send_fra(c[1U].t, base, fra, cont, conz);
+			next_fra(c + 1U);
 		}
-		/* print fra now */
-		do {
-			send_fra(fmtr, base, fra, cont, conz);
-		} while ((fmtr = next_fra()) < qmtr);
 	}
 	return 0;
 }
 
-
+
 #include "fra.yucc"
 
 int
@@ -183,6 +164,7 @@ main(int argc, char *argv[])
 {
 	static yuck_t argi[1U];
 	int rc = 0;
+	int qfd;
 
 	if (yuck_parse(argi, argc, argv) < 0) {
 		rc = 1;
@@ -194,25 +176,33 @@ Error: QUOTES file is mandatory.");
 		goto out;
 	}
 
-	if (UNLIKELY((qfp = fopen(*argi->args, "r")) == NULL)) {
+	if (UNLIKELY((qfd = open(*argi->args, O_RDONLY)) < 0)) {
 		serror("\
 Error: cannot open QUOTES file `%s'", *argi->args);
 		rc = 1;
 		goto out;
 	}
 
-	/* set FRA file pointer to stdin */
-	ffp = stdin;
-
-	/* offline mode */
-	rc = offline();
-
-	if (qfp) {
-		fclose(qfp);
-	}
-	if (ffp) {
-		fclose(ffp);
+	/* FRAs come from stdin */
+	with (aoj_cur_t c[2U]) {
+		if (UNLIKELY(aoj_open(c + 0U, qfd) < 0)) {
+			serror("\
+Error: cannot read QUOTES file `%s'", *argi->args);
+			rc = 1;
+		} else if (UNLIKELY(aoj_open(c + 1U, STDIN_FILENO) < 0)) {
+			serror("\
+Error: cannot read FRAs from stdin");
+			aoj_close(c + 0U);
+			rc = 1;
+		} else {
+			/* offline mode */
+			rc = offline(c);
+
+			aoj_close(c + 0U);
+			aoj_close(c + 1U);
+		}
 	}
+	close(qfd);
 out:
 	yuck_free(argi);
 	return rc;
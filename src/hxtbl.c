@@ -0,0 +1,101 @@
+/*** hxtbl.c -- instruments by hash, open addressed
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include "hxtbl.h"
+#include "nifty.h"
+
+
+size_t
+hxtbl_put(struct hxtbl_s *t, hx_t hx)
+{
+	size_t k;
+
+	if (UNLIKELY(2U * t->n >= t->z)) {
+		/* rehash, keep the table at most half full */
+		const size_t olz = t->z;
+		typeof(t->tbl) old = t->tbl;
+
+		t->z = t->z ? 2U * t->z : 64U;
+		t->tbl = calloc(t->z, sizeof(*t->tbl));
+		for (size_t j = 0U; j < olz; j++) {
+			if (!old[j].i) {
+				continue;
+			}
+			for (k = old[j].hx & (t->z - 1U); t->tbl[k].i;
+			     k = (k + 1U) & (t->z - 1U));
+			t->tbl[k] = old[j];
+		}
+		free(old);
+	}
+	for (k = hx & (t->z - 1U); t->tbl[k].i; k = (k + 1U) & (t->z - 1U)) {
+		if (t->tbl[k].hx == hx) {
+			return t->tbl[k].i - 1U;
+		}
+	}
+	/* new one */
+	t->tbl[k].hx = hx;
+	t->tbl[k].i = ++t->n;
+	return t->n - 1U;
+}
+
+size_t
+hxtbl_get(const struct hxtbl_s *t, hx_t hx)
+{
+	if (UNLIKELY(!t->z)) {
+		return (size_t)-1;
+	}
+	for (size_t k = hx & (t->z - 1U); t->tbl[k].i;
+	     k = (k + 1U) & (t->z - 1U)) {
+		if (t->tbl[k].hx == hx) {
+			return t->tbl[k].i - 1U;
+		}
+	}
+	return (size_t)-1;
+}
+
+void
+hxtbl_fini(struct hxtbl_s *t)
+{
+	free(t->tbl);
+	*t = (struct hxtbl_s){.tbl = NULL, .z = 0U, .n = 0U};
+	return;
+}
+
+/* hxtbl.c ends here */
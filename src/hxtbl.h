@@ -0,0 +1,65 @@
+/*** hxtbl.h -- instruments by hash, open addressed
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_hxtbl_h_
+#define INCLUDED_hxtbl_h_
+#include <stddef.h>
+#include "hash.h"
+
+/**
+ * Map of hashes to dense indices, handed out in order of first
+ * appearance, so per-instrument state can live in plain arrays.
+ * A zeroed struct is an empty table. */
+struct hxtbl_s {
+	struct {
+		hx_t hx;
+		/* index + 1, or 0 if the slot is free */
+		size_t i;
+	} *tbl;
+	size_t z;
+	/* number of indices handed out */
+	size_t n;
+};
+
+/**
+ * Return the index of HX in T, add HX as index T->N if it's new. */
+extern size_t hxtbl_put(struct hxtbl_s *t, hx_t hx);
+/**
+ * Return the index of HX in T, or -1 if HX is not in T. */
+extern size_t hxtbl_get(const struct hxtbl_s *t, hx_t hx);
+extern void hxtbl_fini(struct hxtbl_s *t);
+
+#endif	/* INCLUDED_hxtbl_h_ */
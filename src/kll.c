@@ -0,0 +1,355 @@
+/*** kll.c -- mergeable quantile sketches
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include "kll.h"
+#include "nifty.h"
+
+/* on-disk layout, in host byte order, followed by the levels,
+ * each as uint64_t size and that many doubles */
+struct kll_hdr_s {
+	char magic[4U];
+	uint32_t k;
+	uint32_t nlev;
+	uint32_t pad;
+	uint64_t n;
+	double min;
+	double max;
+};
+
+static const char kll_magic[4U] = {'K', 'L', 'v', '1'};
+
+
+static inline unsigned int
+flip(struct kll_s *s)
+{
+/* xorshift64 */
+	s->rnd ^= s->rnd << 13U;
+	s->rnd ^= s->rnd >> 7U;
+	s->rnd ^= s->rnd << 17U;
+	return (unsigned int)(s->rnd >> 63U);
+}
+
+static size_t
+capof(const struct kll_s *s, unsigned int h)
+{
+/* capacity of level H, the top level holds K items */
+	const int d = (int)(s->nlev - 1U - h);
+	const double z = ceil((double)s->k / ldexp(pow(3, d), -d));
+	return z > 2 ? (size_t)z : 2U;
+}
+
+static void
+recapa(struct kll_s *s)
+{
+	s->capa = 0U;
+	for (unsigned int h = 0U; h < s->nlev; h++) {
+		s->capa += capof(s, h);
+	}
+	return;
+}
+
+static int
+grow_lev(struct kll_s *s, unsigned int h, size_t z)
+{
+	size_t nu = s->la[h] ?: 16U;
+	double *v;
+
+	if (LIKELY(z <= s->la[h])) {
+		return 0;
+	}
+	for (; nu < z; nu *= 2U);
+	if (UNLIKELY((v = realloc(s->lv[h], nu * sizeof(*v))) == NULL)) {
+		return -1;
+	}
+	s->lv[h] = v;
+	s->la[h] = nu;
+	return 0;
+}
+
+static int
+dbl_cmp(const void *a, const void *b)
+{
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static int
+compact(struct kll_s *s)
+{
+/* compact the lowest level that is at capacity */
+	unsigned int h;
+
+	for (h = 0U; h < s->nlev && s->lz[h] < capof(s, h); h++);
+	if (UNLIKELY(h >= s->nlev)) {
+		return 0;
+	} else if (h + 1U >= s->nlev) {
+		if (UNLIKELY(s->nlev >= KLL_MAXLEV)) {
+			return -1;
+		}
+		s->nlev++;
+		recapa(s);
+	}
+	with (size_t z = s->lz[h], o = z & 1U, m = (z - o) / 2U) {
+		double *restrict v;
+
+		if (UNLIKELY(grow_lev(s, h + 1U, s->lz[h + 1U] + m) < 0)) {
+			return -1;
+		}
+		qsort(s->lv[h], z, sizeof(*s->lv[h]), dbl_cmp);
+		/* an odd item out stays where it is */
+		v = s->lv[h + 1U] + s->lz[h + 1U];
+		for (size_t i = o + flip(s), j = 0U; j < m; i += 2U, j++) {
+			v[j] = s->lv[h][i];
+		}
+		s->lz[h + 1U] += m;
+		s->lz[h] = o;
+		s->held -= z - o - m;
+	}
+	return 0;
+}
+
+static int
+fit(struct kll_s *s)
+{
+	while (s->held >= s->capa) {
+		size_t was = s->held;
+
+		if (UNLIKELY(compact(s) < 0 || s->held >= was)) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+
+int
+kll_init(struct kll_s *s, unsigned int k)
+{
+	if (UNLIKELY(k < 8U)) {
+		return -1;
+	}
+	memset(s, 0, sizeof(*s));
+	s->k = k;
+	s->nlev = 1U;
+	s->min = INFINITY;
+	s->max = -INFINITY;
+	s->rnd = 0x9e3779b97f4a7c15ULL;
+	recapa(s);
+	return 0;
+}
+
+void
+kll_fini(struct kll_s *s)
+{
+	for (unsigned int h = 0U; h < KLL_MAXLEV; h++) {
+		free(s->lv[h]);
+	}
+	memset(s, 0, sizeof(*s));
+	return;
+}
+
+int
+kll_push(struct kll_s *s, double x)
+{
+	if (UNLIKELY(s->lz[0U] >= s->la[0U] && grow_lev(s, 0U, s->lz[0U] + 1U) < 0)) {
+		return -1;
+	}
+	if (UNLIKELY(!s->n)) {
+		/* seed the coin with the data so that sketches of
+		 * different data compact independently */
+		s->rnd ^= (union {double x; uint64_t u;}){x}.u * 0xbf58476d1ce4e5b9ULL;
+		s->rnd += !s->rnd;
+	}
+	s->lv[0U][s->lz[0U]++] = x;
+	s->held++;
+	s->n++;
+	s->min = x < s->min ? x : s->min;
+	s->max = x > s->max ? x : s->max;
+	if (UNLIKELY(s->held >= s->capa)) {
+		return fit(s);
+	}
+	return 0;
+}
+
+int
+kll_merge(struct kll_s *restrict tgt, const struct kll_s *src)
+{
+	for (unsigned int h = 0U; h < src->nlev; h++) {
+		if (!src->lz[h]) {
+			continue;
+		} else if (UNLIKELY(grow_lev(tgt, h, tgt->lz[h] + src->lz[h]) < 0)) {
+			return -1;
+		}
+		memcpy(tgt->lv[h] + tgt->lz[h], src->lv[h],
+		       src->lz[h] * sizeof(*src->lv[h]));
+		tgt->lz[h] += src->lz[h];
+		tgt->held += src->lz[h];
+	}
+	if (src->nlev > tgt->nlev) {
+		tgt->nlev = src->nlev;
+		recapa(tgt);
+	}
+	tgt->n += src->n;
+	tgt->min = src->min < tgt->min ? src->min : tgt->min;
+	tgt->max = src->max > tgt->max ? src->max : tgt->max;
+	return fit(tgt);
+}
+
+struct witem_s {
+	double v;
+	uint64_t w;
+};
+
+static int
+witem_cmp(const void *a, const void *b)
+{
+	return dbl_cmp(&((const struct witem_s*)a)->v,
+		       &((const struct witem_s*)b)->v);
+}
+
+int
+kll_qntl(double *restrict tgt, const struct kll_s *s, const double *q, size_t n)
+{
+	struct witem_s *r;
+	uint64_t tot = 0U, cum = 0U;
+	size_t m = 0U;
+
+	if (UNLIKELY(!s->held)) {
+		for (size_t i = 0U; i < n; i++) {
+			tgt[i] = NAN;
+		}
+		return 0;
+	} else if (UNLIKELY((r = malloc(s->held * sizeof(*r))) == NULL)) {
+		return -1;
+	}
+	for (unsigned int h = 0U; h < s->nlev; h++) {
+		for (size_t i = 0U; i < s->lz[h]; i++) {
+			r[m++] = (struct witem_s){s->lv[h][i], 1ULL << h};
+		}
+		tot += s->lz[h] << h;
+	}
+	qsort(r, m, sizeof(*r), witem_cmp);
+
+	for (size_t i = 0U, j = 0U; i < n; i++) {
+		/* the extremes are known exactly */
+		if (q[i] <= 0) {
+			tgt[i] = s->min;
+			continue;
+		} else if (q[i] >= 1) {
+			tgt[i] = s->max;
+			continue;
+		}
+		/* first item whose cumulative weight reaches Q * TOT */
+		for (const double rk = q[i] * (double)tot;
+		     j < m && (double)(cum + r[j].w) < rk; cum += r[j++].w);
+		tgt[i] = r[j < m ? j : m - 1U].v;
+	}
+	free(r);
+	return 0;
+}
+
+int
+kll_wr(const struct kll_s *s, FILE *fp)
+{
+	struct kll_hdr_s hdr = {
+		.k = s->k, .nlev = s->nlev,
+		.n = s->n, .min = s->min, .max = s->max,
+	};
+
+	memcpy(hdr.magic, kll_magic, sizeof(hdr.magic));
+	if (UNLIKELY(fwrite(&hdr, sizeof(hdr), 1U, fp) < 1U)) {
+		return -1;
+	}
+	for (unsigned int h = 0U; h < s->nlev; h++) {
+		const uint64_t z = s->lz[h];
+
+		if (UNLIKELY(fwrite(&z, sizeof(z), 1U, fp) < 1U)) {
+			return -1;
+		} else if (UNLIKELY(fwrite(s->lv[h], sizeof(*s->lv[h]), z, fp) < z)) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int
+kll_rd(struct kll_s *s, FILE *fp)
+{
+	struct kll_hdr_s hdr;
+	struct kll_s tmp;
+	int rc = -1;
+
+	if (UNLIKELY(fread(&hdr, sizeof(hdr), 1U, fp) < 1U)) {
+		return -1;
+	} else if (UNLIKELY(memcmp(hdr.magic, kll_magic, sizeof(hdr.magic)))) {
+		return -1;
+	} else if (UNLIKELY(hdr.nlev > KLL_MAXLEV)) {
+		return -1;
+	} else if (UNLIKELY(kll_init(&tmp, hdr.k) < 0)) {
+		return -1;
+	}
+	for (unsigned int h = 0U; h < hdr.nlev; h++) {
+		uint64_t z;
+
+		if (UNLIKELY(fread(&z, sizeof(z), 1U, fp) < 1U)) {
+			goto out;
+		} else if (UNLIKELY(grow_lev(&tmp, h, z) < 0)) {
+			goto out;
+		} else if (UNLIKELY(fread(tmp.lv[h], sizeof(*tmp.lv[h]), z, fp) < z)) {
+			goto out;
+		}
+		tmp.lz[h] = z;
+		tmp.held += z;
+	}
+	tmp.nlev = hdr.nlev ?: 1U;
+	tmp.n = hdr.n;
+	tmp.min = hdr.min;
+	tmp.max = hdr.max;
+	rc = kll_merge(s, &tmp);
+out:
+	kll_fini(&tmp);
+	return rc;
+}
+
+/* kll.c ends here */
@@ -0,0 +1,98 @@
+/*** kll.h -- mergeable quantile sketches
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_kll_h_
+#define INCLUDED_kll_h_
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define KLL_MAXLEV	(64U)
+
+/**
+ * Quantile sketch after Karnin, Lang and Liberty.
+ * Items in level H weigh 2^H.  A full level is sorted and every other
+ * item, starting at a random offset, is promoted to the next level.
+ * Level capacities shrink by 2/3 per level below the top, which
+ * holds K items, the rank error is roughly 1.7 / K.
+ * MIN and MAX are kept exactly. */
+struct kll_s {
+	unsigned int k;
+	unsigned int nlev;
+	/* number of items pushed, held, held at most */
+	size_t n;
+	size_t held;
+	size_t capa;
+	double min;
+	double max;
+	/* coin for compactions */
+	uint64_t rnd;
+
+	size_t lz[KLL_MAXLEV];
+	size_t la[KLL_MAXLEV];
+	double *lv[KLL_MAXLEV];
+};
+
+/**
+ * Set up S with accuracy parameter K. */
+extern int kll_init(struct kll_s *s, unsigned int k);
+
+/**
+ * Free resources associated with S. */
+extern void kll_fini(struct kll_s *s);
+
+/**
+ * Account for X in S. */
+extern int kll_push(struct kll_s *s, double x);
+
+/**
+ * Fold SRC into TGT, K of TGT is kept. */
+extern int kll_merge(struct kll_s *restrict tgt, const struct kll_s *src);
+
+/**
+ * Put the Q[i]-quantiles of S into TGT[i] for i < N, Q ascending. */
+extern int kll_qntl(double *restrict tgt, const struct kll_s *s,
+		    const double *q, size_t n);
+
+/**
+ * Write S to FP in binary. */
+extern int kll_wr(const struct kll_s *s, FILE *fp);
+
+/**
+ * Read a sketch written by kll_wr() from FP and merge it into S. */
+extern int kll_rd(struct kll_s *s, FILE *fp);
+
+#endif	/* INCLUDED_kll_h_ */
@@ -0,0 +1,335 @@
+/*** lhist.c -- log-linear histograms
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include "lhist.h"
+#include "nifty.h"
+
+#define LHV_MAX		((lhv_t)-1ULL)
+
+/* on-disk layout, in host byte order */
+struct lhist_hdr_s {
+	char magic[4U];
+	uint32_t bits;
+	uint64_t unit;
+	uint64_t n;
+};
+
+struct lhist_rec_s {
+	uint64_t slot;
+	uint64_t cnt;
+	uint64_t lo;
+	uint64_t hi;
+};
+
+static const char lhist_magic[4U] = "LHv1";
+
+
+static inline size_t
+hash_slot(size_t slot)
+{
+	return slot * 0x9e3779b97f4a7c15ULL >> 17U;
+}
+
+static int
+grow_sparse(struct lhist_s *h)
+{
+	const size_t nuz = h->z * 2U;
+	size_t *sl, *cn, *ht;
+	lhv_t *lo, *hi;
+
+	if (UNLIKELY((sl = realloc(h->slot, nuz * sizeof(*sl))) == NULL)) {
+		return -1;
+	}
+	h->slot = sl;
+	if (UNLIKELY((cn = realloc(h->cnt, nuz * sizeof(*cn))) == NULL)) {
+		return -1;
+	}
+	h->cnt = cn;
+	if (UNLIKELY((lo = realloc(h->lo, nuz * sizeof(*lo))) == NULL)) {
+		return -1;
+	}
+	h->lo = lo;
+	if (UNLIKELY((hi = realloc(h->hi, nuz * sizeof(*hi))) == NULL)) {
+		return -1;
+	}
+	h->hi = hi;
+	if (UNLIKELY((ht = calloc(2U * nuz, sizeof(*ht))) == NULL)) {
+		return -1;
+	}
+	free(h->htbl);
+	h->htbl = ht;
+	h->hmsk = 2U * nuz - 1U;
+	h->z = nuz;
+
+	/* rehash */
+	for (size_t k = 0U; k < h->n; k++) {
+		size_t i = hash_slot(h->slot[k]) & h->hmsk;
+
+		for (; h->htbl[i]; i = (i + 1U) & h->hmsk);
+		h->htbl[i] = k + 1U;
+	}
+	return 0;
+}
+
+
+int
+lhist_init(struct lhist_s *h, unsigned int bits, lhv_t unit, int sparsep)
+{
+	if (UNLIKELY((bits && (bits < 5U || bits > 21U)) || !unit)) {
+		return -1;
+	}
+	*h = (struct lhist_s){.bits = bits, .unit = unit};
+
+	if (!sparsep) {
+		h->n = h->z = 1ULL << bits;
+	} else {
+		h->z = 64U;
+		h->slot = malloc(h->z * sizeof(*h->slot));
+		h->htbl = calloc(2U * h->z, sizeof(*h->htbl));
+		h->hmsk = 2U * h->z - 1U;
+	}
+	h->cnt = malloc(h->z * sizeof(*h->cnt));
+	h->lo = malloc(h->z * sizeof(*h->lo));
+	h->hi = malloc(h->z * sizeof(*h->hi));
+
+	if (UNLIKELY(h->cnt == NULL || h->lo == NULL || h->hi == NULL ||
+		     (sparsep && (h->slot == NULL || h->htbl == NULL)))) {
+		lhist_fini(h);
+		return -1;
+	}
+	lhist_rset(h);
+	return 0;
+}
+
+void
+lhist_fini(struct lhist_s *h)
+{
+	free(h->slot);
+	free(h->htbl);
+	free(h->cnt);
+	free(h->lo);
+	free(h->hi);
+	memset(h, 0, sizeof(*h));
+	return;
+}
+
+void
+lhist_rset(struct lhist_s *h)
+{
+	if (h->slot) {
+		/* sparse, just forget about all bins */
+		h->n = 0U;
+		memset(h->htbl, 0, (h->hmsk + 1U) * sizeof(*h->htbl));
+		return;
+	}
+	memset(h->cnt, 0, h->n * sizeof(*h->cnt));
+	memset(h->lo, -1, h->n * sizeof(*h->lo));
+	memset(h->hi, 0, h->n * sizeof(*h->hi));
+	return;
+}
+
+size_t
+lhist_bin(struct lhist_s *h, size_t slot)
+{
+	size_t i, k;
+
+	if (LIKELY(h->slot == NULL)) {
+		return slot;
+	}
+	for (i = hash_slot(slot) & h->hmsk;
+	     (k = h->htbl[i]); i = (i + 1U) & h->hmsk) {
+		if (h->slot[k - 1U] == slot) {
+			return k - 1U;
+		}
+	}
+	/* new bin */
+	if (UNLIKELY(h->n >= h->z)) {
+		if (UNLIKELY(grow_sparse(h) < 0)) {
+			abort();
+		}
+		/* find a new home */
+		for (i = hash_slot(slot) & h->hmsk; h->htbl[i];
+		     i = (i + 1U) & h->hmsk);
+	}
+	k = h->n++;
+	h->htbl[i] = k + 1U;
+	h->slot[k] = slot;
+	h->cnt[k] = 0U;
+	h->lo[k] = LHV_MAX;
+	h->hi[k] = 0U;
+	return k;
+}
+
+int
+lhist_merge(struct lhist_s *restrict tgt, const struct lhist_s *src)
+{
+	if (UNLIKELY(tgt->bits != src->bits || tgt->unit != src->unit)) {
+		return -1;
+	}
+	for (size_t k = 0U; k < src->n; k++) {
+		size_t j;
+
+		if (!src->cnt[k] && src->lo[k] > src->hi[k]) {
+			/* untouched */
+			continue;
+		}
+		j = lhist_bin(tgt, lhist_slotof(src, k));
+		tgt->cnt[j] += src->cnt[k];
+		tgt->lo[j] = tgt->lo[j] <= src->lo[k] ? tgt->lo[j] : src->lo[k];
+		tgt->hi[j] = tgt->hi[j] >= src->hi[k] ? tgt->hi[j] : src->hi[k];
+	}
+	return 0;
+}
+
+static int
+rec_cmp(const void *a, const void *b)
+{
+	const struct lhist_rec_s *ra = a, *rb = b;
+	return (ra->slot > rb->slot) - (ra->slot < rb->slot);
+}
+
+void
+lhist_sort(struct lhist_s *h)
+{
+	struct lhist_rec_s *r;
+
+	if (h->slot == NULL || h->n <= 1U) {
+		return;
+	} else if (UNLIKELY((r = malloc(h->n * sizeof(*r))) == NULL)) {
+		return;
+	}
+	for (size_t k = 0U; k < h->n; k++) {
+		r[k] = (struct lhist_rec_s){
+			h->slot[k], h->cnt[k], h->lo[k], h->hi[k]
+		};
+	}
+	qsort(r, h->n, sizeof(*r), rec_cmp);
+	memset(h->htbl, 0, (h->hmsk + 1U) * sizeof(*h->htbl));
+	for (size_t k = 0U; k < h->n; k++) {
+		size_t i = hash_slot(r[k].slot) & h->hmsk;
+
+		h->slot[k] = r[k].slot;
+		h->cnt[k] = r[k].cnt;
+		h->lo[k] = r[k].lo;
+		h->hi[k] = r[k].hi;
+
+		for (; h->htbl[i]; i = (i + 1U) & h->hmsk);
+		h->htbl[i] = k + 1U;
+	}
+	free(r);
+	return;
+}
+
+void
+lhist_span(struct lhist_s *h)
+{
+	if (h->slot) {
+		/* dense only */
+		return;
+	}
+	for (size_t k = 0U; k < h->n; k++) {
+		h->lo[k] = lhist_bound(h, k);
+	}
+	for (size_t k = 1U; k < h->n; k++) {
+		h->hi[k - 1U] = h->lo[k];
+	}
+	h->hi[h->n - 1U] = LHV_MAX;
+	return;
+}
+
+int
+lhist_wr(const struct lhist_s *h, FILE *fp)
+{
+	struct lhist_hdr_s hdr = {.bits = h->bits, .unit = h->unit};
+
+	memcpy(hdr.magic, lhist_magic, sizeof(hdr.magic));
+	for (size_t k = 0U; k < h->n; k++) {
+		hdr.n += h->cnt[k] || h->lo[k] <= h->hi[k];
+	}
+	if (UNLIKELY(fwrite(&hdr, sizeof(hdr), 1U, fp) < 1U)) {
+		return -1;
+	}
+	for (size_t k = 0U; k < h->n; k++) {
+		const struct lhist_rec_s r = {
+			lhist_slotof(h, k), h->cnt[k], h->lo[k], h->hi[k]
+		};
+
+		if (!h->cnt[k] && h->lo[k] > h->hi[k]) {
+			continue;
+		} else if (UNLIKELY(fwrite(&r, sizeof(r), 1U, fp) < 1U)) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int
+lhist_rd(struct lhist_s *h, FILE *fp)
+{
+	struct lhist_hdr_s hdr;
+
+	if (UNLIKELY(fread(&hdr, sizeof(hdr), 1U, fp) < 1U)) {
+		return -1;
+	} else if (UNLIKELY(memcmp(hdr.magic, lhist_magic, sizeof(hdr.magic)))) {
+		return -1;
+	} else if (UNLIKELY(hdr.bits != h->bits || hdr.unit != h->unit)) {
+		return -1;
+	}
+	for (uint64_t i = 0U; i < hdr.n; i++) {
+		struct lhist_rec_s r;
+		size_t k;
+
+		if (UNLIKELY(fread(&r, sizeof(r), 1U, fp) < 1U)) {
+			return -1;
+		} else if (UNLIKELY(r.slot >= 1ULL << h->bits)) {
+			return -1;
+		}
+		k = lhist_bin(h, r.slot);
+		h->cnt[k] += r.cnt;
+		h->lo[k] = h->lo[k] <= r.lo ? h->lo[k] : r.lo;
+		h->hi[k] = h->hi[k] >= r.hi ? h->hi[k] : r.hi;
+	}
+	return 0;
+}
+
+/* lhist.c ends here */
@@ -0,0 +1,211 @@
+/*** lhist.h -- log-linear histograms
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_lhist_h_
+#define INCLUDED_lhist_h_
+#include <stdlib.h>
+#include <stdio.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/**
+ * Values to be binned, non-negative integers in some unit,
+ * same representation as tv_t. */
+typedef long long unsigned int lhv_t;
+
+/**
+ * Log-linear histogram.
+ * Values are binned by octave of X / UNIT, each octave being split into
+ * 2^(BITS - 5) equally wide sub-bins, so the relative bin width is
+ * constant.  There are 2^BITS bins in total, BITS is 0 or 5 to 21.
+ *
+ * In the dense form bin K is slot K, the sparse form only keeps
+ * touched bins, SLOT[K] being the slot of bin K.
+ * Bins with CNT[K] == 0 and LO[K] > HI[K] haven't been touched. */
+struct lhist_s {
+	unsigned int bits;
+	lhv_t unit;
+
+	/* number of bins, allocated bins */
+	size_t n;
+	size_t z;
+	/* sparse only, slots and hash table for them */
+	size_t *slot;
+	size_t *htbl;
+	size_t hmsk;
+
+	size_t *cnt;
+	lhv_t *lo;
+	lhv_t *hi;
+};
+
+/**
+ * Set up H for 2^BITS bins of values in UNIT, sparse if SPARSEP. */
+extern int lhist_init(struct lhist_s *h, unsigned int bits, lhv_t unit,
+		      int sparsep);
+
+/**
+ * Free resources associated with H. */
+extern void lhist_fini(struct lhist_s *h);
+
+/**
+ * Reset all bins of H. */
+extern void lhist_rset(struct lhist_s *h);
+
+/**
+ * Return the bin index of SLOT, inserting it into sparse histograms. */
+extern size_t lhist_bin(struct lhist_s *h, size_t slot);
+
+/**
+ * Fold SRC into TGT, both must have the same bits and unit. */
+extern int lhist_merge(struct lhist_s *tgt, const struct lhist_s *src);
+
+/**
+ * Sort the bins of sparse H by slot, for iterating in order. */
+extern void lhist_sort(struct lhist_s *h);
+
+/**
+ * Set lo and hi of every slot of dense H to the slot's bounds. */
+extern void lhist_span(struct lhist_s *h);
+
+/**
+ * Write H to FP in binary, only touched bins are written. */
+extern int lhist_wr(const struct lhist_s *h, FILE *fp);
+
+/**
+ * Read a histogram written by lhist_wr() from FP and merge it into H. */
+extern int lhist_rd(struct lhist_s *h, FILE *fp);
+
+
+static inline __attribute__((pure, const)) unsigned int
+lhist_ilog2(const lhv_t x)
+{
+	return 63U - __builtin_clzll(x);
+}
+
+/**
+ * Return the slot of X in histograms of BITS bits and unit UNIT. */
+static inline __attribute__((pure, const)) size_t
+lhist_slotx(unsigned int bits, lhv_t unit, lhv_t x)
+{
+	const unsigned int sh = bits - 5U;
+	unsigned int o;
+	lhv_t r, sub;
+
+	if (bits < 5U) {
+		return 0U;
+	} else if ((o = lhist_ilog2(x / unit + 1U)) >= 32U) {
+		return (1U << bits) - 1U;
+	}
+	/* offset into the octave, in units and in fractions thereof */
+	r = x - ((1ULL << o) - 1U) * unit;
+	if (o >= sh) {
+		sub = (r / unit) >> (o - sh);
+	} else {
+		sub = (r / unit) << (sh - o);
+		sub += (r % unit << (sh - o)) / unit;
+	}
+	return ((size_t)o << sh) ^ sub;
+}
+
+static inline __attribute__((pure)) size_t
+lhist_slot(const struct lhist_s *h, lhv_t x)
+{
+	return lhist_slotx(h->bits, h->unit, x);
+}
+
+/**
+ * Return the smallest value that goes into SLOT. */
+static inline __attribute__((pure)) lhv_t
+lhist_bound(const struct lhist_s *h, size_t slot)
+{
+	const unsigned int sh = h->bits > 5U ? h->bits - 5U : 0U;
+	const unsigned int o = slot >> sh;
+	const lhv_t sub = slot & ((1U << sh) - 1U);
+	lhv_t r = ((1ULL << o) - 1U) * h->unit;
+
+	if (o >= sh) {
+		r += sub * h->unit << (o - sh);
+	} else {
+		r += (sub * h->unit << o) >> sh;
+	}
+	return r;
+}
+
+/**
+ * Return the slot behind bin K of H. */
+static inline __attribute__((pure)) size_t
+lhist_slotof(const struct lhist_s *h, size_t k)
+{
+	return h->slot ? h->slot[k] : k;
+}
+
+/**
+ * Count ACC for value V in bin K of H. */
+static inline void
+lhist_binc(struct lhist_s *h, size_t k, size_t acc, lhv_t v)
+{
+	h->cnt[k] += acc;
+	h->lo[k] = h->lo[k] <= v ? h->lo[k] : v;
+	h->hi[k] = h->hi[k] >= v ? h->hi[k] : v;
+	return;
+}
+
+/**
+ * Count ACC for value V in SLOT of H. */
+static inline void
+lhist_bump(struct lhist_s *h, size_t slot, size_t acc, lhv_t v)
+{
+	lhist_binc(h, lhist_bin(h, slot), acc, v);
+	return;
+}
+
+/**
+ * Count ACC for value X in H. */
+static inline void
+lhist_push(struct lhist_s *h, lhv_t x, size_t acc)
+{
+	lhist_bump(h, lhist_slot(h, x), acc, x);
+	return;
+}
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_lhist_h_ */
@@ -16,6 +16,9 @@
 #include <ieee754.h>
 #include <math.h>
 #include <tgmath.h>
+#include "lhist.h"
+#include "kll.h"
+#include "dbl.h"
 #include "nifty.h"
 
 typedef struct {
@@ -39,6 +42,14 @@ typedef struct {
 
 static unsigned int highbits = 1U;
 
+/* stats, values are binned in thousandths */
+static struct lhist_s h;
+/* or sketched for quantiles */
+static struct kll_s sk;
+static unsigned int sketchp;
+static double *qv;
+static size_t nqv;
+
 #if defined __INTEL_COMPILER
 # pragma warning (disable:981)
 #endif	/* __INTEL_COMPILER */
@@ -96,66 +107,40 @@ zztostr(char *restrict buf, size_t bsz, const size_t *zv, size_t nz)
 	return len;
 }
 
-static size_t
-dvtostr(char *restrict buf, size_t bsz, const double *rv, size_t nv)
+/* positive doubles keep their order as bit patterns */
+static inline __attribute__((pure, const)) lhv_t
+dtolhv(double v)
 {
-	size_t len = 0U;
-
-	for (size_t i = 0U; i < nv; i++) {
-		buf[len++] = '\t';
-		len += dtostr(buf + len, bsz - len, rv[i]);
-	}
-	return len;
+	return (union {double v; lhv_t u;}){v}.u;
 }
 
-
 static inline __attribute__((pure, const)) double
-min_d(double v1, double v2)
+lhvtod(lhv_t u)
 {
-	return v1 <= v2 ? v1 : v2;
+	return (union {lhv_t u; double v;}){u}.v;
 }
 
-static inline __attribute__((pure, const)) double
-max_d(double v1, double v2)
+static size_t
+hvtostr(char *restrict buf, size_t bsz, const lhv_t *hv, size_t nv)
 {
-	return v1 >= v2 ? v1 : v2;
-}
+/* untouched bins have lo > hi, they used to print as nan */
+	size_t len = 0U;
 
-static inline __attribute__((pure, const)) uint32_t
-ilog2(const uint32_t x)
-{
-	return 31U - __builtin_clz(x);
+	for (size_t i = 0U; i < nv; i++) {
+		const double v = h.lo[i] <= h.hi[i] ? lhvtod(hv[i]) : -NAN;
+
+		buf[len++] = '\t';
+		len += dtostr(buf + len, bsz - len, v);
+	}
+	return len;
 }
 
 
 static size_t ip, np;
 
-/* stats */
-static union {
-	size_t start[0U];
-
-#define MAKE_SLOTS(n)				\
-	struct {				\
-		size_t dlt[1U << (n)];		\
-						\
-		double tlo[1U << (n)];		\
-		double thi[1U << (n)];		\
-	} _##n
-
-	MAKE_SLOTS(0);
-	MAKE_SLOTS(5);
-	MAKE_SLOTS(9);
-	MAKE_SLOTS(13);
-	MAKE_SLOTS(17);
-	MAKE_SLOTS(21);
-} cnt;
-
-static size_t *dlt;
-static double *tlo;
-static double *thi;
-
 static void(*prnt_cndl)(void);
-static char buf[sizeof(cnt)];
+static char *buf;
+static size_t bufz;
 
 static int
 push_data(char *ln, size_t UNUSED(lz))
@@ -164,34 +149,19 @@ push_data(char *ln, size_t UNUSED(lz))
 	char *on;
 	double x;
 
-	/* metronome is up first */
-	if (UNLIKELY((x = strtod(ln, &on)) <= 0 || on == ln)) {
+	/* metronome is up first, sketches take any value */
+	x = strtodbl(ln, &on);
+	if (UNLIKELY(on == ln || (x <= 0 && !sketchp))) {
 		return -1;
 	} else if (v += x, LIKELY(ip++ < np)) {
 		return 0;
+	} else if (sketchp) {
+		(void)kll_push(&sk, v);
 	} else {
-		/* dissect value*/
-		unsigned int slot = ilog2(lrint(v) + 1U);
-		/* determine sub slot, if applicable */
-		unsigned int width = (1U << slot), base = width - 1U;
-		unsigned int subs;
-
-		{
-			/* translate in terms of base */
-			subs = lrint((v - base) * 1000) << (highbits - 5U);
-			/* divide by width */
-			subs /= width;
-			subs /= 1000U;
-
-			slot <<= highbits;
-			slot >>= 5U;
-			slot ^= subs;
-		}
-		/* poisson fit */
-		dlt[slot]++;
+		/* dissect value */
+		size_t slot = lhist_slot(&h, lrint(v * 1000));
 
-		tlo[slot] = min_d(tlo[slot], v);
-		thi[slot] = max_d(thi[slot], v);
+		lhist_bump(&h, slot, 1U, dtolhv(v));
 	}
 	/* and store state */
 	v = 0;
@@ -211,10 +181,10 @@ prnt_cndl_mtrx(void)
 		static const char hdr[] = "metric";
 
 		len = memncpy(buf, hdr, strlenof(hdr));
-		for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
+		for (size_t i = 0U, n = h.n; i < n; i++) {
 			buf[len++] = '\t';
 			buf[len++] = 'v';
-			len += ztostr(buf + len, sizeof(buf) - len, i);
+			len += ztostr(buf + len, bufz - len, i);
 		}
 		buf[len++] = '\n';
 		fwrite(buf, sizeof(*buf), len, stdout);
@@ -224,17 +194,17 @@ prnt_cndl_mtrx(void)
 	/* type t */
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += dvtostr(buf + len, sizeof(buf) - len, tlo, 1U << highbits);
+	len += hvtostr(buf + len, bufz - len, h.lo, h.n);
 	buf[len++] = '\n';
 
 	/* type t */
 	buf[len++] = 'H';
-	len += dvtostr(buf + len, sizeof(buf) - len, thi, 1U << highbits);
+	len += hvtostr(buf + len, bufz - len, h.hi, h.n);
 	buf[len++] = '\n';
 
 	/* count data */
 	len += memncpy(buf + len, "cnt", strlenof("cnt"));
-	len += zztostr(buf + len, sizeof(buf) - len, dlt, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, h.cnt, h.n);
 	buf[len++] = '\n';
 
 	fwrite(buf, sizeof(*buf), len, stdout);
@@ -252,23 +222,114 @@ prnt_cndl_molt(void)
 		fwrite(hdr, sizeof(*hdr), strlenof(hdr), stdout);
 	}
 
+	/* sparse bins are kept in order of appearance */
+	lhist_sort(&h);
+
 	/* delta t */
 	len = 0U;
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!dlt[i]) {
+	for (size_t i = 0U; i < h.n; i++) {
+		if (!h.cnt[i]) {
 			continue;
+		} else if (UNLIKELY(len + 256U > bufz)) {
+			fwrite(buf, sizeof(*buf), len, stdout);
+			len = 0U;
 		}
-		len += dtostr(buf + len, sizeof(buf) - len, tlo[i]);
+		len += dtostr(buf + len, bufz - len, lhvtod(h.lo[i]));
 		buf[len++] = '\t';
-		len += dtostr(buf + len, sizeof(buf) - len, thi[i]);
+		len += dtostr(buf + len, bufz - len, lhvtod(h.hi[i]));
+		buf[len++] = '\t';
+		len += zutostr(buf + len, bufz - len, h.cnt[i]);
+		buf[len++] = '\n';
+	}
+	fwrite(buf, sizeof(*buf), len, stdout);
+	return;
+}
+static void
+prnt_qntl_mtrx(void)
+{
+	double r[nqv];
+	size_t len = 0U;
+
+	if (UNLIKELY(kll_qntl(r, &sk, qv, nqv) < 0)) {
+		return;
+	}
+	len = memncpy(buf, "metric", strlenof("metric"));
+	for (size_t i = 0U; i < nqv; i++) {
+		buf[len++] = '\t';
+		len += dtostr(buf + len, bufz - len, qv[i]);
+	}
+	buf[len++] = '\n';
+
+	len += memncpy(buf + len, "value", strlenof("value"));
+	for (size_t i = 0U; i < nqv; i++) {
+		buf[len++] = '\t';
+		len += dtostr(buf + len, bufz - len, r[i]);
+	}
+	buf[len++] = '\n';
+	fwrite(buf, sizeof(*buf), len, stdout);
+	return;
+}
+
+static void
+prnt_qntl_molt(void)
+{
+	static const char hdr[] = "q\tvalue\n";
+	double r[nqv];
+	size_t len = 0U;
+
+	if (UNLIKELY(kll_qntl(r, &sk, qv, nqv) < 0)) {
+		return;
+	}
+	len = memncpy(buf, hdr, strlenof(hdr));
+	for (size_t i = 0U; i < nqv; i++) {
+		len += dtostr(buf + len, bufz - len, qv[i]);
 		buf[len++] = '\t';
-		len += zutostr(buf + len, sizeof(buf) - len, dlt[i]);
+		len += dtostr(buf + len, bufz - len, r[i]);
 		buf[len++] = '\n';
 	}
 	fwrite(buf, sizeof(*buf), len, stdout);
 	return;
 }
 
+static int
+dbl_cmp(const void *a, const void *b)
+{
+	const double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static int
+snarf_qntl(const char *s)
+{
+/* read comma separated quantiles from S into QV, ascending */
+	static const double dflt[] = {0, 0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99, 1};
+	size_t z;
+
+	if (s == NULL) {
+		z = countof(dflt);
+	} else {
+		z = 1U;
+		for (const char *c = s; (c = strchr(c, ',')) != NULL; c++, z++);
+	}
+	if (UNLIKELY((qv = malloc(z * sizeof(*qv))) == NULL)) {
+		return -1;
+	} else if (s == NULL) {
+		memcpy(qv, dflt, sizeof(dflt));
+		nqv = z;
+		return 0;
+	}
+	for (char *on; nqv < z; s = on + 1U) {
+		qv[nqv++] = strtod(s, &on);
+		if (UNLIKELY(on == s || (*on && *on != ',') ||
+			     !(qv[nqv - 1U] >= 0 && qv[nqv - 1U] <= 1))) {
+			return -1;
+		}
+	}
+	qsort(qv, nqv, sizeof(*qv), dbl_cmp);
+	return 0;
+}
+
+
 
 #include "loghist.yucc"
 
@@ -298,47 +359,69 @@ Error: occurrences must be positive.");
 	/* set resolution */
 	highbits = (argi->verbose_flag << 2U) ^ (argi->verbose_flag > 0U);
 
-	switch (highbits) {
-#define ASS_PTRS(n)				\
-		dlt = cnt._##n.dlt;		\
-						\
-		tlo = cnt._##n.tlo;		\
-		thi = cnt._##n.thi;		\
-
-	case 0U:
-		ASS_PTRS(0);
-		break;
-
-	case 5U:
-		ASS_PTRS(5);
-		break;
-
-	case 9U:
-		ASS_PTRS(9);
-		break;
-
-	case 13U:
-		ASS_PTRS(13);
-		break;
+	if (argi->sketch_arg) {
+		unsigned int k = 1000U;
 
-	case 17U:
-		ASS_PTRS(17);
-		break;
-
-	case 21U:
-		ASS_PTRS(21);
-		break;
-
-	default:
-		errno = 0, serror("\
+		if (argi->sketch_arg != YUCK_OPTARG_NONE) {
+			k = strtoul(argi->sketch_arg, NULL, 10);
+		}
+		if (UNLIKELY(kll_init(&sk, k) < 0)) {
+			errno = 0, serror("\
+Error: sketch size must be at least 8.");
+			rc = EXIT_FAILURE;
+			goto out;
+		} else if (UNLIKELY(snarf_qntl(argi->quantiles_arg) < 0)) {
+			errno = 0, serror("\
+Error: quantiles must be comma separated numbers between 0 and 1.");
+			rc = EXIT_FAILURE;
+			goto fin;
+		}
+		sketchp = 1U;
+		prnt_cndl = !argi->table_flag ? prnt_qntl_molt : prnt_qntl_mtrx;
+		bufz = 64U * nqv + 4096U;
+	} else {
+		/* only the table needs every bin */
+		with (int sparsep = highbits > 9U && !argi->table_flag) {
+			if (UNLIKELY(lhist_init(&h, highbits, 1000U, sparsep) < 0)) {
+				errno = 0, serror("\
 Error: verbose flag can only be used one to five times.");
-		return -1;
+				return -1;
+			}
+			/* print buffer, enough for the matrix,
+			 * molten lines are flushed as they go */
+			bufz = !sparsep ? 64U * h.n + 4096U : 65536U;
+		}
+	}
+	if (UNLIKELY((buf = malloc(bufz)) == NULL)) {
+		serror("\
+Error: cannot allocate print buffer");
+		rc = EXIT_FAILURE;
+		goto fin;
 	}
-	/* massage tlo/thi */
-	memset(tlo, -1, (1U << highbits) * sizeof(*tlo));
-	memset(thi, -1, (1U << highbits) * sizeof(*thi));
 
-	{
+	if (argi->nargs) {
+		/* merge dumped histograms */
+		for (size_t i = 0U; i < argi->nargs; i++) {
+			FILE *fp;
+
+			if (UNLIKELY((fp = fopen(argi->args[i], "r")) == NULL)) {
+				serror("\
+Error: cannot open histogram file `%s'", argi->args[i]);
+				rc = EXIT_FAILURE;
+				goto fin;
+			} else if (UNLIKELY((!sketchp
+					     ? lhist_rd(&h, fp)
+					     : kll_rd(&sk, fp)) < 0)) {
+				errno = 0, serror("\
+Error: cannot merge histogram file `%s', resolution mismatch?",
+					argi->args[i]);
+				rc = EXIT_FAILURE;
+				fclose(fp);
+				goto fin;
+			}
+			fclose(fp);
+		}
+	} else {
 		char *line = NULL;
 		size_t llen = 0UL;
 		ssize_t nrd;
@@ -348,11 +431,34 @@ Error: verbose flag can only be used one to five times.");
 		}
 		/* finalise our findings */
 		free(line);
+	}
 
+	if (argi->dump_arg) {
+		FILE *fp;
+
+		if (UNLIKELY((fp = fopen(argi->dump_arg, "w")) == NULL)) {
+			serror("\
+Error: cannot open dump file `%s'", argi->dump_arg);
+			rc = EXIT_FAILURE;
+			goto fin;
+		} else if (UNLIKELY((!sketchp
+				     ? lhist_wr(&h, fp)
+				     : kll_wr(&sk, fp)) < 0)) {
+			serror("\
+Error: cannot write dump file `%s'", argi->dump_arg);
+			rc = EXIT_FAILURE;
+		}
+		fclose(fp);
+	} else {
 		/* print the final candle */
 		prnt_cndl();
 	}
 
+fin:
+	free(buf);
+	free(qv);
+	kll_fini(&sk);
+	lhist_fini(&h);
 out:
 	yuck_free(argi);
 	return rc;
@@ -0,0 +1,413 @@
+/*** mi.c -- market impact of opportunities
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#if defined HAVE_DFP754_H
+# include <dfp754.h>
+#endif	/* HAVE_DFP754_H */
+#include "dfp754_d32.h"
+#include "mi.h"
+#include "nifty.h"
+
+/* exponential lags */
+static const tv_t intx[] = {
+	5000U, 10000U, 15000U, 30000U,
+	60000U, 120000U, 300000U, 600000U,
+	900000U, 1800000U, 3600000U, 5400000U,
+	7200000U, 10800000U, 1440000U, 18000000U,
+	21600000U, 28800000U, 43200000U, 64800000U,
+	86400000U, 129600000U, 172800000U, 216000000U,
+	259200000U, 302400000U,	345600000U, 388800000U,
+	432000000U, 475200000U, 518400000U, 604800000U,
+};
+
+/* pnls not yet accounted for in EVAS, staged with their lag and folded
+ * into EVAS, grouped by lag, whenever the stage is full */
+#define ZSTG		(4096U)
+struct mi_stg_s {
+	size_t n;
+	size_t i[ZSTG];
+	double x[ZSTG];
+	/* scratch for the folding */
+	size_t bins[ZSTG];
+	double y[ZSTG];
+};
+
+
+static void
+fold_stg(struct mi_s *m)
+{
+/* fold the staged pnls into their bins, a batch per bin,
+ * M's NBIN holds per-bin counts while folding and is zero otherwise */
+	struct mi_stg_s *s = m->stg;
+	size_t *nbin = m->nbin;
+	size_t nb = 0U;
+
+	/* count, remembering the bins in order of appearance */
+	for (size_t k = 0U; k < s->n; k++) {
+		if (!nbin[s->i[k]]++) {
+			s->bins[nb++] = s->i[k];
+		}
+	}
+	/* turn counts into offsets, then group */
+	for (size_t j = 0U, o = 0U; j < nb; j++) {
+		const size_t c = nbin[s->bins[j]];
+		nbin[s->bins[j]] = o;
+		o += c;
+	}
+	for (size_t k = 0U; k < s->n; k++) {
+		s->y[nbin[s->i[k]]++] = s->x[k];
+	}
+	/* now NBIN holds the end of each group */
+	for (size_t j = 0U, o = 0U; j < nb; j++) {
+		const size_t i = s->bins[j];
+		m->evas[i] = mom_merge(
+			m->evas[i], mom_batch(s->y + o, nbin[i] - o));
+		o = nbin[i];
+		nbin[i] = 0U;
+	}
+	s->n = 0U;
+	return;
+}
+
+static int
+push_mom(struct mi_s *m, size_t i, px_t pnl)
+{
+	if (UNLIKELY(i >= m->zeva)) {
+		size_t nuze = 2U * m->zeva;
+		mom_t *nuev;
+		size_t *nunb;
+
+		while (i >= nuze) {
+			nuze *= 2U;
+		}
+		nuev = realloc(m->evas, nuze * sizeof(*m->evas));
+		if (UNLIKELY(nuev == NULL)) {
+			return -1;
+		}
+		m->evas = nuev;
+		nunb = realloc(m->nbin, nuze * sizeof(*m->nbin));
+		if (UNLIKELY(nunb == NULL)) {
+			return -1;
+		}
+		m->nbin = nunb;
+		/* clear memory */
+		memset(m->evas + m->zeva, 0, (nuze - m->zeva) * sizeof(*nuev));
+		memset(m->nbin + m->zeva, 0, (nuze - m->zeva) * sizeof(*nunb));
+		m->zeva = nuze;
+	}
+	m->stg->i[m->stg->n] = i;
+	m->stg->x[m->stg->n] = (double)pnl;
+	if (UNLIKELY(++m->stg->n >= ZSTG)) {
+		fold_stg(m);
+	}
+	return 0;
+}
+
+static int
+eval(struct mi_s *m, size_t i)
+{
+	if (UNLIKELY(isinfd32(m->ppx[i]))) {
+		/* take the quote as it stands */
+		m->ppx[i] = m->ppx[i] > 0 ? m->a : -m->b;
+	}
+	with (px_t p = m->ppx[i], pnl = p > 0.df ? m->b - p : -m->a - p) {
+		if (m->pnl != NULL) {
+			m->pnl(m->clo, m->ptv[i], m->pnx[i], pnl);
+		}
+		if (m->sump) {
+			const tv_t lag = !m->absp
+				? m->pnx[i] - m->ptv[i]
+				: m->pnx[i] % m->maxt;
+			return push_mom(m, lag / m->intv, pnl);
+		}
+	}
+	return 0;
+}
+
+
+/* min-heap of position indices keyed on their next evaluation time */
+static inline bool
+heap_lt(const tv_t *key, size_t x, size_t y)
+{
+	/* break ties by index so evaluation order is deterministic */
+	return key[x] < key[y] || key[x] == key[y] && x < y;
+}
+
+static void
+heap_sift_down(struct mi_s *m, size_t i)
+{
+	const tv_t *key = m->pnx;
+	size_t *heap = m->heap;
+	const size_t x = heap[i];
+
+	for (size_t c; (c = 2U * i + 1U) < m->nheap; i = c) {
+		c += c + 1U < m->nheap && heap_lt(key, heap[c + 1U], heap[c]);
+		if (!heap_lt(key, heap[c], x)) {
+			break;
+		}
+		heap[i] = heap[c];
+	}
+	heap[i] = x;
+	return;
+}
+
+static int
+heap_push(struct mi_s *m, size_t x)
+{
+	const tv_t *key = m->pnx;
+	size_t i;
+
+	if (UNLIKELY(m->nheap >= m->zheap)) {
+		const size_t nuzh = m->zheap ? 2U * m->zheap : 256U;
+		size_t *nuhp = realloc(m->heap, nuzh * sizeof(*nuhp));
+
+		if (UNLIKELY(nuhp == NULL)) {
+			return -1;
+		}
+		m->heap = nuhp;
+		m->zheap = nuzh;
+	}
+	for (i = m->nheap++; i > 0U; i = (i - 1U) / 2U) {
+		const size_t p = m->heap[(i - 1U) / 2U];
+
+		if (!heap_lt(key, x, p)) {
+			break;
+		}
+		m->heap[i] = p;
+	}
+	m->heap[i] = x;
+	return 0;
+}
+
+
+int
+mi_init(struct mi_s *m)
+{
+	m->metr = 0ULL;
+	m->b = m->a = 0.df;
+	m->mpos = m->npos = 0U;
+	m->zpos = 4096U;
+	m->nfre = 0U;
+	m->nheap = m->zheap = 0U;
+	m->heap = NULL;
+	m->fre = m->due = NULL;
+	m->evas = NULL;
+	m->nbin = NULL;
+	m->stg = NULL;
+	m->zeva = 0U;
+
+	m->ptv = malloc(m->zpos * sizeof(*m->ptv));
+	m->pnx = malloc(m->zpos * sizeof(*m->pnx));
+	m->ppx = malloc(m->zpos * sizeof(*m->ppx));
+	m->ini = malloc(m->zpos * sizeof(*m->ini));
+	if (UNLIKELY(m->ptv == NULL || m->pnx == NULL ||
+		     m->ppx == NULL || m->ini == NULL)) {
+		goto nomem;
+	}
+	if (m->expp) {
+		m->fre = malloc(m->zpos * sizeof(*m->fre));
+		m->due = malloc(m->zpos * sizeof(*m->due));
+		if (UNLIKELY(m->fre == NULL || m->due == NULL)) {
+			goto nomem;
+		}
+	}
+	if (m->sump) {
+		/* set up moment vector */
+		m->zeva = (m->maxt / m->intv ?: 4095U) + 1U;
+		m->evas = calloc(m->zeva, sizeof(*m->evas));
+		m->nbin = calloc(m->zeva, sizeof(*m->nbin));
+		m->stg = malloc(sizeof(*m->stg));
+		if (UNLIKELY(m->evas == NULL || m->nbin == NULL ||
+			     m->stg == NULL)) {
+			goto nomem;
+		}
+		m->stg->n = 0U;
+	}
+	return 0;
+
+nomem:
+	m->sum = NULL;
+	mi_fini(m);
+	return -1;
+}
+
+void
+mi_fini(struct mi_s *m)
+{
+	if (m->sump && m->sum != NULL) {
+		fold_stg(m);
+		for (size_t i = 0U; i < m->zeva; i++) {
+			if (UNLIKELY(!m->evas[i].n)) {
+				continue;
+			}
+			m->sum(m->clo, (tv_t)(i * m->intv), m->evas[i]);
+		}
+	}
+	free(m->ptv);
+	free(m->pnx);
+	free(m->ppx);
+	free(m->ini);
+	free(m->fre);
+	free(m->due);
+	free(m->heap);
+	free(m->evas);
+	free(m->nbin);
+	free(m->stg);
+	m->ptv = m->pnx = NULL;
+	m->ppx = NULL;
+	m->ini = NULL;
+	m->fre = m->due = m->heap = m->nbin = NULL;
+	m->evas = NULL;
+	m->stg = NULL;
+	return;
+}
+
+int
+mi_push_quo(struct mi_s *m, tv_t t, px_t b, px_t a)
+{
+	m->metr = t;
+	if (!m->expp) {
+		for (size_t i = m->mpos; i < m->npos && m->pnx[i] <= t; i++) {
+			if (UNLIKELY(eval(m, i) < 0)) {
+				return -1;
+			}
+			m->pnx[i] += m->intv;
+
+			if (UNLIKELY(m->maxt &&
+				     m->pnx[i] > m->ptv[i] + m->maxt)) {
+				/* phase him out */
+				m->mpos = i + 1U;
+			}
+		}
+	} else {
+		size_t ndue = 0U;
+
+		/* only touch positions that are due, and like in
+		 * the linear case only once per quote */
+		for (; m->nheap && m->pnx[*m->heap] <= t; ndue++) {
+			m->due[ndue] = *m->heap;
+			m->heap[0U] = m->heap[--m->nheap];
+			heap_sift_down(m, 0U);
+		}
+		for (size_t j = 0U; j < ndue; j++) {
+			const size_t i = m->due[j];
+
+			if (UNLIKELY(eval(m, i) < 0)) {
+				return -1;
+			}
+			if (UNLIKELY(m->ini[i] >= countof(intx))) {
+				/* phase him out, his slot is up for grabs */
+				m->fre[m->nfre++] = i;
+			} else {
+				m->pnx[i] = m->ptv[i] + intx[m->ini[i]++];
+				/* there's room, he's just been taken off */
+				(void)heap_push(m, i);
+			}
+		}
+	}
+	/* more house keeping */
+	if (m->mpos >= m->zpos / 2U) {
+		/* yay, we've got some spares */
+		if (LIKELY(m->mpos < m->npos)) {
+			/* move, move, move */
+			const size_t nleft = m->npos - m->mpos;
+
+			memmove(m->ptv, m->ptv + m->mpos,
+				nleft * sizeof(*m->ptv));
+			memmove(m->pnx, m->pnx + m->mpos,
+				nleft * sizeof(*m->pnx));
+			memmove(m->ppx, m->ppx + m->mpos,
+				nleft * sizeof(*m->ppx));
+			m->mpos = 0U;
+			m->npos = nleft;
+		} else {
+			/* just reset him */
+			m->mpos = m->npos = 0U;
+		}
+	}
+	m->b = b;
+	m->a = a;
+	return 0;
+}
+
+int
+mi_push_opp(struct mi_s *m, tv_t t, px_t p)
+{
+	size_t k = m->npos;
+
+	if (m->expp && m->nfre) {
+		k = m->fre[--m->nfre];
+	} else if (UNLIKELY(m->npos >= m->zpos)) {
+		const size_t nuzp = 2U * m->zpos;
+		void *nu;
+
+#define GROW(x)						\
+		nu = realloc(m->x, nuzp * sizeof(*m->x));	\
+		if (UNLIKELY(nu == NULL)) {			\
+			return -1;				\
+		}						\
+		m->x = nu
+		GROW(ptv);
+		GROW(pnx);
+		GROW(ppx);
+		GROW(ini);
+		if (m->expp) {
+			GROW(fre);
+			GROW(due);
+		}
+#undef GROW
+		m->zpos = nuzp;
+		m->npos++;
+	} else {
+		m->npos++;
+	}
+	m->ppx[k] = p;
+	m->ptv[k] = t - (!m->absp ? 0U : (t % m->intv));
+	m->pnx[k] = m->ptv[k] + (!m->absp ? 0 : m->intv);
+	m->ini[k] = 0U;
+	if (m->expp && UNLIKELY(heap_push(m, k) < 0)) {
+		return -1;
+	}
+	return 0;
+}
+
+/* mi.c ends here */
@@ -0,0 +1,122 @@
+/*** mi.h -- market impact of opportunities
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_mi_h_
+#define INCLUDED_mi_h_
+#include <stddef.h>
+#include "tv.h"
+#include "px.h"
+#include "mom.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/**
+ * Impact evaluator, quotes and opportunities in, the pnls of the
+ * positions they would have opened out, at lags of INTV or, with
+ * EXPP, at exponentially growing lags.
+ * Must be initialised with mi_init() after the parameters are set. */
+struct mi_s {
+	tv_t intv;
+	/* maximum lag, 0 for none, with absp the length of a day */
+	tv_t maxt;
+	/* evaluate at lags from 5s to 1w growing exponentially */
+	unsigned int expp;
+	/* lags are times of day, modulo MAXT, rather than position ages */
+	unsigned int absp;
+	/* summarise the pnls per lag, as moments */
+	unsigned int sump;
+
+	/* sinks, PNL is called with every evaluation of the position
+	 * opened at TOP, SUM with the moments of every lag at the end,
+	 * both may be NULL */
+	void(*pnl)(void *clo, tv_t top, tv_t now, px_t pnl);
+	void(*sum)(void *clo, tv_t lag, mom_t);
+	void *clo;
+
+	/* state */
+	tv_t metr;
+	px_t b;
+	px_t a;
+	/* positions, open at PTV for PPX, next evaluated at PNX,
+	 * INI is the index into the exponential lags,
+	 * positions [MPOS, NPOS) are live */
+	tv_t *ptv;
+	tv_t *pnx;
+	px_t *ppx;
+	unsigned int *ini;
+	size_t mpos;
+	size_t npos;
+	size_t zpos;
+	/* retired and due slots, exponential lags only */
+	size_t *fre;
+	size_t nfre;
+	size_t *due;
+	/* min-heap of positions keyed on their next evaluation */
+	size_t *heap;
+	size_t nheap;
+	size_t zheap;
+	/* moments per lag, and pnls staged for them */
+	mom_t *evas;
+	size_t zeva;
+	size_t *nbin;
+	struct mi_stg_s *stg;
+};
+
+/**
+ * Return -1 if there's not enough memory for the state of M. */
+extern int mi_init(struct mi_s*);
+/**
+ * Hand out the moments of every lag seen, with sump, and free M. */
+extern void mi_fini(struct mi_s*);
+/**
+ * Evaluate the positions due at T against the current quote,
+ * then make B/A the current quote.
+ * Return -1 if the summary cannot be grown to hold a lag. */
+extern int mi_push_quo(struct mi_s*, tv_t t, px_t b, px_t a);
+/**
+ * Open a position at T for the price P, negated for shorts.
+ * P may be INF (or -INF) to buy at the ask (sell at the bid)
+ * current at the first evaluation.
+ * Return -1 if the position cannot be stored. */
+extern int mi_push_opp(struct mi_s*, tv_t t, px_t p);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_mi_h_ */
@@ -20,6 +20,8 @@
 #include "dfp754_d32.h"
 #include "dfp754_d64.h"
 #include "tv.h"
+#include "hash.h"
+#include "hxtbl.h"
 #include "nifty.h"
 
 typedef _Decimal32 px_t;
@@ -44,6 +46,14 @@ typedef union {
 } quo_t;
 
 static px_t spr = 0.df;
+static bool latp;
+
+/* latent midpoints, per instrument */
+static px_t *lasm;
+static size_t zlasm;
+
+/* instruments by hash */
+static struct hxtbl_s itbl;
 
 
 static inline size_t
@@ -53,10 +63,43 @@ npxtostr(char *restrict buf, size_t bsz, px_t p)
 }
 
 
+static size_t
+find_ins(hx_t hx)
+{
+/* return the index of the instrument whose hash is HX */
+	const size_t n = itbl.n;
+	const size_t i = hxtbl_put(&itbl, hx);
+
+	if (LIKELY(i < n)) {
+		return i;
+	} else if (UNLIKELY(i >= zlasm)) {
+		zlasm = zlasm ? 2U * zlasm : 64U;
+		lasm = realloc(lasm, zlasm * sizeof(*lasm));
+	}
+	/* new instrument */
+	lasm[i] = NANPX;
+	return i;
+}
+
+
 static quo_t q;
+static size_t ins;
 static size_t beg;
 static size_t end;
 
+static inline px_t
+midp(void)
+{
+/* midpoint of the current quote, or for latent midpoints the last
+ * midpoint of this instrument unless the quote moved entirely off it */
+	if (!latp) {
+		return (q.b + q.a) / 2.df;
+	} else if (!(lasm[ins] >= q.b && lasm[ins] <= q.a)) {
+		lasm[ins] = (q.b + q.a) / 2.df;
+	}
+	return lasm[ins];
+}
+
 static int
 push_beef(char *ln, size_t UNUSED(lz))
 {
@@ -67,9 +110,14 @@ push_beef(char *ln, size_t UNUSED(lz))
 		return -1;
 	}
 
-	/* instrument name, don't hash him */
-	if (UNLIKELY((on = strchr(++on, '\t')) == NULL)) {
-		return -1;
+	/* instrument name, hash him only if we need state */
+	with (const char *str = ++on) {
+		if (UNLIKELY((on = strchr(str, '\t')) == NULL)) {
+			return -1;
+		}
+		if (latp) {
+			ins = find_ins(hash(str, on - str));
+		}
 	}
 	beg = ++on - ln;
 
@@ -100,7 +148,7 @@ bidask(void)
 		}
 
 		/* otherwise calc new bid/ask pair */
-		with (px_t mid = (q.b + q.a) / 2.df) {
+		with (px_t mid = midp()) {
 			char buf[64U];
 			size_t len = 0U;
 			const quo_t newq = {
@@ -135,7 +183,7 @@ bidask_widen(void)
 		}
 
 		/* otherwise calc new bid/ask pair */
-		with (px_t mid = (q.b + q.a) / 2.df, sp = (q.a - q.b) / 2.df) {
+		with (px_t mid = midp(), sp = (q.a - q.b) / 2.df) {
 			char buf[64U];
 			size_t len = 0U;
 			const quo_t newq = {
@@ -179,7 +227,7 @@ midspr(void)
 		}
 
 		/* otherwise calc new bid/ask pair */
-		with (px_t mp = (q.b + q.a) / 2.df, sp = q.a - q.b) {
+		with (px_t mp = midp(), sp = q.a - q.b) {
 			char buf[64U];
 			size_t len = 0U;
 
@@ -293,6 +341,8 @@ main(int argc, char *argv[])
 		}
 	}
 
+	latp = argi->latent_flag;
+
 	if (0) {
 		;
 	} else if (argi->despread_flag) {
@@ -306,6 +356,8 @@ main(int argc, char *argv[])
 	} else {
 		rc = midspr() < 0;
 	}
+	free(lasm);
+	hxtbl_fini(&itbl);
 
 out:
 	yuck_free(argi);
@@ -0,0 +1,143 @@
+/*** mom.c -- higher moment accumulators
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <math.h>
+#include "mom.h"
+#include "nifty.h"
+
+
+mom_t
+mom_batch(const double *x, size_t n)
+{
+/* two passes, the lanes are independent so this vectorises */
+	double s[4U] = {0, 0, 0, 0};
+	double s2[4U] = {0, 0, 0, 0};
+	double s3[4U] = {0, 0, 0, 0};
+	double s4[4U] = {0, 0, 0, 0};
+	mom_t r = {.n = n};
+	size_t i;
+
+	if (UNLIKELY(!n)) {
+		return (mom_t){.n = 0U};
+	}
+	for (i = 0U; i + 4U <= n; i += 4U) {
+		for (size_t j = 0U; j < 4U; j++) {
+			s[j] += x[i + j];
+		}
+	}
+	for (; i < n; i++) {
+		s[0U] += x[i];
+	}
+	r.m1 = (s[0U] + s[1U] + s[2U] + s[3U]) / (double)n;
+
+	for (i = 0U; i + 4U <= n; i += 4U) {
+		for (size_t j = 0U; j < 4U; j++) {
+			const double d = x[i + j] - r.m1;
+			const double d2 = d * d;
+
+			s2[j] += d2;
+			s3[j] += d2 * d;
+			s4[j] += d2 * d2;
+		}
+	}
+	for (; i < n; i++) {
+		const double d = x[i] - r.m1;
+		const double d2 = d * d;
+
+		s2[0U] += d2;
+		s3[0U] += d2 * d;
+		s4[0U] += d2 * d2;
+	}
+	r.m2 = s2[0U] + s2[1U] + s2[2U] + s2[3U];
+	r.m3 = s3[0U] + s3[1U] + s3[2U] + s3[3U];
+	r.m4 = s4[0U] + s4[1U] + s4[2U] + s4[3U];
+	return r;
+}
+
+mom_t
+mom_merge(mom_t a, mom_t b)
+{
+/* Chan et al. for the mean and M2, Pebay (2008) for M3 and M4 */
+	const double na = (double)a.n;
+	const double nb = (double)b.n;
+	const double n = na + nb;
+	const double nab = na * nb;
+	double d, d2, dn;
+	mom_t r = {.n = a.n + b.n};
+
+	if (UNLIKELY(!a.n)) {
+		return b;
+	} else if (UNLIKELY(!b.n)) {
+		return a;
+	}
+	d = b.m1 - a.m1;
+	d2 = d * d;
+	dn = d / n;
+
+	r.m1 = a.m1 + nb * dn;
+	r.m2 = a.m2 + b.m2 + d * dn * nab;
+	r.m3 = a.m3 + b.m3 +
+		d2 * dn * nab * (na - nb) / n +
+		3 * dn * (na * b.m2 - nb * a.m2);
+	r.m4 = a.m4 + b.m4 +
+		d2 * d * dn * nab * (na * na - nab + nb * nb) / (n * n) +
+		6 * dn * dn * (na * na * b.m2 + nb * nb * a.m2) +
+		4 * dn * (na * b.m3 - nb * a.m3);
+	return r;
+}
+
+double
+mom_sd(mom_t m)
+{
+	return sqrt(m.m2 / ((double)m.n - 1));
+}
+
+double
+mom_skew(mom_t m)
+{
+	return sqrt((double)m.n) * m.m3 / sqrt(m.m2 * m.m2 * m.m2);
+}
+
+double
+mom_kurt(mom_t m)
+{
+	return ((double)m.n * m.m4) / (m.m2 * m.m2) - 3;
+}
+
+/* mom.c ends here */
@@ -0,0 +1,95 @@
+/*** mom.h -- higher moment accumulators
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_mom_h_
+#define INCLUDED_mom_h_
+#include <stddef.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+/**
+ * Accumulator for the first four moments.
+ * M1 is the mean, M2, M3, M4 are the sums of the 2nd, 3rd and 4th
+ * powers of the differences to the mean. */
+typedef struct {
+	size_t n;
+	double m1;
+	double m2;
+	double m3;
+	double m4;
+} mom_t;
+
+/**
+ * Return M with X accounted for. */
+static inline mom_t
+mom_push(mom_t m, double x)
+{
+	const double nn = (double)m.n;
+	const double delta = x - m.m1;
+	const double delta1 = delta / (nn + 1);
+	const double delta1S = delta1 * delta1;
+	const double delta2 = delta * delta1 * nn;
+
+	m.m4 += delta2 * delta1S * (nn * nn - nn + 1) +
+		6 * delta1S * m.m2 - 4 * delta1 * m.m3;
+	m.m3 += delta2 * delta1 * (nn - 1) - 3 * delta1 * m.m2;
+	m.m2 += delta2;
+	m.m1 += delta1;
+	m.n++;
+	return m;
+}
+
+/**
+ * Return the moments of the N values in X. */
+extern mom_t mom_batch(const double *x, size_t n);
+
+/**
+ * Return the moments of the union of the samples behind A and B. */
+extern mom_t mom_merge(mom_t a, mom_t b);
+
+/**
+ * Sample standard deviation, skewness and excess kurtosis of M. */
+extern double mom_sd(mom_t m);
+extern double mom_skew(mom_t m);
+extern double mom_kurt(mom_t m);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_mom_h_ */
@@ -20,6 +20,7 @@
 #include "dfp754_d32.h"
 #include "dfp754_d64.h"
 #include "hash.h"
+#include "hxtbl.h"
 #include "tv.h"
 #include "nifty.h"
 
@@ -50,8 +51,12 @@ typedef struct {
 	px_t a;
 } quo_t;
 
-static px_t thresh;
+#define MAX_THRESH	(64U)
+
+static px_t thresh[MAX_THRESH] = {0.df};
+static size_t nthresh = 1U;
 static bool limitp;
+static bool summp;
 
 
 static __attribute__((format(printf, 1, 2))) void
@@ -89,42 +94,123 @@ strtohx(const char *x, char **on)
 
 static hx_t hxs;
 static tv_t metr;
-static tik_t bid, ask;
-static const char *cont = "";
+static const char *cont;
 static size_t conz;
-/* state */
-static tik_t bstb = {.p = __DEC32_MOST_NEGATIVE__};
-static tik_t bsta = {.p = __DEC32_MOST_POSITIVE__};
 
-static int
+/* instruments, identified by their hash */
+static struct hxtbl_s itbl;
+/* per instrument, room for ZINST of them */
+static size_t zinst;
+static char **names;
+static size_t *namz;
+static tik_t *bids;
+static tik_t *asks;
+/* DP state, one slot per instrument and threshold, at I * NTHRESH + K */
+static px_t *bstbp;
+static px_t *bstap;
+static tv_t *bstbt;
+static tv_t *bstat;
+static rgm_t *rgm;
+/* summaries, likewise */
+static size_t *ntrd;
+static qx_t *cash;
+
+static size_t
+find_ins(hx_t hx, const char *ins, size_t insz)
+{
+/* return the index of instrument INS whose hash is HX */
+	const size_t n = itbl.n;
+	const size_t i = hxtbl_put(&itbl, hx);
+
+	if (LIKELY(i < n)) {
+		return i;
+	} else if (UNLIKELY(i >= zinst)) {
+		size_t nz;
+
+		nz = zinst = zinst ? 2U * zinst : 64U;
+		names = realloc(names, nz * sizeof(*names));
+		namz = realloc(namz, nz * sizeof(*namz));
+		bids = realloc(bids, nz * sizeof(*bids));
+		asks = realloc(asks, nz * sizeof(*asks));
+		nz *= nthresh;
+		bstbp = realloc(bstbp, nz * sizeof(*bstbp));
+		bstap = realloc(bstap, nz * sizeof(*bstap));
+		bstbt = realloc(bstbt, nz * sizeof(*bstbt));
+		bstat = realloc(bstat, nz * sizeof(*bstat));
+		rgm = realloc(rgm, nz * sizeof(*rgm));
+		ntrd = realloc(ntrd, nz * sizeof(*ntrd));
+		cash = realloc(cash, nz * sizeof(*cash));
+	}
+	/* new instrument */
+	with (const size_t o = i * nthresh) {
+		names[i] = strndup(ins, insz);
+		namz[i] = insz;
+		bids[i] = asks[i] = (tik_t){0U};
+		for (size_t j = o; j < o + nthresh; j++) {
+			bstbp[j] = __DEC32_MOST_NEGATIVE__;
+			bstap[j] = __DEC32_MOST_POSITIVE__;
+			bstbt[j] = bstat[j] = 0U;
+			rgm[j] = RGM_FLAT;
+			ntrd[j] = 0U;
+			cash[j] = 0.dd;
+		}
+	}
+	return i;
+}
+
+static void
+free_ins(void)
+{
+	for (size_t i = 0U; i < itbl.n; i++) {
+		free(names[i]);
+	}
+	hxtbl_fini(&itbl);
+	free(names);
+	free(namz);
+	free(bids);
+	free(asks);
+	free(bstbp);
+	free(bstap);
+	free(bstbt);
+	free(bstat);
+	free(rgm);
+	free(ntrd);
+	free(cash);
+	return;
+}
+
+static ssize_t
 push_beef(const char *ln, size_t UNUSED(lz))
 {
+/* return the index of the instrument whose quotes changed */
 	char *on;
+	size_t i;
 	int rc = -1;
 
 	with (hx_t hx) {
-		if (UNLIKELY(!(hx = strtohx(ln, &on)) || *on++ != '\t')) {
+		if (UNLIKELY(!(hx = strtohx(ln, &on)) || *on != '\t')) {
 			return -1;
-		} else if (hxs != hx) {
+		} else if (cont != NULL && hxs != hx) {
 			return -1;
 		}
+		i = find_ins(hx, ln, on++ - ln);
 	}
 	/* snarf quotes */
 	if (*on >= ' ') {
-		bid = (tik_t){metr, strtopx(on, &on)};
+		bids[i] = (tik_t){metr, strtopx(on, &on)};
 		rc = 0;
 	}
 	if (*on++ != '\t') {
 		;
 	} else if (*on >= ' ') {
-		ask = (tik_t){metr, strtopx(on, &on)};
+		asks[i] = (tik_t){metr, strtopx(on, &on)};
 		rc = 0;
 	}
-	return rc;
+	return rc < 0 ? -1 : (ssize_t)i;
 }
 
 static void
-dgst(rgm_t r, tik_t q)
+dgst(size_t i, size_t k, rgm_t r, tik_t q)
 {
 	static const char *rgms[] = {
 		[RGM_FLAT] = "UNK",
@@ -139,58 +225,120 @@ dgst(rgm_t r, tik_t q)
 	buf[len++] = '\t';
 	len += (memcpy(buf + len, rgms[r], r + 3U), r + 3U);
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, names[i], namz[i]), namz[i]);
 	if (limitp) {
 		buf[len++] = '\t';
 		len += pxtostr(buf + len, sizeof(buf) - len, q.p);
 	}
+	if (nthresh > 1U) {
+		buf[len++] = '\t';
+		len += pxtostr(buf + len, sizeof(buf) - len, thresh[k]);
+	}
 	buf[len++] = '\n';
 	fwrite(buf, 1, len, stdout);
 	return;
 }
 
 static void
-skim(bool lastp)
+trad(size_t i, size_t k, rgm_t r, tik_t q)
+{
+/* go from regime rgm[I * NTHRESH + K] to R at Q */
+	static const int pos[] = {
+		[RGM_FLAT] = 0,
+		[RGM_LONG] = 1,
+		[RGM_SHORT] = -1,
+		[RGM_CANCEL] = 0,
+	};
+
+	const size_t j = i * nthresh + k;
+
+	cash[j] -= (qx_t)(pos[r] - pos[rgm[j]]) * (qx_t)q.p;
+	ntrd[j] += r != RGM_CANCEL;
+	if (!summp) {
+		dgst(i, k, r, q);
+	}
+	rgm[j] = r < RGM_CANCEL ? r : RGM_FLAT;
+	return;
+}
+
+static void
+skim(size_t i)
 {
-	static rgm_t r;
-
-	if (bid.p >= bstb.p) {
-		/* track keeping */
-		bstb = bid;
-	} else if (r != RGM_SHORT && bstb.p - ask.p > thresh) {
-		/* remember current regime */
-		r = RGM_SHORT;
-		/* look for a good long */
-		bsta = ask;
-		/* trade */
-		dgst(r, bstb);
+	const tik_t bid = bids[i];
+	const tik_t ask = asks[i];
+	px_t *restrict bbp = bstbp + i * nthresh;
+	px_t *restrict bap = bstap + i * nthresh;
+	tv_t *restrict bbt = bstbt + i * nthresh;
+	tv_t *restrict bat = bstat + i * nthresh;
+	const rgm_t *r = rgm + i * nthresh;
+
+	/* run the DPs for all thresholds in lockstep */
+	for (size_t k = 0U; k < nthresh; k++) {
+		if (bid.p >= bbp[k]) {
+			/* track keeping */
+			bbp[k] = bid.p, bbt[k] = bid.t;
+		} else if (r[k] != RGM_SHORT && bbp[k] - ask.p > thresh[k]) {
+			/* trade, then look for a good long */
+			trad(i, k, RGM_SHORT, (tik_t){bbt[k], bbp[k]});
+			bap[k] = ask.p, bat[k] = ask.t;
+		}
+
+		if (ask.p <= bap[k]) {
+			/* track keeping */
+			bap[k] = ask.p, bat[k] = ask.t;
+		} else if (r[k] != RGM_LONG && bid.p - bap[k] > thresh[k]) {
+			/* trade, then look for a good short */
+			trad(i, k, RGM_LONG, (tik_t){bat[k], bap[k]});
+			bbp[k] = bid.p, bbt[k] = bid.t;
+		}
 	}
+	return;
+}
 
-	if (ask.p <= bsta.p) {
-		/* track keeping */
-		bsta = ask;
-	} else if (r != RGM_LONG && bid.p - bsta.p > thresh) {
-		/* remember current regime */
-		r = RGM_LONG;
-		/* look for a good short */
-		bstb = bid;
-		/* trade */
-		dgst(r, bsta);
+static void
+canc(void)
+{
+/* cancel all open positions */
+	for (size_t i = 0U; i < itbl.n; i++) {
+		for (size_t k = 0U, j = i * nthresh; k < nthresh; k++, j++) {
+			switch (rgm[j]) {
+			default:
+			case RGM_FLAT:
+				break;
+			case RGM_LONG:
+				trad(i, k, RGM_CANCEL, (tik_t){bstbt[j], bstbp[j]});
+				break;
+			case RGM_SHORT:
+				trad(i, k, RGM_CANCEL, (tik_t){bstat[j], bstap[j]});
+				break;
+			}
+		}
 	}
+	return;
+}
+
+static void
+prnt_summ(void)
+{
+	for (size_t j = 0U; j < itbl.n * nthresh; j++) {
+		const size_t i = j / nthresh, k = j % nthresh;
+		char buf[256U];
+		size_t len = 0U;
 
-	if (UNLIKELY(lastp)) {
-		switch (r) {
-		default:
-		case RGM_FLAT:
-			break;
-		case RGM_LONG:
-			dgst(RGM_CANCEL, bstb);
-			break;
-		case RGM_SHORT:
-			dgst(RGM_CANCEL, bsta);
-			break;
+		if (cont == NULL) {
+			len += (memcpy(buf + len, names[i], namz[i]), namz[i]);
+			buf[len++] = '\t';
 		}
-		r = RGM_FLAT;
+		len += pxtostr(buf + len, sizeof(buf) - len, thresh[k]);
+		buf[len++] = '\t';
+		len += snprintf(buf + len, sizeof(buf) - len, "%zu", ntrd[j]);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len, cash[j]);
+		buf[len++] = '\t';
+		len += qxtostr(buf + len, sizeof(buf) - len,
+			       cash[j] - (qx_t)ntrd[j] * (qx_t)thresh[k]);
+		buf[len++] = '\n';
+		fwrite(buf, 1, len, stdout);
 	}
 	return;
 }
@@ -204,21 +352,22 @@ offline(void)
 	ssize_t nrd;
 
 	while ((nrd = getline(&line, &llen, stdin)) > 0) {
+		ssize_t i;
 		char *on;
 
 		if (UNLIKELY((metr = strtotv(line, &on)) == NATV)) {
 			/* got metronome cock-up */
 			;
-		} else if (UNLIKELY(push_beef(++on, nrd) < 0)) {
+		} else if (UNLIKELY((i = push_beef(++on, nrd)) < 0)) {
 			/* data is fucked or not for us */
 			;
 		} else {
 			/* see what we can trade */
-			skim(false);
+			skim(i);
 		}
 	}
 	/* finalise our findings */
-	skim(true);
+	canc();
 	free(line);
 	return 0;
 }
@@ -243,16 +392,32 @@ main(int argc, char *argv[])
 		conz = strlen(argi->pair_arg);
 	}
 	/* hash contract designator */
-	hxs = hash(cont, conz);
+	hxs = cont != NULL ? hash(cont, conz) : 0U;
 	limitp = !!argi->limit_orders_flag;
+	summp = !!argi->summary_flag;
 
 	if (argi->thresh_arg) {
-		thresh = strtopx(argi->thresh_arg, NULL);
-	}
+		char *on = argi->thresh_arg;
 
+		nthresh = 0U;
+		do {
+			if (UNLIKELY(nthresh >= countof(thresh))) {
+				errno = 0, serror("\
+Error: too many thresholds, at most %zu supported.", countof(thresh));
+				rc = 1;
+				goto out;
+			}
+			thresh[nthresh++] = strtopx(on, &on);
+		} while (*on++ == ',');
+	}
 	/* offline mode */
 	rc = offline();
 
+	if (summp) {
+		prnt_summ();
+	}
+	free_ins();
+
 out:
 	yuck_free(argi);
 	return rc;
@@ -0,0 +1,76 @@
+/*** px.h -- prices and quantities
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_px_h_
+#define INCLUDED_px_h_
+#include <unistd.h>
+
+#if defined __cplusplus
+# if !defined __GNUC__
+#  error "prices need decimal floating point, use g++"
+# endif	/* !__GNUC__ */
+/* no _Decimal32 and _Decimal64 in C++ but g++ knows their modes,
+ * same layout and calling convention as in C */
+typedef float px_t __attribute__((mode(SD)));
+typedef float qx_t __attribute__((mode(DD)));
+
+extern "C" {
+#else  /* !__cplusplus */
+typedef _Decimal32 px_t;
+typedef _Decimal64 qx_t;
+#endif	/* __cplusplus */
+
+/**
+ * Read a price from STR, like strtod(3). */
+extern px_t px_fromstr(const char *str, char **endptr);
+
+/**
+ * Read a quantity from STR, like strtod(3). */
+extern qx_t qx_fromstr(const char *str, char **endptr);
+
+/**
+ * Print price X into BUF of size BSZ, return the number of bytes. */
+extern ssize_t px_tostr(char *buf, size_t bsz, px_t x);
+
+/**
+ * Print quantity X into BUF of size BSZ, return the number of bytes. */
+extern ssize_t qx_tostr(char *buf, size_t bsz, qx_t x);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_px_h_ */
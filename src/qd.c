@@ -0,0 +1,590 @@
+/*** qd.c -- quote distributions
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if defined HAVE_CONFIG_H
+# include "config.h"
+#endif	/* HAVE_CONFIG_H */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#if defined HAVE_DFP754_H
+# include <dfp754.h>
+#elif defined HAVE_DFP_STDLIB_H
+# include <dfp/stdlib.h>
+#else  /* !HAVE_DFP754_H && !HAVE_DFP_STDLIB_H */
+static inline __attribute__((pure, const)) _Decimal32
+fabsd32(_Decimal32 x)
+{
+	return x >= 0 ? x : -x;
+}
+static inline __attribute__((pure, const)) _Decimal64
+fabsd64(_Decimal64 x)
+{
+	return x >= 0 ? x : -x;
+}
+#endif	/* HAVE_DFP754_H */
+#include "dfp754_d32.h"
+#include "dfp754_d64.h"
+#include "qd.h"
+#include "cal.h"
+#include "nifty.h"
+
+typedef size_t cnt_t;
+#define isnanqx		isnand64
+
+
+static inline __attribute__((pure, const)) px_t
+min_px(px_t p1, px_t p2)
+{
+	return p1 <= p2 ? p1 : p2;
+}
+
+static inline __attribute__((pure, const)) px_t
+max_px(px_t p1, px_t p2)
+{
+	return p1 >= p2 ? p1 : p2;
+}
+
+static inline __attribute__((pure, const)) qx_t
+min_qx(qx_t q1, qx_t q2)
+{
+	return q1 <= q2 ? q1 : q2;
+}
+
+static inline __attribute__((pure, const)) qx_t
+max_qx(qx_t q1, qx_t q2)
+{
+	return q1 >= q2 ? q1 : q2;
+}
+
+static inline __attribute__((pure, const)) uint32_t
+ilog2(const uint32_t x)
+{
+	return 31U - __builtin_clz(x);
+}
+
+static const uint32_t _p10[] = {
+	1U, 10U, 100U, 1000U, 10000U,
+	100000U, 1000000U, 10000000U, 100000000U, 1000000000U,
+};
+
+static inline __attribute__((pure, const)) unsigned int
+ilog10(uint32_t x)
+{
+/* floor(log10(x)), x == 0 counts as 1 */
+	const unsigned int t = (ilog2(x | 1U) + 1U) * 1233U >> 12U;
+	return t - ((x | 1U) < _p10[t]);
+}
+
+static inline __attribute__((pure, const)) uint32_t
+pxmant(const px_t x)
+{
+#if defined HAVE_DFP754_BID_LITERALS
+/* read the coefficient straight off the bid32 bits,
+ * if bits 30 and 29 are set the coefficient is 0b100 plus 21 bits */
+	const uint32_t b = bits32(x);
+	const uint32_t lng = -(uint32_t)((b & 0x60000000U) == 0x60000000U);
+	return (b & 0x7fffffU & ~lng) ^ (((b & 0x1fffffU) ^ 0x800000U) & lng);
+#else  /* !HAVE_DFP754_BID_LITERALS */
+	return decompd32(x).mant;
+#endif	/* HAVE_DFP754_BID_LITERALS */
+}
+
+static inline __attribute__((pure, const)) uint64_t
+qxmant(const qx_t x)
+{
+#if defined HAVE_DFP754_BID_LITERALS
+/* same for bid64, short coefficients are 0b100 plus 51 bits */
+	const uint64_t b = bits64(x);
+	const uint64_t lng = -(uint64_t)
+		((b & 0x6000000000000000ULL) == 0x6000000000000000ULL);
+	return (b & 0x1fffffffffffffULL & ~lng) ^
+		(((b & 0x7ffffffffffffULL) ^ 0x20000000000000ULL) & lng);
+#else  /* !HAVE_DFP754_BID_LITERALS */
+	return decompd64(x).mant;
+#endif	/* HAVE_DFP754_BID_LITERALS */
+}
+
+static inline __attribute__((const, pure)) size_t
+pxtoslot(unsigned int bits, const px_t x)
+{
+	uint32_t xm = pxmant(x);
+	xm <<= __builtin_clz(xm);
+	xm >>= 32U - bits;
+	xm &= (1U << bits) - 1U;
+	return xm;
+}
+
+static inline __attribute__((const, pure)) size_t
+qxtoslot(unsigned int bits, const qx_t x)
+{
+	uint64_t xm = qxmant(x);
+	/* we're only interested in the high bits, so shift to fit */
+	xm = xm >> 32U ?: xm;
+	xm <<= __builtin_clz(xm);
+	xm >>= 32U - bits;
+	xm &= (1U << bits) - 1U;
+	return xm;
+}
+
+/* pivots for the decimal log-binning, piv = 10^pivd,
+ * the number of pivot steps in a mantissa is ilog10(m) / pivd */
+static const unsigned int _pivs[] = {-1U, 10U, 100U, 1000U, 10000U, 100000U};
+static const unsigned char _pivk[][10U] = {
+	{0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U},
+	{0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 9U},
+	{0U, 0U, 1U, 1U, 2U, 2U, 3U, 3U, 4U, 4U},
+	{0U, 0U, 0U, 1U, 1U, 1U, 2U, 2U, 2U, 3U},
+	{0U, 0U, 0U, 0U, 1U, 1U, 1U, 1U, 2U, 2U},
+	{0U, 0U, 0U, 0U, 0U, 1U, 1U, 1U, 1U, 1U},
+};
+
+static inline __attribute__((const, pure)) unsigned int
+dtoslot(unsigned int bits, uint32_t m, int expo)
+{
+/* fold mantissa M with quantum exponent EXPO into
+ * (piv - 1) * (EXPO - minx + k) + M / piv^k, k = floor(log_piv(M)) */
+	static const int minx = -5;
+	const unsigned int pivd = bits >> 2U;
+	const unsigned int piv = _pivs[pivd];
+	const unsigned int k = _pivk[pivd][ilog10(m)];
+	unsigned int slot;
+
+	slot = m / _p10[k * pivd];
+	slot += (piv - 1U) * (expo - minx + k);
+	/* clamp at 32U */
+	slot |= (slot < (1U << bits)) - 1U;
+	slot &= (1U << bits) - 1U;
+	return slot;
+}
+
+static inline __attribute__((const, pure)) size_t
+dprtoslot(unsigned int bits, const px_t x)
+{
+/* specifically for relative price differences */
+	const uint32_t sign = (int32_t)bits32(x) >> 31U;
+
+	/* map negatives to 0 */
+	return dtoslot(bits, pxmant(x) & ~sign, quantexpd32(x));
+}
+
+static inline __attribute__((const, pure)) size_t
+dqrtoslot(unsigned int bits, const qx_t x)
+{
+/* specifically for relative quantity differences */
+	const unsigned int sign = (int64_t)bits64(x) >> 63U;
+	unsigned int slot = dtoslot(bits, qxmant(x), quantexpd64(x));
+
+	/* split slots in halves to cope with negatives
+	 * this is 16 +/- slot/2  the +/- depending on sign */
+	slot = (sign ^ slot) + (1U << bits);
+	slot >>= 1U;
+	return slot;
+}
+
+/* batch versions, bin a block of N values into SLOTS */
+static void
+pxtoslots(unsigned int bits,
+	  size_t *restrict slots, const px_t *restrict x, size_t n)
+{
+	for (size_t i = 0U; i < n; i++) {
+		slots[i] = pxtoslot(bits, x[i]);
+	}
+	return;
+}
+
+static void
+qxtoslots(unsigned int bits,
+	  size_t *restrict slots, const qx_t *restrict x, size_t n)
+{
+	for (size_t i = 0U; i < n; i++) {
+		slots[i] = qxtoslot(bits, x[i]);
+	}
+	return;
+}
+
+static void
+dprtoslots(unsigned int bits,
+	   size_t *restrict slots, const px_t *restrict x, size_t n)
+{
+	for (size_t i = 0U; i < n; i++) {
+		slots[i] = dprtoslot(bits, x[i]);
+	}
+	return;
+}
+
+static void
+dqrtoslots(unsigned int bits,
+	   size_t *restrict slots, const qx_t *restrict x, size_t n)
+{
+	for (size_t i = 0U; i < n; i++) {
+		slots[i] = dqrtoslot(bits, x[i]);
+	}
+	return;
+}
+
+
+/* stats */
+union qd_cnt_u {
+	cnt_t start[0U];
+
+#define MAKE_SLOTS(n)				\
+	struct {				\
+		cnt_t bid[1U << (n)];		\
+		cnt_t ask[1U << (n)];		\
+		cnt_t bsz[1U << (n)];		\
+		cnt_t asz[1U << (n)];		\
+		cnt_t spr[1U << (n)];		\
+		cnt_t rsp[1U << (n)];		\
+		cnt_t imb[1U << (n)];		\
+		cnt_t rim[1U << (n)];		\
+						\
+		px_t bhi[1U << (n)];		\
+		px_t ahi[1U << (n)];		\
+		px_t blo[1U << (n)];		\
+		px_t alo[1U << (n)];		\
+		px_t shi[1U << (n)];		\
+		px_t slo[1U << (n)];		\
+		px_t rhi[1U << (n)];		\
+		px_t rlo[1U << (n)];		\
+						\
+		qx_t Bhi[1U << (n)];		\
+		qx_t Ahi[1U << (n)];		\
+		qx_t Blo[1U << (n)];		\
+		qx_t Alo[1U << (n)];		\
+		qx_t Ihi[1U << (n)];		\
+		qx_t Ilo[1U << (n)];		\
+		qx_t Rhi[1U << (n)];		\
+		qx_t Rlo[1U << (n)];		\
+	} _##n
+
+	MAKE_SLOTS(0);
+	MAKE_SLOTS(5);
+	MAKE_SLOTS(9);
+	MAKE_SLOTS(13);
+	MAKE_SLOTS(17);
+	MAKE_SLOTS(21);
+#undef MAKE_SLOTS
+};
+
+size_t
+qdc_cntz(unsigned int bits)
+{
+	switch (bits) {
+#define CNTZ(n)		sizeof(((union qd_cnt_u*)NULL)->_##n)
+	case 0U:
+		return CNTZ(0);
+	case 5U:
+		return CNTZ(5);
+	case 9U:
+		return CNTZ(9);
+	case 13U:
+		return CNTZ(13);
+	case 17U:
+		return CNTZ(17);
+	case 21U:
+		return CNTZ(21);
+	default:
+		break;
+#undef CNTZ
+	}
+	return 0U;
+}
+
+void
+qdc_rset(struct qdc_s *c)
+{
+	/* just reset all stats pages */
+	memset(c->cnt->start, 0, qdc_cntz(c->bits));
+	lhist_rset(&c->t);
+	return;
+}
+
+void
+qdc_fini(struct qdc_s *c)
+{
+	free(c->cnt);
+	c->cnt = NULL;
+	lhist_fini(&c->t);
+	return;
+}
+
+int
+qdc_init(struct qdc_s *c, unsigned int bits)
+{
+	const size_t cntz = qdc_cntz(bits);
+
+	if (UNLIKELY(!cntz)) {
+		return -1;
+	} else if (UNLIKELY((c->cnt = malloc(cntz)) == NULL)) {
+		return -1;
+	} else if (UNLIKELY(lhist_init(&c->t, bits, MSECS, 0) < 0)) {
+		free(c->cnt);
+		c->cnt = NULL;
+		return -1;
+	}
+
+	switch ((c->bits = bits)) {
+#define ASS_PTRS(n)				\
+		c->bid = c->cnt->_##n.bid;	\
+		c->ask = c->cnt->_##n.ask;	\
+		c->bsz = c->cnt->_##n.bsz;	\
+		c->asz = c->cnt->_##n.asz;	\
+		c->spr = c->cnt->_##n.spr;	\
+		c->imb = c->cnt->_##n.imb;	\
+		c->rsp = c->cnt->_##n.rsp;	\
+		c->rim = c->cnt->_##n.rim;	\
+						\
+		c->blo = c->cnt->_##n.blo;	\
+		c->bhi = c->cnt->_##n.bhi;	\
+		c->alo = c->cnt->_##n.alo;	\
+		c->ahi = c->cnt->_##n.ahi;	\
+		c->shi = c->cnt->_##n.shi;	\
+		c->slo = c->cnt->_##n.slo;	\
+		c->rhi = c->cnt->_##n.rhi;	\
+		c->rlo = c->cnt->_##n.rlo;	\
+						\
+		c->Blo = c->cnt->_##n.Blo;	\
+		c->Bhi = c->cnt->_##n.Bhi;	\
+		c->Alo = c->cnt->_##n.Alo;	\
+		c->Ahi = c->cnt->_##n.Ahi;	\
+		c->Ihi = c->cnt->_##n.Ihi;	\
+		c->Ilo = c->cnt->_##n.Ilo;	\
+		c->Rhi = c->cnt->_##n.Rhi;	\
+		c->Rlo = c->cnt->_##n.Rlo
+
+	case 0U:
+		ASS_PTRS(0);
+		break;
+	case 5U:
+		ASS_PTRS(5);
+		break;
+	case 9U:
+		ASS_PTRS(9);
+		break;
+	case 13U:
+		ASS_PTRS(13);
+		break;
+	case 17U:
+		ASS_PTRS(17);
+		break;
+	case 21U:
+		ASS_PTRS(21);
+		break;
+#undef ASS_PTRS
+	}
+
+	c->nxct = 0;
+	c->_1st = NATV;
+	c->last = 0;
+	c->conz = 0U;
+	qdc_rset(c);
+	return 0;
+}
+
+/* a slot's range is valid once it has been counted, as ticks can weigh
+ * nothing with elapsp the range must be consulted as well, an unseen slot
+ * has neither */
+#define SEEN(c, n, lo, hi, m)	((c)->n[m] || (c)->lo[m] || (c)->hi[m])
+/* account for X in slot M of C, do this before C's N[M] is bumped */
+#define RANGE(c, n, lo, hi, m, x, mn, mx)				\
+	if (SEEN(c, n, lo, hi, m)) {					\
+		(c)->lo[m] = mn((c)->lo[m], x);				\
+		(c)->hi[m] = mx((c)->hi[m], x);				\
+	} else {							\
+		(c)->lo[m] = (c)->hi[m] = x;				\
+	}
+
+void
+qdc_merge(struct qdc_s *restrict tgt, const struct qdc_s *src)
+{
+#define MERGE(n, lo, hi, mn, mx)					\
+	if (!SEEN(src, n, lo, hi, i)) {					\
+		;							\
+	} else if (SEEN(tgt, n, lo, hi, i)) {				\
+		tgt->lo[i] = mn(tgt->lo[i], src->lo[i]);		\
+		tgt->hi[i] = mx(tgt->hi[i], src->hi[i]);		\
+	} else {							\
+		tgt->lo[i] = src->lo[i];				\
+		tgt->hi[i] = src->hi[i];				\
+	}								\
+	tgt->n[i] += src->n[i]
+	for (size_t i = 0U, n = 1U << tgt->bits; i < n; i++) {
+		MERGE(bid, blo, bhi, min_px, max_px);
+		MERGE(ask, alo, ahi, min_px, max_px);
+		MERGE(spr, slo, shi, min_px, max_px);
+		MERGE(rsp, rlo, rhi, min_px, max_px);
+		MERGE(bsz, Blo, Bhi, min_qx, max_qx);
+		MERGE(asz, Alo, Ahi, min_qx, max_qx);
+		MERGE(imb, Ilo, Ihi, min_qx, max_qx);
+		MERGE(rim, Rlo, Rhi, min_qx, max_qx);
+	}
+#undef MERGE
+	lhist_merge(&tgt->t, &src->t);
+	return;
+}
+
+
+int
+qd_init(struct qd_s *q)
+{
+	return qdc_init(&q->c, q->bits);
+}
+
+void
+qd_fini(struct qd_s *q)
+{
+	qdc_fini(&q->c);
+	return;
+}
+
+void
+qd_flush(struct qd_s *q)
+{
+	if (LIKELY(q->c._1st != NATV)) {
+		q->cndl(q->clo, &q->c);
+	}
+	qdc_rset(&q->c);
+	return;
+}
+
+void
+qd_seed(struct qd_s *q, tv_t t)
+{
+	q->c.nxct = cal_next(t, q->intv);
+	q->c._1st = q->c.last = t;
+	return;
+}
+
+int
+qd_push(struct qd_s *q, tv_t t, const char *ins, size_t iz,
+	px_t b, px_t a, qx_t bq, qx_t aq)
+{
+	struct qdc_s *const c = &q->c;
+	const unsigned int bits = c->bits;
+	size_t acc;
+
+	if (UNLIKELY(t < c->last)) {
+		/* remember T nonetheless */
+		c->last = t;
+		return -1;
+	} else if (UNLIKELY(t > c->nxct)) {
+		qd_flush(q);
+		c->nxct = cal_next(t, q->intv);
+		c->_1st = c->last = t;
+		iz = iz < sizeof(c->cont) ? iz : sizeof(c->cont);
+		memcpy(c->cont, ins, c->conz = iz);
+	}
+
+	/* measure time */
+	acc = !q->elapsp ? 1ULL : (t - c->last);
+
+	if (!isnanqx(bq) && !isnanqx(aq)) {
+		size_t sl[2U];
+
+		qxtoslots(bits, sl, (const qx_t[]){bq, aq}, countof(sl));
+
+		const size_t bm = sl[0U];
+		const size_t am = sl[1U];
+
+		RANGE(c, bsz, Blo, Bhi, bm, bq, min_qx, max_qx);
+		RANGE(c, asz, Alo, Ahi, am, aq, min_qx, max_qx);
+
+		c->bsz[bm] += acc;
+		c->asz[am] += acc;
+
+		/* imbalance */
+		with (qx_t Qm = bq + aq, d = aq - bq,
+		      I = quantized64(2.dd * d / Qm, 0.00000dd),
+		      R = quantized64(d / (Qm + fabsd64(d)), 0.00000dd)) {
+			size_t irsl[2U];
+
+			dqrtoslots(bits, irsl, (const qx_t[]){I, R},
+				   countof(irsl));
+
+			const size_t Im = irsl[0U];
+			const size_t Rm = irsl[1U];
+
+			RANGE(c, imb, Ilo, Ihi, Im, I, min_qx, max_qx);
+			RANGE(c, rim, Rlo, Rhi, Rm, R, min_qx, max_qx);
+
+			c->imb[Im] += acc;
+			c->rim[Rm] += acc;
+		}
+	}
+
+	{
+		size_t sl[2U];
+
+		pxtoslots(bits, sl, (const px_t[]){b, a}, countof(sl));
+
+		const size_t bm = sl[0U];
+		const size_t am = sl[1U];
+
+		RANGE(c, bid, blo, bhi, bm, b, min_px, max_px);
+		RANGE(c, ask, alo, ahi, am, a, min_px, max_px);
+
+		c->bid[bm] += acc;
+		c->ask[am] += acc;
+	}
+
+	with (px_t m = fabsd32(b + a), d = (a - b),
+	      s = quantized32(2.df * d / m, 0.00000df),
+	      r = quantized32(d / (m + fabsd32(d)), 0.00000df)) {
+		size_t sl[2U];
+
+		dprtoslots(bits, sl, (const px_t[]){s, r}, countof(sl));
+
+		const size_t sm = sl[0U];
+		const size_t rm = sl[1U];
+
+		RANGE(c, spr, slo, shi, sm, s, min_px, max_px);
+		RANGE(c, rsp, rlo, rhi, rm, r, min_px, max_px);
+
+		c->spr[sm] += acc;
+		c->rsp[rm] += acc;
+	}
+
+	with (tv_t dt = t - c->last) {
+		lhist_bump(&c->t, lhist_slot(&c->t, dt / USECS), acc, dt);
+	}
+
+	/* and store state */
+	c->last = t;
+	return 0;
+}
+
+/* qd.c ends here */
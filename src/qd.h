@@ -0,0 +1,156 @@
+/*** qd.h -- quote distributions
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#if !defined INCLUDED_qd_h_
+#define INCLUDED_qd_h_
+#include <stddef.h>
+#include "tv.h"
+#include "px.h"
+#include "lhist.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
+#define QD_MAX_BITS	(21U)
+
+/**
+ * Distribution candles, bids, asks, sizes, spreads and imbalances
+ * binned by their leading digits into 2^BITS slots each, along with
+ * the range of the values per slot, and the inter-quote times.
+ * Slot M of metric N counts N[M] quotes (or nanoseconds with elapsp),
+ * a slot is untouched if N[M], LO[M] and HI[M] are all zero. */
+struct qdc_s {
+	unsigned int bits;
+	/* end of the candle */
+	tv_t nxct;
+
+	tv_t _1st;
+	tv_t last;
+
+	char cont[64];
+	size_t conz;
+
+	/* inter-quote times, binned in milliseconds */
+	struct lhist_s t;
+
+	/* the pages behind the slots below */
+	union qd_cnt_u *cnt;
+	size_t *bid;
+	size_t *ask;
+	size_t *bsz;
+	size_t *asz;
+	size_t *spr;
+	size_t *rsp;
+	size_t *imb;
+	size_t *rim;
+	px_t *blo;
+	px_t *bhi;
+	px_t *alo;
+	px_t *ahi;
+	qx_t *Blo;
+	qx_t *Bhi;
+	qx_t *Alo;
+	qx_t *Ahi;
+	px_t *slo;
+	px_t *shi;
+	px_t *rlo;
+	px_t *rhi;
+	qx_t *Ilo;
+	qx_t *Ihi;
+	qx_t *Rlo;
+	qx_t *Rhi;
+};
+
+/**
+ * Distribution maker, quotes in, one candle per interval out.
+ * Must be initialised with qd_init() after INTV, BITS and ELAPSP
+ * are set. */
+struct qd_s {
+	tvu_t intv;
+	/* resolution, 0, 5, 9, 13, 17 or 21 */
+	unsigned int bits;
+	/* weigh quotes by the time they survived instead of counting */
+	unsigned int elapsp;
+	/* sink, called with every finished candle */
+	void(*cndl)(void *clo, const struct qdc_s*);
+	void *clo;
+
+	/* state, the candle in the making */
+	struct qdc_s c;
+};
+
+/**
+ * Return -1 if BITS is not a supported resolution or memory is short. */
+extern int qd_init(struct qd_s*);
+/**
+ * Free the state of Q, the candle in the making is dropped. */
+extern void qd_fini(struct qd_s*);
+/**
+ * Hand out the candle in the making, if any. */
+extern void qd_flush(struct qd_s*);
+/**
+ * Resume the candle of a quote at T that has been accounted for
+ * elsewhere, for splitting one stream across several makers. */
+extern void qd_seed(struct qd_s*, tv_t t);
+/**
+ * Account for the quote B/A of sizes BQ/AQ on instrument INS at T.
+ * Sizes are NAN if unknown.  Return -1 if T is before the previous
+ * quote, the quote is ignored then. */
+extern int
+qd_push(struct qd_s*, tv_t t, const char *ins, size_t iz,
+	px_t b, px_t a, qx_t bq, qx_t aq);
+
+/**
+ * Set up the slots of candle C for a resolution of BITS. */
+extern int qdc_init(struct qdc_s *c, unsigned int bits);
+extern void qdc_fini(struct qdc_s *c);
+/**
+ * Reset all slots of C. */
+extern void qdc_rset(struct qdc_s *c);
+/**
+ * Fold SRC's slots into TGT as though SRC's quotes came after TGT's,
+ * TGT keeps its name and candle times. */
+extern void qdc_merge(struct qdc_s *tgt, const struct qdc_s *src);
+/**
+ * Return the size of the slot pages of a candle of BITS. */
+extern size_t qdc_cntz(unsigned int bits);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
+
+#endif	/* INCLUDED_qd_h_ */
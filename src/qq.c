@@ -33,6 +33,8 @@ fabsd64(_Decimal64 x)
 #include "dfp754_d32.h"
 #include "dfp754_d64.h"
 #include "tv.h"
+#include "hash.h"
+#include "hxtbl.h"
 #include "nifty.h"
 
 typedef _Decimal32 px_t;
@@ -53,6 +55,16 @@ typedef struct {
 static px_t qunt = 0.df;
 static unsigned int rptp;
 
+/* per-instrument state */
+static struct ins_s {
+	quo_t last;
+	px_t lasm;
+} *insts;
+static size_t zinsts;
+
+/* instruments by hash */
+static struct hxtbl_s itbl;
+
 
 static inline size_t
 npxtostr(char *restrict buf, size_t bsz, px_t p)
@@ -61,10 +73,29 @@ npxtostr(char *restrict buf, size_t bsz, px_t p)
 }
 
 
+static struct ins_s*
+find_ins(hx_t hx)
+{
+/* return the state of the instrument whose hash is HX */
+	const size_t n = itbl.n;
+	const size_t i = hxtbl_put(&itbl, hx);
+
+	if (LIKELY(i < n)) {
+		return insts + i;
+	} else if (UNLIKELY(i >= zinsts)) {
+		zinsts = zinsts ? 2U * zinsts : 64U;
+		insts = realloc(insts, zinsts * sizeof(*insts));
+	}
+	/* new instrument */
+	insts[i] = (struct ins_s){{0.df, 0.df}, 0.df};
+	return insts + i;
+}
+
+
 static int
 push_qunt(const char *ln, size_t lz)
 {
-	static quo_t last;
+	struct ins_s *st;
 	const char *pre;
 	quo_t q;
 	char *on;
@@ -74,9 +105,12 @@ push_qunt(const char *ln, size_t lz)
 		return -1;
 	}
 
-	/* instrument name, don't hash him */
-	if (UNLIKELY((on = strchr(++on, '\t')) == NULL)) {
-		return -1;
+	/* instrument name, hash him */
+	with (const char *ins = ++on) {
+		if (UNLIKELY((on = strchr(ins, '\t')) == NULL)) {
+			return -1;
+		}
+		st = find_ins(hash(ins, on - ins));
 	}
 	pre = ++on;
 
@@ -86,14 +120,15 @@ push_qunt(const char *ln, size_t lz)
 		return -1;
 	}
 	/* otherwise calc new bid/ask pair */
-	if (fabsd32(q.b - last.b) <= qunt && fabsd32(q.a - last.a) <= qunt) {
+	if (fabsd32(q.b - st->last.b) <= qunt &&
+	    fabsd32(q.a - st->last.a) <= qunt) {
 		if (rptp) {
 			char buf[256U];
 			size_t len = 0U;
 			fwrite(ln, 1, pre - ln, stdout);
-			len += npxtostr(buf + len, sizeof(buf) - len, last.b);
+			len += npxtostr(buf + len, sizeof(buf) - len, st->last.b);
 			buf[len++] = '\t';
-			len += npxtostr(buf + len, sizeof(buf) - len, last.a);
+			len += npxtostr(buf + len, sizeof(buf) - len, st->last.a);
 			fwrite(buf, 1, len, stdout);
 			fwrite(on, 1, lz - (on - ln), stdout);
 		}
@@ -102,15 +137,14 @@ push_qunt(const char *ln, size_t lz)
 	/* otherwise print */
 	fwrite(ln, 1, lz, stdout);
 	/* and store state */
-	last = q;
+	st->last = q;
 	return 0;
 }
 
 static int
 push_latm(const char *ln, size_t lz)
 {
-	static px_t lasm;
-	static quo_t last;
+	struct ins_s *st;
 	const char *pre;
 	quo_t q;
 	char *on;
@@ -120,9 +154,12 @@ push_latm(const char *ln, size_t lz)
 		return -1;
 	}
 
-	/* instrument name, don't hash him */
-	if (UNLIKELY((on = strchr(++on, '\t')) == NULL)) {
-		return -1;
+	/* instrument name, hash him */
+	with (const char *ins = ++on) {
+		if (UNLIKELY((on = strchr(ins, '\t')) == NULL)) {
+			return -1;
+		}
+		st = find_ins(hash(ins, on - ins));
 	}
 	pre = ++on;
 
@@ -137,14 +174,14 @@ push_latm(const char *ln, size_t lz)
 	}
 
 	/* check against old midpoint */
-	if (lasm >= q.b && lasm <= q.a) {
+	if (st->lasm >= q.b && st->lasm <= q.a) {
 		if (rptp) {
 			char buf[256U];
 			size_t len = 0U;
 			fwrite(ln, 1, pre - ln, stdout);
-			len += npxtostr(buf + len, sizeof(buf) - len, last.b);
+			len += npxtostr(buf + len, sizeof(buf) - len, st->last.b);
 			buf[len++] = '\t';
-			len += npxtostr(buf + len, sizeof(buf) - len, last.a);
+			len += npxtostr(buf + len, sizeof(buf) - len, st->last.a);
 			fwrite(buf, 1, len, stdout);
 			fwrite(on, 1, lz - (on - ln), stdout);
 		}
@@ -153,8 +190,8 @@ push_latm(const char *ln, size_t lz)
 	/* otherwise print */
 	fwrite(ln, 1, lz, stdout);
 	/* and store state */
-	last = q;
-	lasm = (q.a + q.b) / 2.df;
+	st->last = q;
+	st->lasm = (q.a + q.b) / 2.df;
 	return 0;
 }
 
@@ -193,6 +230,8 @@ main(int argc, char *argv[])
 		/* finalise our findings */
 		free(line);
 	}
+	free(insts);
+	hxtbl_fini(&itbl);
 
 out:
 	yuck_free(argi);
@@ -16,55 +16,25 @@
 #include <assert.h>
 #include <ieee754.h>
 #include <math.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #if defined HAVE_DFP754_H
 # include <dfp754.h>
-#elif defined HAVE_DFP_STDLIB_H
-# include <dfp/stdlib.h>
-#else  /* !HAVE_DFP754_H && !HAVE_DFP_STDLIB_H */
-static inline __attribute__((pure, const)) _Decimal32
-fabsd32(_Decimal32 x)
-{
-	return x >= 0 ? x : -x;
-}
-static inline __attribute__((pure, const)) _Decimal64
-fabsd64(_Decimal64 x)
-{
-	return x >= 0 ? x : -x;
-}
 #endif	/* HAVE_DFP754_H */
 #include "dfp754_d32.h"
 #include "dfp754_d64.h"
 #include "tv.h"
+#include "cal.h"
+#include "qd.h"
 #include "nifty.h"
 
-typedef _Decimal32 px_t;
-typedef _Decimal64 qx_t;
 typedef size_t cnt_t;
 #define strtopx		strtod32
 #define pxtostr		d32tostr
 #define strtoqx		strtod64
 #define qxtostr		d64tostr
-
-/* relevant tick dimensions */
-typedef struct {
-	px_t b;
-	px_t a;
-} quo_t;
-
-typedef struct {
-	qx_t b;
-	qx_t a;
-} qty_t;
-
-typedef struct {
-	px_t lo;
-	px_t hi;
-} pxrng_t;
-
-typedef struct {
-	qx_t lo;
-	qx_t hi;
-} qxrng_t;
+#define NANQX		NAND64
 
 static tvu_t intv;
 
@@ -145,620 +115,305 @@ tztostr(char *restrict buf, size_t bsz, const tv_t *rv, size_t nv)
 }
 
 
-static inline __attribute__((pure, const)) tv_t
-min_tv(tv_t t1, tv_t t2)
-{
-	return t1 <= t2 ? t1 : t2;
-}
-
-static inline __attribute__((pure, const)) tv_t
-max_tv(tv_t t1, tv_t t2)
-{
-	return t1 >= t2 ? t1 : t2;
-}
-
-static inline __attribute__((pure, const)) px_t
-min_px(px_t p1, px_t p2)
-{
-	return p1 <= p2 ? p1 : p2;
-}
-
-static inline __attribute__((pure, const)) px_t
-max_px(px_t p1, px_t p2)
-{
-	return p1 >= p2 ? p1 : p2;
-}
-
-static inline __attribute__((pure, const)) qx_t
-min_qx(qx_t q1, qx_t q2)
-{
-	return q1 <= q2 ? q1 : q2;
-}
-
-static inline __attribute__((pure, const)) qx_t
-max_qx(qx_t q1, qx_t q2)
-{
-	return q1 >= q2 ? q1 : q2;
-}
-
-static inline __attribute__((pure, const)) uint32_t
-ilog2(const uint32_t x)
-{
-	return 31U - __builtin_clz(x);
-}
-
-static inline __attribute__((const, pure)) size_t
-pxtoslot(const px_t x)
-{
-	uint32_t xm = decompd32(x).mant;
-	xm <<= __builtin_clz(xm);
-	xm >>= 32U - highbits;
-	xm &= (1U << highbits) - 1U;
-	return xm;
-}
+static void(*prnt_hdr)(FILE*);
+static void(*prnt_cndl)(FILE*, const struct qdc_s*);
+/* print buffer, one per thread */
+static __thread char *buf;
+static size_t bufz;
 
-static inline __attribute__((const, pure)) size_t
-qxtoslot(const qx_t x)
-{
-	uint64_t xm = decompd64(x).mant;
-	/* we're only interested in highbits, so shift to fit */
-	xm = xm >> 32U ?: xm;
-	xm <<= __builtin_clz(xm);
-	xm >>= 32U - highbits;
-	xm &= (1U << highbits) - 1U;
-	return xm;
-}
 
-static inline __attribute__((const, pure)) size_t
-tvtoslot(const tv_t t)
-{
-	unsigned int slot = ilog2(t / NSECS + 1U);
-	/* determine sub slot, if applicable */
-	unsigned int width = (1U << slot);
-	unsigned int base = width - 1U;
-	unsigned int subs;
-
-	/* translate in terms of base */
-	subs = (t - base * NSECS) / USECS << (highbits - 5U);
-	/* divide by width */
-	subs /= width * MSECS;
-
-	slot <<= highbits;
-	slot >>= 5U;
-	slot ^= subs;
-	return slot;
-}
+/* a worker digests a range of lines into its own candle state */
+struct wrk_s {
+	struct qd_s q;
+	/* first candle closed by this worker, possibly incomplete */
+	struct qdc_s head;
+	unsigned int stashp:1;
+	unsigned int headp:1;
+	/* where complete candles go */
+	FILE *out;
 
-static inline __attribute__((const, pure)) size_t
-dprtoslot(const px_t x)
-{
-/* specifically for relative price differences */
-	static unsigned int _pivs[] = {-1U, 10U, 100U, 1000U, 10000U, 100000U};
-	const unsigned int piv = _pivs[highbits >> 2U];
-	static const int minx = -5;
-	bcd32_t dx = decompd32(x);
-	unsigned int slot;
-
-	/* map negatives to 0 */
-	slot = (dx.mant & ~dx.sign);
-	with (size_t magn = (piv - 1U) * (dx.expo - minx)) {
-		for (; slot / piv; slot /= piv, magn += piv - 1U);
-		slot += magn;
-	}
-	/* clamp at 32U */
-	slot |= (slot < (1U << highbits)) - 1U;
-	slot &= (1U << highbits) - 1U;
-	return slot;
-}
+	/* line range, and the metronome of the line before it */
+	const char *beg;
+	const char *end;
+	tv_t seed;
+	pthread_t thr;
+};
 
-static inline __attribute__((const, pure)) size_t
-dqrtoslot(const qx_t x)
-{
-/* specifically for relative quantity differences */
-	static unsigned int _pivs[] = {-1U, 10U, 100U, 1000U, 10000U, 100000U};
-	const unsigned int piv = _pivs[highbits >> 2U];
-	static const int minx = -5;
-	bcd64_t dx = decompd64(x);
-	unsigned int slot;
-
-	with (size_t magn = (piv - 1U) * (dx.expo - minx)) {
-		for (slot = dx.mant; slot / piv; slot /= piv, magn += piv - 1U);
-		slot += magn;
-	}
-	/* clamp at 32U */
-	slot |= (slot < (1U << highbits)) - 1U;
-	slot &= (1U << highbits) - 1U;
-	/* split slots in halves to cope with negatives
-	 * this is 16 +/- slot/2  the +/- depending on dx.sign */
-	slot = (dx.sign ^ slot) + (1U << highbits);
-	slot >>= 1U;
-	return slot;
-}
+/* number of candles printed so far */
+static size_t ncndl;
 
-
-/* next candle time */
-static tv_t nxct;
-
-static tv_t _1st = NATV;
-static tv_t last;
-
-static char cont[64];
-static size_t conz;
-
-/* stats */
-static union {
-	cnt_t start[0U];
-
-#define MAKE_SLOTS(n)				\
-	struct {				\
-		cnt_t dlt[1U << (n)];		\
-		cnt_t bid[1U << (n)];		\
-		cnt_t ask[1U << (n)];		\
-		cnt_t bsz[1U << (n)];		\
-		cnt_t asz[1U << (n)];		\
-		cnt_t spr[1U << (n)];		\
-		cnt_t rsp[1U << (n)];		\
-		cnt_t imb[1U << (n)];		\
-		cnt_t rim[1U << (n)];		\
-						\
-		tv_t tlo[1U << (n)];		\
-		tv_t thi[1U << (n)];		\
-						\
-		px_t bhi[1U << (n)];		\
-		px_t ahi[1U << (n)];		\
-		px_t blo[1U << (n)];		\
-		px_t alo[1U << (n)];		\
-		px_t shi[1U << (n)];		\
-		px_t slo[1U << (n)];		\
-		px_t rhi[1U << (n)];		\
-		px_t rlo[1U << (n)];		\
-						\
-		qx_t Bhi[1U << (n)];		\
-		qx_t Ahi[1U << (n)];		\
-		qx_t Blo[1U << (n)];		\
-		qx_t Alo[1U << (n)];		\
-		qx_t Ihi[1U << (n)];		\
-		qx_t Ilo[1U << (n)];		\
-		qx_t Rhi[1U << (n)];		\
-		qx_t Rlo[1U << (n)];		\
-	} _##n
-
-	MAKE_SLOTS(0);
-	MAKE_SLOTS(5);
-	MAKE_SLOTS(9);
-	MAKE_SLOTS(13);
-	MAKE_SLOTS(17);
-	MAKE_SLOTS(21);
-} cnt;
-
-static cnt_t *dlt;
-static cnt_t *bid;
-static cnt_t *ask;
-static cnt_t *bsz;
-static cnt_t *asz;
-static cnt_t *spr;
-static cnt_t *rsp;
-static cnt_t *imb;
-static cnt_t *rim;
-static tv_t *tlo;
-static tv_t *thi;
-static px_t *blo;
-static px_t *bhi;
-static px_t *alo;
-static px_t *ahi;
-static qx_t *Blo;
-static qx_t *Bhi;
-static qx_t *Alo;
-static qx_t *Ahi;
-static px_t *slo;
-static px_t *shi;
-static px_t *rlo;
-static px_t *rhi;
-static qx_t *Ilo;
-static qx_t *Ihi;
-static qx_t *Rlo;
-static qx_t *Rhi;
-static size_t cntz;
-
-static void(*prnt_cndl)(void);
-static char buf[sizeof(cnt)];
-
-static tv_t
-next_cndl(tv_t t)
+static void
+emit_cndl(FILE *out, const struct qdc_s *c)
 {
-	struct tm *tm;
-	time_t u;
-
-	switch (intv.u) {
-	default:
-	case UNIT_NONE:
-		return NATV;
-	case UNIT_NSECS:
-		return (t / intv.t + 1U) * intv.t;
-	case UNIT_SECS:
-		return (t / NSECS / intv.t + 1U) * intv.t * NSECS;
-	case UNIT_DAYS:
-		t /= 24ULL * 60ULL * 60ULL * NSECS;
-		t += intv.t;
-		t *= 24ULL * 60ULL * 60ULL * NSECS;
-		return t;
-	case UNIT_MONTHS:
-	case UNIT_YEARS:
-		break;
+	if (!ncndl++) {
+		prnt_hdr(out);
 	}
-
-	u = t / NSECS;
-	tm = gmtime(&u);
-	tm->tm_mday = 1;
-	tm->tm_yday = 0;
-	tm->tm_hour = 0;
-	tm->tm_min = 0;
-	tm->tm_sec = 0;
-
-	switch (intv.u) {
-	case UNIT_MONTHS:
-		*tm = (struct tm){
-			.tm_year = tm->tm_year,
-			.tm_mon = tm->tm_mon + intv.t,
-			.tm_mday = 1,
-		};
-		break;
-	case UNIT_YEARS:
-		*tm = (struct tm){
-			.tm_year = tm->tm_year + intv.t,
-			.tm_mon = 0,
-			.tm_mday = 1,
-		};
-		break;
-	}
-	return mktime(tm) * NSECS;
+	prnt_cndl(out, c);
+	return;
 }
 
 static void
-rset_cndl(void)
+clos_cndl(void *clo, const struct qdc_s *c)
 {
-	/* just reset all stats pages */
-	memset(cnt.start, 0, cntz);
-	memset(tlo, -1, (1U << highbits) * sizeof(*tlo));
+	struct wrk_s *w = clo;
+
+	if (w->stashp && !w->headp) {
+		/* keep the head candle for stitching, HEAD is still empty */
+		qdc_merge(&w->head, c);
+		w->head.nxct = c->nxct;
+		w->head._1st = c->_1st;
+		w->head.last = c->last;
+		memcpy(w->head.cont, c->cont, w->head.conz = c->conz);
+		w->headp = 1U;
+	} else if (w->stashp) {
+		/* complete candles in the middle, no header */
+		prnt_cndl(w->out, c);
+	} else {
+		emit_cndl(w->out, c);
+	}
 	return;
 }
 
 static int
-push_init(char *ln, size_t UNUSED(lz))
+make_wrk(struct wrk_s *w)
 {
-	size_t iz;
-	char *on;
-
-	/* instrument name, don't hash him */
-	if (UNLIKELY((on = strchr(ln, '\t')) == NULL)) {
-		return -1;
-	}
-	iz = on++ - ln;
-
-	/* snarf quotes */
-	if (!strtopx(on, &on) || *on++ != '\t' ||
-	    !strtopx(on, &on) || (*on != '\t' && *on != '\n')) {
-		return -1;
-	}
-
-	memcpy(cont, ln, conz = iz);
-	return 0;
+	w->q.intv = intv;
+	w->q.bits = highbits;
+	w->q.elapsp = elapsp;
+	w->q.cndl = clos_cndl;
+	w->q.clo = w;
+	return qd_init(&w->q);
 }
 
 static int
-push_beef(char *ln, size_t lz)
+push_beef(struct wrk_s *w, char *ln, size_t UNUSED(lz))
 {
-	size_t acc;
 	tv_t t;
-	quo_t q;
-	qty_t Q;
+	px_t b, a;
+	qx_t bq = NANQX, aq = NANQX;
+	const char *ins;
+	size_t iz;
 	char *on;
-	int rc = 0;
 
 	/* metronome is up first */
 	if (UNLIKELY((t = strtotv(ln, &on)) == NATV)) {
 		return -1;
 	} else if (*on++ != '\t') {
 		return -1;
-	} else if (t < last) {
-		fputs("Warning: non-chronological\n", stderr);
-		rc = -1;
-		goto out;
-	} else if (UNLIKELY(t > nxct)) {
-		prnt_cndl();
-		rset_cndl();
-		nxct = next_cndl(t);
-		_1st = last = t;
-		if (UNLIKELY(push_init(on, lz - (on - ln)) < 0)) {
-			return -1;
-		}
 	}
 
 	/* instrument name, don't hash him */
-	if (UNLIKELY((on = strchr(on, '\t')) == NULL)) {
+	if (UNLIKELY((on = strchr(ins = on, '\t')) == NULL)) {
 		return -1;
 	}
-	on++;
+	iz = on++ - ins;
 
 	/* snarf quotes */
-	if (!(q.b = strtopx(on, &on)) || *on++ != '\t' ||
-	    !(q.a = strtopx(on, &on)) || (*on != '\t' && *on != '\n')) {
+	if (!(b = strtopx(on, &on)) || *on++ != '\t' ||
+	    !(a = strtopx(on, &on)) || (*on != '\t' && *on != '\n')) {
 		return -1;
 	}
 
-	/* measure time */
-	acc = !elapsp ? 1ULL : (t - last);
-
-	/* snarf quantities */
-	if (*on == '\t' &&
-	    ((Q.b = strtoqx(++on, &on)) || *on == '\t') &&
-	    ((Q.a = strtoqx(++on, &on)) || *on == '\n')) {
-		size_t bm = qxtoslot(Q.b);
-		size_t am = qxtoslot(Q.a);
-
-		bsz[bm] += acc;
-		asz[am] += acc;
-
-		Blo[bm] = min_qx(Blo[bm] ?: __DEC64_MOST_POSITIVE__, Q.b);
-		Bhi[bm] = max_qx(Bhi[bm], Q.b);
-		Alo[am] = min_qx(Alo[am] ?: __DEC64_MOST_POSITIVE__, Q.a);
-		Ahi[am] = max_qx(Ahi[am], Q.a);
-
-		/* imbalance */
-		with (qx_t Qm = Q.b + Q.a, d = Q.a - Q.b,
-		      I = quantized64(2.dd * d / Qm, 0.00000dd),
-		      R = quantized64(d / (Qm + fabsd64(d)), 0.00000dd)) {
-			size_t Im = dqrtoslot(I);
-			size_t Rm = dqrtoslot(R);
-
-			imb[Im] += acc;
-
-			Ilo[Im] = min_qx(Ilo[Im] ?: __DEC64_MOST_POSITIVE__, I);
-			Ihi[Im] = max_qx(Ihi[Im] ?: __DEC64_MOST_NEGATIVE__, I);
-
-			rim[Rm] += acc;
-
-			Rlo[Rm] = min_qx(Rlo[Rm] ?: __DEC64_MOST_POSITIVE__, R);
-			Rhi[Rm] = max_qx(Rhi[Rm] ?: __DEC64_MOST_NEGATIVE__, R);
-		}
-	}
-
-	{
-		size_t bm = pxtoslot(q.b);
-		size_t am = pxtoslot(q.a);
-
-		bid[bm] += acc;
-		ask[am] += acc;
-
-		blo[bm] = min_px(blo[bm] ?: __DEC32_MOST_POSITIVE__, q.b);
-		bhi[bm] = max_px(bhi[bm], q.b);
-		alo[am] = min_px(alo[am] ?: __DEC32_MOST_POSITIVE__, q.a);
-		ahi[am] = max_px(ahi[am], q.a);
+	/* snarf quantities, both or none */
+	if (!(*on == '\t' &&
+	      ((bq = strtoqx(++on, &on)) || *on == '\t') &&
+	      ((aq = strtoqx(++on, &on)) || *on == '\n'))) {
+		bq = aq = NANQX;
 	}
 
-	with (px_t m = fabsd32(q.b + q.a), d = (q.a - q.b),
-	      s = quantized32(2.df * d / m, 0.00000df),
-	      r = quantized32(d / (m + fabsd32(d)), 0.00000df)) {
-		size_t sm = dprtoslot(s);
-		size_t rm = dprtoslot(r);
-
-		spr[sm] += acc;
-
-		slo[sm] = min_px(slo[sm] ?: __DEC32_MOST_POSITIVE__, s);
-		shi[sm] = max_px(shi[sm], s);
-
-		rsp[rm] += acc;
-
-		rlo[rm] = min_px(rlo[rm] ?: __DEC32_MOST_POSITIVE__, r);
-		rhi[rm] = max_px(rhi[rm], r);
+	if (UNLIKELY(qd_push(&w->q, t, ins, iz, b, a, bq, aq) < 0)) {
+		fputs("Warning: non-chronological\n", stderr);
+		return -1;
 	}
+	return 0;
+}
 
-	with (tv_t dt = t - last) {
-		size_t slot = tvtoslot(dt);
-
-		dlt[slot] += acc;
+static void
+prnt_hdr_mtrx(FILE *out)
+{
+	static const char hdr[] = "cndl\tccy\tdimen\tmetric";
+	size_t len;
 
-		tlo[slot] = min_tv(tlo[slot], dt);
-		thi[slot] = max_tv(thi[slot], dt);
+	len = (memcpy(buf, hdr, strlenof(hdr)), strlenof(hdr));
+	for (size_t i = 0U; i < (1U << highbits); i++) {
+		buf[len++] = '\t';
+		buf[len++] = 'v';
+		len += snprintf(buf + len, bufz - len, "%zu", i);
 	}
-
-out:
-	/* and store state */
-	last = t;
-	return rc;
+	buf[len++] = '\n';
+	fwrite(buf, sizeof(*buf), len, out);
+	return;
 }
 
 static void
-prnt_cndl_mtrx(void)
+prnt_cndl_mtrx(FILE *out, const struct qdc_s *c)
 {
-	static size_t ncndl;
 	size_t len = 0U;
 
-	if (UNLIKELY(_1st == NATV)) {
-		return;
-	}
-
-	switch (ncndl++) {
-		static const char hdr[] = "cndl\tccy\tdimen\tmetric";
-	default:
-		break;
-	case 0U:
-		len = (memcpy(buf, hdr, strlenof(hdr)), strlenof(hdr));
-		for (size_t i = 0U; i < (1U << highbits); i++) {
-			buf[len++] = '\t';
-			buf[len++] = 'v';
-			len += snprintf(buf + len, sizeof(buf) - len, "%zu", i);
-		}
-		buf[len++] = '\n';
-		fwrite(buf, sizeof(*buf), len, stdout);
-		len = 0U;
-		break;
-	}
-
 	/* delta t */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	/* type t */
 	buf[len++] = '\t';
 	buf[len++] = 't';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, dlt, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->t.cnt, c->t.n);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	/* type t */
 	buf[len++] = '\t';
 	buf[len++] = 't';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += tztostr(buf + len, sizeof(buf) - len, tlo, 1U << highbits);
+	len += tztostr(buf + len, bufz - len, c->t.lo, c->t.n);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	/* type t */
 	buf[len++] = '\t';
 	buf[len++] = 't';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += tztostr(buf + len, sizeof(buf) - len, thi, 1U << highbits);
+	len += tztostr(buf + len, bufz - len, c->t.hi, c->t.n);
 	buf[len++] = '\n';
 
 
 	/* bid */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'b';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, bid, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->bid, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'b';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += pztostr(buf + len, sizeof(buf) - len, blo, 1U << highbits);
+	len += pztostr(buf + len, bufz - len, c->blo, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'b';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += pztostr(buf + len, sizeof(buf) - len, bhi, 1U << highbits);
+	len += pztostr(buf + len, bufz - len, c->bhi, 1U << highbits);
 	buf[len++] = '\n';
 
 
 	/* ask */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'a';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, ask, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->ask, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'a';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += pztostr(buf + len, sizeof(buf) - len, alo, 1U << highbits);
+	len += pztostr(buf + len, bufz - len, c->alo, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'a';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += pztostr(buf + len, sizeof(buf) - len, ahi, 1U << highbits);
+	len += pztostr(buf + len, bufz - len, c->ahi, 1U << highbits);
 	buf[len++] = '\n';
 
 
 	/* spr */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 's';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, spr, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->spr, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 's';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += pztostr(buf + len, sizeof(buf) - len, slo, 1U << highbits);
+	len += pztostr(buf + len, bufz - len, c->slo, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 's';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += pztostr(buf + len, sizeof(buf) - len, shi, 1U << highbits);
+	len += pztostr(buf + len, bufz - len, c->shi, 1U << highbits);
 	buf[len++] = '\n';
 
-	/* renormalised spr */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	/* renormalised c->spr */
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'r';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, rsp, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->rsp, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'r';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += pztostr(buf + len, sizeof(buf) - len, rlo, 1U << highbits);
+	len += pztostr(buf + len, bufz - len, c->rlo, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'r';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += pztostr(buf + len, sizeof(buf) - len, rhi, 1U << highbits);
+	len += pztostr(buf + len, bufz - len, c->rhi, 1U << highbits);
 	buf[len++] = '\n';
 
 	/* check if there's quantities */
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (bsz[i]) {
+		if (c->bsz[i]) {
 			goto Bsz;
 		}
 	}
@@ -766,39 +421,39 @@ prnt_cndl_mtrx(void)
 
 Bsz:
 	/* bid quantities */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'B';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, bsz, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->bsz, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'B';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += qztostr(buf + len, sizeof(buf) - len, Blo, 1U << highbits);
+	len += qztostr(buf + len, bufz - len, c->Blo, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'B';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += qztostr(buf + len, sizeof(buf) - len, Bhi, 1U << highbits);
+	len += qztostr(buf + len, bufz - len, c->Bhi, 1U << highbits);
 	buf[len++] = '\n';
 
-	/* check for ask quantities */
+	/* check for c->ask quantities */
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (asz[i]) {
+		if (c->asz[i]) {
 			goto Asz;
 		}
 	}
@@ -806,340 +461,565 @@ Bsz:
 
 Asz:
 	/* ask quantities */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'A';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, asz, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->asz, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'A';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += qztostr(buf + len, sizeof(buf) - len, Alo, 1U << highbits);
+	len += qztostr(buf + len, bufz - len, c->Alo, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'A';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += qztostr(buf + len, sizeof(buf) - len, Ahi, 1U << highbits);
+	len += qztostr(buf + len, bufz - len, c->Ahi, 1U << highbits);
 	buf[len++] = '\n';
 
 	/* imbalance */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'I';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, imb, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->imb, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'I';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += qztostr(buf + len, sizeof(buf) - len, Ilo, 1U << highbits);
+	len += qztostr(buf + len, bufz - len, c->Ilo, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'I';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += qztostr(buf + len, sizeof(buf) - len, Ihi, 1U << highbits);
+	len += qztostr(buf + len, bufz - len, c->Ihi, 1U << highbits);
 	buf[len++] = '\n';
 
 	/* renormalised imbalance */
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'R';
 	buf[len++] = '\t';
 	buf[len++] = 'n';
-	len += zztostr(buf + len, sizeof(buf) - len, rim, 1U << highbits);
+	len += zztostr(buf + len, bufz - len, c->rim, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'R';
 	buf[len++] = '\t';
 	buf[len++] = 'L';
-	len += qztostr(buf + len, sizeof(buf) - len, Rlo, 1U << highbits);
+	len += qztostr(buf + len, bufz - len, c->Rlo, 1U << highbits);
 	buf[len++] = '\n';
 
-	len += tvutostr(buf + len, sizeof(buf) - len, (tvu_t){nxct, intv.u});
+	len += tvutostr(buf + len, bufz - len, (tvu_t){c->nxct, intv.u});
 	buf[len++] = '\t';
-	len += (memcpy(buf + len, cont, conz), conz);
+	len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 	buf[len++] = '\t';
 	buf[len++] = 'R';
 	buf[len++] = '\t';
 	buf[len++] = 'H';
-	len += qztostr(buf + len, sizeof(buf) - len, Rhi, 1U << highbits);
+	len += qztostr(buf + len, bufz - len, c->Rhi, 1U << highbits);
 	buf[len++] = '\n';
 
 prnt:
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 	return;
 }
 
 static void
-prnt_cndl_molt(void)
+prnt_hdr_molt(FILE *out)
 {
-	static size_t ncndl;
-	size_t len = 0U;
+	static const char hdr[] = "cndl\tccy\tdimen\tlo\thi\tcnt\n";
 
-	if (UNLIKELY(_1st == NATV)) {
-		return;
-	}
+	fwrite(hdr, sizeof(*hdr), strlenof(hdr), out);
+	return;
+}
 
-	switch (ncndl++) {
-		static const char hdr[] = "cndl\tccy\tdimen\tlo\thi\tcnt\n";
-	default:
-		break;
-	case 0U:
-		fwrite(hdr, sizeof(*hdr), strlenof(hdr), stdout);
-		break;
-	}
+static void
+prnt_cndl_molt(FILE *out, const struct qdc_s *c)
+{
+	size_t len = 0U;
 
 	/* delta t */
 	len = 0U;
-	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!dlt[i]) {
+	for (size_t i = 0U, n = c->t.n; i < n; i++) {
+		if (!c->t.cnt[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		/* type t */
 		buf[len++] = '\t';
 		buf[len++] = 't';
 		buf[len++] = '\t';
-		len += tvtostr(buf + len, sizeof(buf) - len, tlo[i]);
+		len += tvtostr(buf + len, bufz - len, c->t.lo[i]);
 		buf[len++] = '\t';
-		len += tvtostr(buf + len, sizeof(buf) - len, thi[i]);
+		len += tvtostr(buf + len, bufz - len, c->t.hi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, dlt[i]);
+		len += ztostr(buf + len, bufz - len, c->t.cnt[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 
 	/* bid */
 	len = 0U;
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!bid[i]) {
+		if (!c->bid[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		buf[len++] = '\t';
 		buf[len++] = 'b';
 		buf[len++] = '\t';
-		len += pxtostr(buf + len, sizeof(buf) - len, blo[i]);
+		len += pxtostr(buf + len, bufz - len, c->blo[i]);
 		buf[len++] = '\t';
-		len += pxtostr(buf + len, sizeof(buf) - len, bhi[i]);
+		len += pxtostr(buf + len, bufz - len, c->bhi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, bid[i]);
+		len += ztostr(buf + len, bufz - len, c->bid[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 
 	/* ask */
 	len = 0U;
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!ask[i]) {
+		if (!c->ask[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		buf[len++] = '\t';
 		buf[len++] = 'a';
 		buf[len++] = '\t';
-		len += pxtostr(buf + len, sizeof(buf) - len, alo[i]);
+		len += pxtostr(buf + len, bufz - len, c->alo[i]);
 		buf[len++] = '\t';
-		len += pxtostr(buf + len, sizeof(buf) - len, ahi[i]);
+		len += pxtostr(buf + len, bufz - len, c->ahi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, ask[i]);
+		len += ztostr(buf + len, bufz - len, c->ask[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 
 	/* spr */
 	len = 0U;
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!spr[i]) {
+		if (!c->spr[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		buf[len++] = '\t';
 		buf[len++] = 's';
 		buf[len++] = '\t';
-		len += pxtostr(buf + len, sizeof(buf) - len, slo[i]);
+		len += pxtostr(buf + len, bufz - len, c->slo[i]);
 		buf[len++] = '\t';
-		len += pxtostr(buf + len, sizeof(buf) - len, shi[i]);
+		len += pxtostr(buf + len, bufz - len, c->shi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, spr[i]);
+		len += ztostr(buf + len, bufz - len, c->spr[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 
 	/* rsp */
 	len = 0U;
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!rsp[i]) {
+		if (!c->rsp[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		buf[len++] = '\t';
 		buf[len++] = 'r';
 		buf[len++] = '\t';
-		len += pxtostr(buf + len, sizeof(buf) - len, rlo[i]);
+		len += pxtostr(buf + len, bufz - len, c->rlo[i]);
 		buf[len++] = '\t';
-		len += pxtostr(buf + len, sizeof(buf) - len, rhi[i]);
+		len += pxtostr(buf + len, bufz - len, c->rhi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, rsp[i]);
+		len += ztostr(buf + len, bufz - len, c->rsp[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 
 	/* bid quantities */
 	len = 0U;
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!bsz[i]) {
+		if (!c->bsz[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		buf[len++] = '\t';
 		buf[len++] = 'B';
 		buf[len++] = '\t';
-		len += qxtostr(buf + len, sizeof(buf) - len, Blo[i]);
+		len += qxtostr(buf + len, bufz - len, c->Blo[i]);
 		buf[len++] = '\t';
-		len += qxtostr(buf + len, sizeof(buf) - len, Bhi[i]);
+		len += qxtostr(buf + len, bufz - len, c->Bhi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, bsz[i]);
+		len += ztostr(buf + len, bufz - len, c->bsz[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 
 	/* ask quantities */
 	len = 0U;
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!asz[i]) {
+		if (!c->asz[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		buf[len++] = '\t';
 		buf[len++] = 'A';
 		buf[len++] = '\t';
-		len += qxtostr(buf + len, sizeof(buf) - len, Alo[i]);
+		len += qxtostr(buf + len, bufz - len, c->Alo[i]);
 		buf[len++] = '\t';
-		len += qxtostr(buf + len, sizeof(buf) - len, Ahi[i]);
+		len += qxtostr(buf + len, bufz - len, c->Ahi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, asz[i]);
+		len += ztostr(buf + len, bufz - len, c->asz[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 
 	/* imbalance */
 	len = 0U;
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!imb[i]) {
+		if (!c->imb[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		buf[len++] = '\t';
 		buf[len++] = 'I';
 		buf[len++] = '\t';
-		len += qxtostr(buf + len, sizeof(buf) - len, Ilo[i]);
+		len += qxtostr(buf + len, bufz - len, c->Ilo[i]);
 		buf[len++] = '\t';
-		len += qxtostr(buf + len, sizeof(buf) - len, Ihi[i]);
+		len += qxtostr(buf + len, bufz - len, c->Ihi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, imb[i]);
+		len += ztostr(buf + len, bufz - len, c->imb[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 
 	/* renormalised imbalance */
 	len = 0U;
 	for (size_t i = 0U, n = 1U << highbits; i < n; i++) {
-		if (!rim[i]) {
+		if (!c->rim[i]) {
 			continue;
 		}
 		/* otherwise */
-		len += tvutostr(buf + len, sizeof(buf) - len,
-				(tvu_t){nxct, intv.u});
+		len += tvutostr(buf + len, bufz - len,
+				(tvu_t){c->nxct, intv.u});
 		buf[len++] = '\t';
-		len += (memcpy(buf + len, cont, conz), conz);
+		len += (memcpy(buf + len, c->cont, c->conz), c->conz);
 		buf[len++] = '\t';
 		buf[len++] = 'R';
 		buf[len++] = '\t';
-		len += qxtostr(buf + len, sizeof(buf) - len, Rlo[i]);
+		len += qxtostr(buf + len, bufz - len, c->Rlo[i]);
 		buf[len++] = '\t';
-		len += qxtostr(buf + len, sizeof(buf) - len, Rhi[i]);
+		len += qxtostr(buf + len, bufz - len, c->Rhi[i]);
 		buf[len++] = '\t';
-		len += ztostr(buf + len, sizeof(buf) - len, rim[i]);
+		len += ztostr(buf + len, bufz - len, c->rim[i]);
 		buf[len++] = '\n';
 	}
-	fwrite(buf, sizeof(*buf), len, stdout);
+	fwrite(buf, sizeof(*buf), len, out);
 	return;
 }
 
 
+static int
+offline(void)
+{
+	static struct wrk_s w;
+	char *line = NULL;
+	size_t llen = 0UL;
+	ssize_t nrd;
+
+	if (UNLIKELY(make_wrk(&w) < 0 || (buf = malloc(bufz)) == NULL)) {
+		serror("\
+Error: cannot allocate candle state");
+		qd_fini(&w.q);
+		return -1;
+	}
+	w.out = stdout;
+
+	while ((nrd = getline(&line, &llen, stdin)) > 0) {
+		(void)push_beef(&w, line, nrd);
+	}
+
+	/* finalise our findings */
+	free(line);
+
+	/* print the final candle */
+	qd_flush(&w.q);
+	qd_fini(&w.q);
+	free(buf);
+	return 0;
+}
+
+static char*
+mmap_stdin(size_t *fz)
+{
+	struct stat st;
+	void *fp;
+
+	if (fstat(STDIN_FILENO, &st) < 0 || !S_ISREG(st.st_mode)) {
+		return NULL;
+	} else if (st.st_size <= 0) {
+		return NULL;
+	}
+	fp = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, STDIN_FILENO, 0);
+	if (UNLIKELY(fp == MAP_FAILED)) {
+		return NULL;
+	}
+	*fz = st.st_size;
+	return fp;
+}
+
+static tv_t
+snarf_seed(const char *ln)
+{
+/* return LN's metronome if push_beef() would take LN */
+	char *on;
+	tv_t t;
+
+	if ((t = strtotv(ln, &on)) == NATV || *on++ != '\t') {
+		return NATV;
+	} else if ((on = strchr(on, '\t')) == NULL) {
+		return NATV;
+	} else if (!strtopx(++on, &on) || *on++ != '\t' ||
+		   !strtopx(on, &on) || (*on != '\t' && *on != '\n')) {
+		return NATV;
+	}
+	return t;
+}
+
+static const char*
+find_seed(tv_t *seed, const char *bof, const char *bp, const char *eof)
+{
+/* find the first line after BP whose predecessor is a well-formed
+ * quote off the candle grid, its candle is then cal_next() of it
+ * and the predecessor's metronome seeds the survival times */
+	for (const char *eol;
+	     (eol = memchr(bp, '\n', eof - bp)) != NULL; bp = eol + 1U) {
+		const char *bol;
+		char ln[4096U];
+		size_t lz;
+		tv_t t;
+
+		for (bol = eol; bol > bof && bol[-1] != '\n'; bol--);
+		lz = eol + 1U - bol;
+		lz = lz < sizeof(ln) ? lz : sizeof(ln) - 1U;
+		memcpy(ln, bol, lz);
+		ln[lz] = '\0';
+
+		if ((t = snarf_seed(ln)) == NATV) {
+			continue;
+		} else if (cal_next(t - 1, intv) != cal_next(t, intv)) {
+			/* on the grid, could go either way */
+			continue;
+		}
+		*seed = t;
+		return eol + 1U;
+	}
+	return eof;
+}
+
+static void*
+work(void *clo)
+{
+	struct wrk_s *w = clo;
+	char *line = NULL;
+	size_t llen = 0UL;
+
+	if (UNLIKELY((buf = malloc(bufz)) == NULL)) {
+		return NULL;
+	}
+	for (const char *ln = w->beg, *eol; ln < w->end; ln = eol) {
+		size_t lz;
+
+		if ((eol = memchr(ln, '\n', w->end - ln)) == NULL) {
+			eol = w->end;
+		} else {
+			eol++;
+		}
+		/* lines need to be \nul terminated for our parsers */
+		if ((lz = eol - ln) >= llen) {
+			llen = (lz / 64U + 1U) * 64U;
+			line = realloc(line, llen);
+		}
+		memcpy(line, ln, lz);
+		line[lz] = '\0';
+		(void)push_beef(w, line, lz);
+	}
+	free(line);
+	free(buf);
+	return NULL;
+}
+
+static int
+par(const char *bof, const char *eof, size_t nwrk)
+{
+/* split [BOF, EOF) into NWRK byte ranges and histogram them in parallel,
+ * complete candles are printed by the workers into temporary files,
+ * the head and tail candles of each range are stitched together here */
+	struct wrk_s *w;
+	struct qdc_s *pend = NULL;
+	int rc = 0;
+
+	if (UNLIKELY((w = calloc(nwrk, sizeof(*w))) == NULL)) {
+		return -1;
+	}
+	/* workers must not grow the calendar table underneath each other */
+	cal_fill(NATV);
+	w[0U].beg = bof;
+	for (size_t i = 1U; i < nwrk; i++) {
+		const char *bp = bof + (eof - bof) * i / nwrk;
+
+		bp = bp > w[i - 1U].beg ? bp : w[i - 1U].beg;
+		w[i].beg = find_seed(&w[i].seed, bof, bp, eof);
+		w[i - 1U].end = w[i].beg;
+	}
+	w[nwrk - 1U].end = eof;
+
+	for (size_t i = 0U; i < nwrk; i++) {
+		if (w[i].beg >= w[i].end) {
+			continue;
+		} else if (UNLIKELY(make_wrk(w + i) < 0 ||
+				    qdc_init(&w[i].head, highbits) < 0 ||
+				    (w[i].out = tmpfile()) == NULL)) {
+			serror("\
+Error: cannot set up worker %zu", i);
+			rc = -1;
+			goto out;
+		}
+		w[i].stashp = 1U;
+		if (i) {
+			/* resume the candle of the line before */
+			qd_seed(&w[i].q, w[i].seed);
+		}
+		if (pthread_create(&w[i].thr, NULL, work, w + i)) {
+			/* do it ourselves then */
+			work(w + i);
+			w[i].thr = pthread_self();
+		}
+	}
+	for (size_t i = 0U; i < nwrk; i++) {
+		if (w[i].out && !pthread_equal(w[i].thr, pthread_self())) {
+			pthread_join(w[i].thr, NULL);
+		}
+	}
+
+	/* stitch and print */
+	if (UNLIKELY((buf = malloc(bufz)) == NULL)) {
+		rc = -1;
+		goto out;
+	}
+	for (size_t i = 0U; i < nwrk; i++) {
+		struct qdc_s *h = w[i].headp ? &w[i].head : &w[i].q.c;
+
+		if (w[i].out == NULL) {
+			continue;
+		} else if (h->_1st == NATV) {
+			;
+		} else if (pend == NULL) {
+			pend = h;
+		} else {
+			qdc_merge(pend, h);
+		}
+		if (w[i].headp) {
+			/* PEND is complete now, so are the middle candles */
+			emit_cndl(stdout, pend);
+			pend = w[i].q.c._1st != NATV ? &w[i].q.c : NULL;
+
+			rewind(w[i].out);
+			for (size_t nrd;
+			     (nrd = fread(buf, sizeof(*buf), bufz, w[i].out));) {
+				fwrite(buf, sizeof(*buf), nrd, stdout);
+			}
+		}
+	}
+	if (pend != NULL) {
+		emit_cndl(stdout, pend);
+	}
+	free(buf);
+
+out:
+	for (size_t i = 0U; i < nwrk; i++) {
+		if (w[i].out) {
+			fclose(w[i].out);
+		}
+		qd_fini(&w[i].q);
+		qdc_fini(&w[i].head);
+	}
+	free(w);
+	return rc;
+}
+
+
 #include "quodist.yucc"
 
 int
 main(int argc, char *argv[])
 {
 	static yuck_t argi[1U];
-
+	size_t nwrk = 0U;
 	int rc = 0;
 
 	if (yuck_parse(argi, argc, argv) < 0) {
@@ -1163,95 +1043,43 @@ Error: unknown suffix in interval argument, must be s, m, h, d, w, mo, y.");
 	}
 
 	/* set candle printer */
-	prnt_cndl = !argi->table_flag ? prnt_cndl_molt : prnt_cndl_mtrx;
+	if (!argi->table_flag) {
+		prnt_hdr = prnt_hdr_molt;
+		prnt_cndl = prnt_cndl_molt;
+	} else {
+		prnt_hdr = prnt_hdr_mtrx;
+		prnt_cndl = prnt_cndl_mtrx;
+	}
 
 	/* set resolution */
 	highbits = (argi->verbose_flag << 2U) ^ (argi->verbose_flag > 0U);
 
-	switch (highbits) {
-#define ASS_PTRS(n)				\
-		dlt = cnt._##n.dlt;		\
-		bid = cnt._##n.bid;		\
-		ask = cnt._##n.ask;		\
-		bsz = cnt._##n.bsz;		\
-		asz = cnt._##n.asz;		\
-		spr = cnt._##n.spr;		\
-		imb = cnt._##n.imb;		\
-		rsp = cnt._##n.rsp;		\
-		rim = cnt._##n.rim;		\
-						\
-		tlo = cnt._##n.tlo;		\
-		thi = cnt._##n.thi;		\
-						\
-		blo = cnt._##n.blo;		\
-		bhi = cnt._##n.bhi;		\
-		alo = cnt._##n.alo;		\
-		ahi = cnt._##n.ahi;		\
-		shi = cnt._##n.shi;		\
-		slo = cnt._##n.slo;		\
-		rhi = cnt._##n.rhi;		\
-		rlo = cnt._##n.rlo;		\
-						\
-		Blo = cnt._##n.Blo;		\
-		Bhi = cnt._##n.Bhi;		\
-		Alo = cnt._##n.Alo;		\
-		Ahi = cnt._##n.Ahi;		\
-		Ihi = cnt._##n.Ihi;		\
-		Ilo = cnt._##n.Ilo;		\
-		Rhi = cnt._##n.Rhi;		\
-		Rlo = cnt._##n.Rlo;		\
-						\
-		cntz = sizeof(cnt._##n)
-
-	case 0U:
-		ASS_PTRS(0);
-		break;
-
-	case 5U:
-		ASS_PTRS(5);
-		break;
-
-	case 9U:
-		ASS_PTRS(9);
-		break;
-
-	case 13U:
-		ASS_PTRS(13);
-		break;
-
-	case 17U:
-		ASS_PTRS(17);
-		break;
-
-	case 21U:
-		ASS_PTRS(21);
-		break;
-
-	default:
+	if (!qdc_cntz(highbits)) {
 		errno = 0, serror("\
 Error: verbose flag can only be used one to five times..");
 		rc = 1;
 		goto out;
 	}
+	bufz = qdc_cntz(QD_MAX_BITS);
 
 	/* count events or elapsed times */
 	elapsp = argi->time_flag;
 	ztostr = !elapsp ? zutostr : tvtostr;
 
-	{
-		char *line = NULL;
-		size_t llen = 0UL;
-		ssize_t nrd;
-
-		while ((nrd = getline(&line, &llen, stdin)) > 0) {
-			(void)push_beef(line, nrd);
-		}
+	if (argi->jobs_arg) {
+		nwrk = strtoul(argi->jobs_arg, NULL, 10);
+	}
 
-		/* finalise our findings */
-		free(line);
+	with (size_t fz = 0U) {
+		char *fp;
 
-		/* print the final candle */
-		prnt_cndl();
+		if (nwrk > 1U && (fp = mmap_stdin(&fz)) != NULL) {
+			rc = par(fp, fp + fz, nwrk) < 0;
+			munmap(fp, fz);
+		} else {
+			/* pipes and single jobs go the old way */
+			rc = offline() < 0;
+		}
 	}
 
 out:
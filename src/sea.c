@@ -13,6 +13,9 @@
 #include <sys/time.h>
 #include <time.h>
 #include <assert.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #if defined HAVE_DFP754_H
 # include <dfp754.h>
 #elif defined HAVE_DFP_STDLIB_H
@@ -59,13 +62,47 @@ typedef struct {
 	double m2;
 } stat_t;
 
+/* ticks are binned in blocks of this many */
+#define NBLK	(256U)
+
 /* helper for binning scheme */
 typedef struct {
 	size_t n;
-	size_t *bins;
-	double *fcts;
+	size_t bins[2U];
+	double fcts[2U];
 } sbin_t;
 
+/* quote state and profile bins, one per worker */
+struct wrk_s {
+	tv_t metr;
+	tik_t nxquo;
+	tik_t prquo;
+	stat_t *bins;
+
+	/* ticks and values yet to be binned */
+	size_t nblk;
+	tv_t blkt[NBLK];
+	double blkx[NBLK];
+
+	/* line range */
+	const char *beg;
+	const char *end;
+	pthread_t thr;
+	bool runp;
+};
+
+/* on-disk profile, in host byte order, followed by NBINS + 1 stat_t
+ * as accumulated, the last one being the medians */
+struct prof_hdr_s {
+	char magic[4U];
+	uint32_t smode;
+	uint64_t modulus;
+	uint64_t binwdth;
+	uint64_t nbins;
+};
+
+static const char prof_magic[4U] = {'S', 'E', 'v', '1'};
+
 /* modes, extend here */
 typedef enum {
 	SMODE_DFLT,
@@ -87,6 +124,9 @@ static const char *const smodes[] = {
 static tv_t modulus = 86400U * NSECS;
 static tv_t binwdth = 60U * NSECS;
 static size_t nbins;
+/* their reciprocals, for the bin lookup */
+static double rbinw;
+static double rnbin;
 
 static smode_t smode;
 
@@ -119,6 +159,24 @@ stat_push(stat_t s, double x)
 	return s;
 }
 
+static stat_t
+stat_merge(stat_t a, stat_t b)
+{
+/* pairwise update of Chan, Golub and LeVeque */
+	const double n = a.m0 + b.m0;
+	const double dlt = b.m1 - a.m1;
+
+	if (!b.m0) {
+		return a;
+	} else if (!a.m0) {
+		return b;
+	}
+	a.m2 += b.m2 + dlt * dlt * a.m0 * b.m0 / n;
+	a.m1 += dlt * b.m0 / n;
+	a.m0 = n;
+	return a;
+}
+
 static stat_t
 stat_eval(stat_t s)
 {
@@ -128,39 +186,62 @@ stat_eval(stat_t s)
 }
 
 
+static inline tv_t
+rdiv(tv_t *restrict rem, tv_t t, tv_t d, double r)
+{
+/* T / D using R = 1 / D, the remainder goes to REM */
+	tv_t q = (tv_t)((double)t * r);
+	long long int m = (long long int)(t - q * d);
+
+	/* R is off by an ulp or so, so is Q */
+	for (; UNLIKELY(m < 0); m += d, q--);
+	for (; UNLIKELY(m >= (long long int)d); m -= d, q++);
+	*rem = (tv_t)m;
+	return q;
+}
+
 /* 1-decompos */
-static sbin_t
-stuf_trig(tv_t t)
+static void
+stuf_trig(sbin_t *restrict tgt, const tv_t *t, size_t n)
 {
-	tv_t bin = t / binwdth, sub = t % binwdth;
-	size_t bin1 = (bin + 0U) % nbins;
-	size_t bin2 = (bin + 1U) % nbins;
-	double fac1 = (1 - (double)sub / binwdth);
-	double fac2 = (0 + (double)sub / binwdth);
-	return (sbin_t){2U, (size_t[]){bin1, bin2}, (double[]){fac1, fac2}};
+	for (size_t i = 0U; i < n; i++) {
+		tv_t sub, bin = rdiv(&sub, t[i], binwdth, rbinw);
+		tv_t bin1;
+		double fac2 = (double)sub * rbinw;
+
+		(void)rdiv(&bin1, bin, nbins, rnbin);
+		tgt[i] = (sbin_t){
+			2U,
+			{bin1, bin1 + 1U < nbins ? bin1 + 1U : 0U},
+			{1 - fac2, fac2}
+		};
+	}
+	return;
 }
 
 static sbin_t
 stuf_triv(tv_t t)
 {
-	tv_t bin = (t / binwdth) % nbins;
-	return (sbin_t){1U, (size_t[]){bin}, (double[]){1.}};
+	tv_t sub, bin = rdiv(&sub, t, binwdth, rbinw);
+
+	(void)rdiv(&bin, bin, nbins, rnbin);
+	return (sbin_t){1U, {bin}, {1.}};
 }
 
 
-static tv_t metr;
-static tik_t nxquo = {NATV};
-static tik_t prquo;
 /* contract we're on about */
 static char cont[64];
 static size_t conz;
 /* bins */
 static stat_t *bins;
+/* per-bin multipliers to deseasonalise and to revert */
+static double *dfct;
+static double *efct;
 /* just to have a prototype for quantization */
 static px_t proto;
 
 static int
-push_init(char *ln, size_t UNUSED(lz))
+push_init(struct wrk_s *w, char *ln, size_t UNUSED(lz))
 {
 	px_t bid, ask;
 	const char *ip;
@@ -168,7 +249,7 @@ push_init(char *ln, size_t UNUSED(lz))
 	char *on;
 
 	/* metronome is up first */
-	if (UNLIKELY((metr = strtotv(ln, &on)) == NATV)) {
+	if (UNLIKELY((w->metr = strtotv(ln, &on)) == NATV)) {
 		return -1;
 	}
 
@@ -184,7 +265,7 @@ push_init(char *ln, size_t UNUSED(lz))
 		return -1;
 	}
 	/* we're init'ing, so everything changed */
-	prquo = nxquo = (tik_t){metr, (ask + bid) / 2.df, (ask - bid) / 2.df};
+	w->prquo = w->nxquo = (tik_t){w->metr, (ask + bid) / 2.df, (ask - bid) / 2.df};
 	proto = bid;
 
 	memcpy(cont, ip, conz = iz);
@@ -192,14 +273,14 @@ push_init(char *ln, size_t UNUSED(lz))
 }
 
 static int
-push_beef(char *ln, size_t UNUSED(lz))
+push_beef(struct wrk_s *w, char *ln, size_t UNUSED(lz))
 {
 	px_t bid, ask;
 	tik_t this;
 	char *on;
 
 	/* metronome is up first */
-	if (UNLIKELY((metr = strtotv(ln, &on)) == NATV)) {
+	if (UNLIKELY((w->metr = strtotv(ln, &on)) == NATV)) {
 		return -1;
 	}
 
@@ -214,13 +295,13 @@ push_beef(char *ln, size_t UNUSED(lz))
 		return -1;
 	}
 	/* obtain mid+spr representation */
-	this = (tik_t){metr, (ask + bid) / 2.df, (ask - bid) / 2.df};
+	this = (tik_t){w->metr, (ask + bid) / 2.df, (ask - bid) / 2.df};
 
 	/* see what changed */
-	if (this.m != nxquo.m) {
+	if (this.m != w->nxquo.m) {
 		/* yep */
-		prquo = nxquo;
-		nxquo = this;
+		w->prquo = w->nxquo;
+		w->nxquo = this;
 		return 1;
 	}
 	return 0;
@@ -251,43 +332,52 @@ send_tik(tik_t q)
 
 
 static inline void
-bin_gen(sbin_t sch, double x)
+bin_gen(stat_t *restrict b, sbin_t sch, double x)
 {
 	for (size_t i = 0U; i < sch.n; i++) {
-		STAT_PUSH(bins[sch.bins[i]], sch.fcts[i] * x);
+		STAT_PUSH(b[sch.bins[i]], sch.fcts[i] * x);
 	}
 	return;
 }
 
-static void
-bin_sprd(sbin_t sch)
+static double
+val_sprd(const struct wrk_s *w)
 {
-	bin_gen(sch, (double)fabsd32(nxquo.m - prquo.m) / (double)nxquo.s);
-	return;
+	return (double)fabsd32(w->nxquo.m - w->prquo.m) / (double)w->nxquo.s;
 }
 
-static void
-bin_adev(sbin_t sch)
+static double
+val_adev(const struct wrk_s *w)
 {
-	bin_gen(sch, (double)fabsd32(nxquo.m - prquo.m));
-	return;
+	return (double)fabsd32(w->nxquo.m - w->prquo.m);
 }
 
-static void
-bin_velo(sbin_t sch)
+static double
+val_velo(const struct wrk_s *w)
 {
-	tv_t tdlt = nxquo.t - prquo.t;
-	px_t pdlt = fabsd32(nxquo.m - prquo.m);
-	const double xp = (double)pdlt * NSECS / tdlt;
+	tv_t tdlt = w->nxquo.t - w->prquo.t;
+	px_t pdlt = fabsd32(w->nxquo.m - w->prquo.m);
 
-	bin_gen(sch, xp);
-	return;
+	return (double)pdlt * NSECS / tdlt;
+}
+
+static double
+val_tdlt(const struct wrk_s *w)
+{
+	return (double)(w->nxquo.t - w->prquo.t) / NSECS;
 }
 
 static void
-bin_tdlt(sbin_t sch)
+bin_blk(struct wrk_s *w)
 {
-	bin_gen(sch, (double)(nxquo.t - prquo.t) / NSECS);
+/* bin the block of ticks and values in W */
+	sbin_t sch[NBLK];
+
+	stuf_trig(sch, w->blkt, w->nblk);
+	for (size_t i = 0U; i < w->nblk; i++) {
+		bin_gen(w->bins, sch[i], w->blkx[i]);
+	}
+	w->nblk = 0U;
 	return;
 }
 
@@ -297,42 +387,41 @@ des_gen(sbin_t sch, double x)
 	double s = 0.;
 
 	for (size_t i = 0U; i < sch.n; i++) {
-		s += sch.fcts[i] * x / bins[sch.bins[i]].m1;
+		s += sch.fcts[i] * x * dfct[sch.bins[i]];
 	}
-	s *= bins[nbins].m1;
 	return s;
 }
 
 static px_t
-des_sprd(sbin_t sch)
+des_sprd(const struct wrk_s *w, sbin_t sch)
 {
-	if (LIKELY(nxquo.s > 0.df)) {
-		const double xp = (double)(nxquo.m - prquo.m) / (double)nxquo.s;
-		return (px_t)des_gen(sch, xp) * nxquo.s;
+	if (LIKELY(w->nxquo.s > 0.df)) {
+		const double xp = (double)(w->nxquo.m - w->prquo.m) / (double)w->nxquo.s;
+		return (px_t)des_gen(sch, xp) * w->nxquo.s;
 	}
 	/* don't do him */
-	return nxquo.m - prquo.m;
+	return w->nxquo.m - w->prquo.m;
 }
 
 static px_t
-des_adev(sbin_t sch)
+des_adev(const struct wrk_s *w, sbin_t sch)
 {
-	return (px_t)des_gen(sch, nxquo.m - prquo.m);
+	return (px_t)des_gen(sch, w->nxquo.m - w->prquo.m);
 }
 
 static px_t
-des_velo(sbin_t sch)
+des_velo(const struct wrk_s *w, sbin_t sch)
 {
-	tv_t tdlt = nxquo.t - prquo.t;
-	px_t pdlt = nxquo.m - prquo.m;
+	tv_t tdlt = w->nxquo.t - w->prquo.t;
+	px_t pdlt = w->nxquo.m - w->prquo.m;
 
 	return (px_t)(des_gen(sch, (double)pdlt * NSECS / tdlt) * tdlt / NSECS);
 }
 
 static tv_t
-des_tdlt(sbin_t sch)
+des_tdlt(const struct wrk_s *w, sbin_t sch)
 {
-	return (tv_t)(des_gen(sch, (double)(nxquo.t - prquo.t) / NSECS) * NSECS);
+	return (tv_t)(des_gen(sch, (double)(w->nxquo.t - w->prquo.t) / NSECS) * NSECS);
 }
 
 static inline double
@@ -341,94 +430,240 @@ ens_gen(sbin_t sch, double x)
 	double s = 0.;
 
 	for (size_t i = 0U; i < sch.n; i++) {
-		s += sch.fcts[i] * x * bins[sch.bins[i]].m1;
+		s += sch.fcts[i] * x * efct[sch.bins[i]];
 	}
-	s /= bins[nbins].m1;
 	return s;
 }
 
 static px_t
-ens_sprd(sbin_t sch)
+ens_sprd(const struct wrk_s *w, sbin_t sch)
 {
-	if (LIKELY(nxquo.s > 0.df)) {
-		const double xp = (double)(nxquo.m - prquo.m) / (double)nxquo.s;
-		return (px_t)ens_gen(sch, xp) * nxquo.s;
+	if (LIKELY(w->nxquo.s > 0.df)) {
+		const double xp = (double)(w->nxquo.m - w->prquo.m) / (double)w->nxquo.s;
+		return (px_t)ens_gen(sch, xp) * w->nxquo.s;
 	}
 	/* return him unfiltered */
-	return nxquo.m - prquo.m;
+	return w->nxquo.m - w->prquo.m;
 }
 
 static px_t
-ens_adev(sbin_t sch)
+ens_adev(const struct wrk_s *w, sbin_t sch)
 {
-	return (px_t)ens_gen(sch, nxquo.m - prquo.m);
+	return (px_t)ens_gen(sch, w->nxquo.m - w->prquo.m);
 }
 
 static px_t
-ens_velo(sbin_t sch)
+ens_velo(const struct wrk_s *w, sbin_t sch)
 {
-	tv_t tdlt = nxquo.t - prquo.t;
-	px_t pdlt = nxquo.m - prquo.m;
+	tv_t tdlt = w->nxquo.t - w->prquo.t;
+	px_t pdlt = w->nxquo.m - w->prquo.m;
 
 	return (px_t)(ens_gen(sch, (double)pdlt * NSECS / tdlt) * tdlt / NSECS);
 }
 
 static tv_t
-ens_tdlt(sbin_t sch)
+ens_tdlt(const struct wrk_s *w, sbin_t sch)
 {
-	return (tv_t)(ens_gen(sch, (double)(nxquo.t - prquo.t) / NSECS) * NSECS);
+	return (tv_t)(ens_gen(sch, (double)(w->nxquo.t - w->prquo.t) / NSECS) * NSECS);
 }
 
 
+/* value to bin in the chosen mode */
+static double(*val)(const struct wrk_s*);
+
+static void
+push_prof(struct wrk_s *w, char *ln, size_t lz)
+{
+	if (UNLIKELY(w->nxquo.t == NATV)) {
+		/* still waiting for the first quote */
+		(void)push_init(w, ln, lz);
+	} else if (push_beef(w, ln, lz) > 0) {
+		w->blkt[w->nblk] = w->metr;
+		w->blkx[w->nblk] = val(w);
+		if (UNLIKELY(++w->nblk >= countof(w->blkt))) {
+			bin_blk(w);
+		}
+	}
+	return;
+}
+
 static int
 offline(void)
 {
+	struct wrk_s w = {.nxquo = {NATV}, .bins = bins};
 	char *line = NULL;
 	size_t llen = 0UL;
 	ssize_t nrd;
-	void(*bin)(sbin_t);
 
-	switch (smode) {
-	case SMODE_SPRD:
-		bin = bin_sprd;
-		break;
-	case SMODE_ADEV:
-		bin = bin_adev;
-		break;
-	case SMODE_VELO:
-		bin = bin_velo;
-		break;
-	case SMODE_TDLT:
-		bin = bin_tdlt;
-		break;
-	default:
-		return -1;
+	while ((nrd = getline(&line, &llen, stdin)) > 0) {
+		push_prof(&w, line, nrd);
 	}
-		
-	while ((nrd = getline(&line, &llen, stdin)) > 0 &&
-	       push_init(line, nrd) < 0);
+	bin_blk(&w);
+	/* finalise our findings */
+	free(line);
+	return 0;
+}
 
-	while ((nrd = getline(&line, &llen, stdin)) > 0) {
-		int c = push_beef(line, nrd);
-		sbin_t s;
+static char*
+mmap_stdin(size_t *fz)
+{
+	struct stat st;
+	void *fp;
 
-		if (c <= 0) {
+	if (fstat(STDIN_FILENO, &st) < 0 || !S_ISREG(st.st_mode)) {
+		return NULL;
+	} else if (st.st_size <= 0) {
+		return NULL;
+	}
+	fp = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, STDIN_FILENO, 0);
+	if (UNLIKELY(fp == MAP_FAILED)) {
+		return NULL;
+	}
+	*fz = st.st_size;
+	return fp;
+}
+
+static const char*
+find_seed(tik_t *seed, const char *bp, const char *eof)
+{
+/* find the first line after BP that changes the mid of the quote before
+ * it, the state after that line is then independent of what's before */
+	struct wrk_s tmp = {.nxquo = {NATV}};
+	bool seenp = false;
+
+	for (const char *eol;
+	     (eol = memchr(bp, '\n', eof - bp)) != NULL; bp = eol + 1U) {
+		char ln[4096U];
+		size_t lz = eol + 1U - bp;
+		int c;
+
+		lz = lz < sizeof(ln) ? lz : sizeof(ln) - 1U;
+		memcpy(ln, bp, lz);
+		ln[lz] = '\0';
+
+		if ((c = push_beef(&tmp, ln, lz)) < 0) {
 			continue;
+		} else if (!seenp) {
+			/* just learn the mid */
+			seenp = true;
+		} else if (c > 0) {
+			*seed = tmp.nxquo;
+			return eol + 1U;
 		}
+	}
+	return eof;
+}
 
-		s = stuf_trig(metr);
-		assert(s.n == 2U);
+static void*
+work(void *clo)
+{
+	struct wrk_s *w = clo;
+	char *line = NULL;
+	size_t llen = 0UL;
 
-		bin(s);
+	for (const char *ln = w->beg, *eol; ln < w->end; ln = eol) {
+		size_t lz;
+
+		if ((eol = memchr(ln, '\n', w->end - ln)) == NULL) {
+			eol = w->end;
+		} else {
+			eol++;
+		}
+		/* lines need to be \nul terminated for our parsers */
+		if ((lz = eol - ln) >= llen) {
+			llen = (lz / 64U + 1U) * 64U;
+			line = realloc(line, llen);
+		}
+		memcpy(line, ln, lz);
+		line[lz] = '\0';
+		push_prof(w, line, lz);
 	}
-	/* finalise our findings */
+	bin_blk(w);
 	free(line);
+	return NULL;
+}
+
+static int
+par(const char *bof, const char *eof, size_t nwrk)
+{
+/* split [BOF, EOF) into NWRK byte ranges and bin them in parallel,
+ * each worker has its own bins which are merged afterwards */
+	struct wrk_s *w;
+	int rc = 0;
+
+	if (UNLIKELY((w = calloc(nwrk, sizeof(*w))) == NULL)) {
+		return -1;
+	}
+	w[0U].beg = bof;
+	w[0U].nxquo.t = NATV;
+	w[0U].bins = bins;
+	for (size_t i = 1U; i < nwrk; i++) {
+		const char *bp = bof + (eof - bof) * i / nwrk;
+
+		bp = bp > w[i - 1U].beg ? bp : w[i - 1U].beg;
+		/* start at a line boundary */
+		if ((bp = memchr(bp, '\n', eof - bp)) == NULL) {
+			bp = eof;
+		}
+		w[i].beg = find_seed(&w[i].nxquo, bp, eof);
+		w[i].prquo = w[i].nxquo;
+		w[i].metr = w[i].nxquo.t;
+		w[i - 1U].end = w[i].beg;
+	}
+	w[nwrk - 1U].end = eof;
 
+	for (size_t i = 0U; i < nwrk; i++) {
+		if (w[i].beg >= w[i].end) {
+			continue;
+		} else if (i && UNLIKELY((w[i].bins =
+					  calloc(nbins, sizeof(*bins))) == NULL)) {
+			serror("\
+Error: cannot set up worker %zu", i);
+			rc = -1;
+			break;
+		}
+		w[i].runp = true;
+		if (pthread_create(&w[i].thr, NULL, work, w + i)) {
+			/* do it ourselves then */
+			work(w + i);
+			w[i].thr = pthread_self();
+		}
+	}
+	for (size_t i = 0U; i < nwrk; i++) {
+		if (w[i].runp && !pthread_equal(w[i].thr, pthread_self())) {
+			pthread_join(w[i].thr, NULL);
+		}
+	}
+
+	/* merge bins, in order */
+	for (size_t i = 1U; !rc && i < nwrk; i++) {
+		if (!w[i].runp) {
+			continue;
+		}
+		for (size_t j = 0U; j < nbins; j++) {
+			bins[j] = stat_merge(bins[j], w[i].bins[j]);
+		}
+	}
+	for (size_t i = 1U; i < nwrk; i++) {
+		free(w[i].bins);
+	}
+	free(w);
+	return rc;
+}
+
+static void
+fini_prof(void)
+{
 	/* calc medians */
 	for (size_t i = 0U; i < nbins; i++) {
 		STAT_PUSH(bins[nbins], bins[i].m1);
 	}
+	return;
+}
 
+static int
+prnt_prof(void)
+{
 	/* print seasonality curve */
 	printf("%s\t%lu\t%lu\n", smodes[smode], modulus, binwdth);
 	for (size_t i = 0U; i < nbins; i++) {
@@ -443,13 +678,38 @@ offline(void)
 	return 0;
 }
 
+static int
+wrsea(const char *fn)
+{
+	struct prof_hdr_s hdr = {
+		.smode = smode, .modulus = modulus, .binwdth = binwdth,
+		.nbins = nbins,
+	};
+	FILE *fp;
+	int rc = 0;
+
+	if (UNLIKELY((fp = fopen(fn, "w")) == NULL)) {
+		return -1;
+	}
+	memcpy(hdr.magic, prof_magic, sizeof(hdr.magic));
+	if (UNLIKELY(fwrite(&hdr, sizeof(hdr), 1U, fp) < 1U)) {
+		rc = -1;
+	} else if (UNLIKELY(fwrite(bins, sizeof(*bins), nbins + 1U, fp) <
+			    nbins + 1U)) {
+		rc = -1;
+	}
+	rc = fclose(fp) < 0 ? -1 : rc;
+	return rc;
+}
+
 static int
 desea(bool deseap)
 {
+	struct wrk_s w = {.nxquo = {NATV}};
 	char *line = NULL;
 	size_t llen = 0UL;
 	ssize_t nrd;
-	px_t(*des)(sbin_t);
+	px_t(*des)(const struct wrk_s*, sbin_t);
 	px_t base;
 
 	switch (smode) {
@@ -468,23 +728,23 @@ desea(bool deseap)
 	}
 
 	while ((nrd = getline(&line, &llen, stdin)) > 0 &&
-	       push_init(line, nrd) < 0);
-	send_tik(nxquo);
-	base = nxquo.m;
+	       push_init(&w, line, nrd) < 0);
+	send_tik(w.nxquo);
+	base = w.nxquo.m;
 
 	while ((nrd = getline(&line, &llen, stdin)) > 0) {
-		int c = push_beef(line, nrd);
+		int c = push_beef(&w, line, nrd);
 
 		if (c < 0) {
 			continue;
 		} else if (c > 0) {
-			sbin_t s = stuf_triv(metr);
+			sbin_t s = stuf_triv(w.metr);
 			assert(s.n == 1U);
 
-			base += des(s);
+			base += des(&w, s);
 		}
 
-		send_tik((tik_t){metr, base, nxquo.s});
+		send_tik((tik_t){w.metr, base, w.nxquo.s});
 	}
 	/* finalise our findings */
 	free(line);
@@ -494,10 +754,11 @@ desea(bool deseap)
 static int
 deseaT(bool deseap)
 {
+	struct wrk_s w = {.nxquo = {NATV}};
 	char *line = NULL;
 	size_t llen = 0UL;
 	ssize_t nrd;
-	tv_t(*des)(sbin_t);
+	tv_t(*des)(const struct wrk_s*, sbin_t);
 	tv_t amtr;
 
 	switch (smode) {
@@ -512,23 +773,23 @@ deseaT(bool deseap)
 	}
 
 	while ((nrd = getline(&line, &llen, stdin)) > 0 &&
-	       push_init(line, nrd) < 0);
-	send_tik(nxquo);
-	amtr = metr;
+	       push_init(&w, line, nrd) < 0);
+	send_tik(w.nxquo);
+	amtr = w.metr;
 
 	while ((nrd = getline(&line, &llen, stdin)) > 0) {
-		int c = push_beef(line, nrd);
+		int c = push_beef(&w, line, nrd);
 
 		if (c <= 0) {
 			continue;
 		}
 
-		sbin_t s = stuf_triv(metr);
+		sbin_t s = stuf_triv(w.metr);
 		assert(s.n == 1U);
 
-		amtr += des(s);
+		amtr += des(&w, s);
 
-		send_tik((tik_t){amtr, nxquo.m, nxquo.s});
+		send_tik((tik_t){amtr, w.nxquo.m, w.nxquo.s});
 	}
 	/* finalise our findings */
 	free(line);
@@ -541,6 +802,7 @@ rdsea(const char *fn)
 	static FILE *sp;
 	static char *line;
 	static size_t llen;
+	static bool binp;
 	int rc = 0;
 
 	if (fn == NULL) {
@@ -548,7 +810,27 @@ rdsea(const char *fn)
 		goto rd;
 	} else if (UNLIKELY((sp = fopen(fn, "r")) == NULL)) {
 		return -1;
-	} else if (UNLIKELY(getline(&line, &llen, sp) <= 4U)) {
+	}
+	/* binary profiles first */
+	with (struct prof_hdr_s hdr) {
+		if (fread(&hdr, sizeof(hdr), 1U, sp) < 1U ||
+		    memcmp(hdr.magic, prof_magic, sizeof(hdr.magic))) {
+			/* must be text then */
+			rewind(sp);
+			break;
+		} else if (UNLIKELY(hdr.smode >= NSMODES ||
+				    !hdr.binwdth ||
+				    hdr.nbins != hdr.modulus / hdr.binwdth)) {
+			rc = -1;
+			goto out;
+		}
+		smode = (smode_t)hdr.smode;
+		modulus = hdr.modulus;
+		binwdth = hdr.binwdth;
+		binp = true;
+		return 0;
+	}
+	if (UNLIKELY(getline(&line, &llen, sp) <= 4U)) {
 		rc = -1;
 		goto out;
 	}
@@ -571,6 +853,27 @@ rdsea(const char *fn)
 	/* return so the caller can set up arrays and stuff */
 	return 0;
 rd:
+	if (binp) {
+		/* bins are as accumulated, evaluate them like prnt_prof() */
+		if (UNLIKELY(fread(bins, sizeof(*bins), nbins + 1U, sp) <
+			     nbins + 1U)) {
+			rc = -1;
+			goto out;
+		}
+		for (size_t i = 0U; i < nbins; i++) {
+			stat_t b = stat_eval(bins[i]);
+
+			bins[i].m0 = b.m0;
+			bins[i].m1 = b.m0 > 0 ? b.m1 : 1;
+			bins[i].m2 = sqrt(b.m0 > 0 ? b.m2 : 1);
+		}
+		with (stat_t b = stat_eval(bins[nbins])) {
+			bins[nbins].m0 = b.m0;
+			bins[nbins].m1 = b.m1;
+			bins[nbins].m2 = sqrt(b.m2);
+		}
+		goto scal;
+	}
 	/* now read all them lines */
 	for (size_t i = 0U; i < nbins; i++) {
 		char *on;
@@ -601,6 +904,7 @@ rd:
 		on++;
 		bins[nbins].m2 = sqrt(strtod(on, &on));
 	}
+scal:
 	/* scale by medians */
 	for (size_t i = 0U; i < nbins; i++) {
 		bins[i].m0 /= bins[nbins].m0;
@@ -614,6 +918,21 @@ out:
 	return rc;
 }
 
+static int
+mk_fcts(void)
+{
+/* turn the profile into multipliers, one per bin */
+	if (UNLIKELY((dfct = malloc(2U * nbins * sizeof(*dfct))) == NULL)) {
+		return -1;
+	}
+	efct = dfct + nbins;
+	for (size_t i = 0U; i < nbins; i++) {
+		dfct[i] = bins[nbins].m1 / bins[i].m1;
+		efct[i] = bins[i].m1 / bins[nbins].m1;
+	}
+	return 0;
+}
+
 
 #include "sea.yucc"
 
@@ -681,17 +1000,61 @@ Error: modulus and window parameters result in 0 bins.");
 		rc = 1;
 		goto out;
 	}
+	rbinw = 1. / (double)binwdth;
+	rnbin = 1. / (double)nbins;
 
 	/* get the tbins and bins on the way */
 	bins = calloc(nbins + 1U/*for medians*/, sizeof(*bins));
 
 	if (!argi->nargs) {
-		rc = offline() < 0;
+		size_t nwrk = 1U;
+		size_t fz = 0U;
+		char *fp;
+
+		switch (smode) {
+		case SMODE_SPRD:
+			val = val_sprd;
+			break;
+		case SMODE_ADEV:
+			val = val_adev;
+			break;
+		case SMODE_VELO:
+			val = val_velo;
+			break;
+		case SMODE_TDLT:
+			val = val_tdlt;
+			break;
+		default:
+			rc = 1;
+			goto fr;
+		}
+
+		if (argi->jobs_arg) {
+			nwrk = strtoul(argi->jobs_arg, NULL, 10);
+		}
+		if (nwrk > 1U && (fp = mmap_stdin(&fz)) != NULL) {
+			rc = par(fp, fp + fz, nwrk) < 0;
+			munmap(fp, fz);
+		} else {
+			/* pipes and single jobs go the old way */
+			rc = offline() < 0;
+		}
+		if (rc) {
+			;
+		} else if (fini_prof(), !argi->dump_arg) {
+			rc = prnt_prof() < 0;
+		} else if (UNLIKELY(wrsea(argi->dump_arg) < 0)) {
+			serror("\
+Error: cannot write profile file `%s'", argi->dump_arg);
+			rc = 1;
+		}
 	} else if ((rc = rdsea(NULL)) < 0) {
 		/* pity */
 		serror("\
 Error: cannot process seasonality file `%s'", *argi->args);
 		rc = 1;
+	} else if (UNLIKELY(mk_fcts() < 0)) {
+		rc = 1;
 	} else {
 		switch (smode) {
 		case SMODE_SPRD:
@@ -707,6 +1070,8 @@ Error: cannot process seasonality file `%s'", *argi->args);
 		}
 	}
 
+fr:
+	free(dfct);
 	free(bins);
 
 out:
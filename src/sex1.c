@@ -18,97 +18,24 @@
 #include <time.h>
 #if defined HAVE_DFP754_H
 # include <dfp754.h>
-#elif defined HAVE_DFP_STDLIB_H
-# include <dfp/stdlib.h>
-#else  /* !HAVE_DFP754_H && !HAVE_DFP_STDLIB_H */
-static inline __attribute__((pure, const)) _Decimal32
-fabsd32(_Decimal32 x)
-{
-	return x >= 0 ? x : -x;
-}
-static inline __attribute__((pure, const)) _Decimal64
-fabsd64(_Decimal64 x)
-{
-	return x >= 0 ? x : -x;
-}
-#endif	/* HAVE_DFP754_H || HAVE_DFP_STDLIB_H */
+#endif	/* HAVE_DFP754_H */
 #include "dfp754_d32.h"
 #include "dfp754_d64.h"
-#include "hash.h"
 #include "tv.h"
+#include "bt.h"
 #include "nifty.h"
 
-typedef _Decimal32 px_t;
-typedef _Decimal64 qx_t;
 #define strtopx		strtod32
-#define pxtostr		d32tostr
 #define strtoqx		strtod64
-#define qxtostr		d64tostr
-#define NANPX		NAND32
-#define isnanpx		isnand32
-
-/* relevant tick dimensions */
-typedef struct {
-	tv_t t;
-	px_t b;
-	px_t a;
-} quo_t;
-
-typedef struct {
-	tv_t t;
-	px_t p;
-	qx_t q;
-	/* spread at the time */
-	px_t s;
-	/* quote age */
-	tv_t g;
-} exe_t;
 
-typedef struct {
-	qx_t base;
-	qx_t term;
-	qx_t comb;
-	qx_t comt;
-} acc_t;
+static struct sex_s sex = {
+	.exe_age = 60U * USECS,
+	.qty = 1.dd,
+	.comb = 0.df,
+	.comt = 0.df,
+};
 
-/* regimes
- * these are chosen so that transitions work
- * LONG ^ CLOSE -> SHORT  SHORT ^ CLOSE -> LONG */
-typedef enum {
-	RGM_UNK = 0b0000U,
-	RGM_LONG = 0b0001U,
-	RGM_SHORT = 0b0010U,
-	RGM_CANCEL = 0b0011U,
-	RGM_TIMEOUT = 0b0100U,
-	RGM_LONGRVRS = 0b0101U,
-	RGM_SHORTRVRS = 0b0110U,
-	/* make this one coincide with RGM_CANCEL in the LSBs */
-	RGM_EMERGCLOSE = 0b111U,
-} rgm_t;
 
-
-/* orders */
-typedef struct {
-	tv_t t;
-	rgm_t r;
-	tv_t gtd;
-	qx_t q;
-	px_t lp;
-	px_t tp;
-	px_t sl;
-	/* number of rejected executions */
-	unsigned int nr;
-} ord_t;
-
-static tv_t exe_age = 60U * USECS;
-static qx_t qty = 1.dd;
-static px_t comb = 0.df;
-static px_t comt = 0.df;
-static unsigned int absq;
-static unsigned int maxq;
-static tv_t rtry;
-
-
 static __attribute__((format(printf, 1, 2))) void
 serror(const char *fmt, ...)
 {
@@ -125,410 +52,23 @@ serror(const char *fmt, ...)
 	return;
 }
 
-
+
 static const char *cont;
 static size_t conz;
-static hx_t conx;
-
-static inline char*
-strcws(const char *x)
-{
-	const unsigned char *y;
-	for (y = (const unsigned char*)x; *y >= ' '; y++);
-	return deconst(y);
-}
-
-static hx_t
-strtohx(const char *x, char **on)
-{
-	char *ep;
-	hx_t res;
-
-	ep = strcws(x);
-	res = hash(x, ep - x);
-	if (LIKELY(on != NULL)) {
-		*on = ep;
-	}
-	return res;
-}
-
-static inline __attribute__((const, pure)) tv_t
-max_tv(tv_t t1, tv_t t2)
-{
-	return t1 > t2 ? t1 : t2;
-}
-
-
-static ssize_t
-send_exe(exe_t x)
-{
-/* exe encodes delta to metronome and delay */
-	static const char vexe[] = "EXE\t";
-	static const char vrej[] = "REJ\t";
-	char buf[256U];
-	size_t len;
 
-	len = tvtostr(buf, sizeof(buf), x.t);
-	buf[len++] = '\t';
-	len += (memcpy(buf + len, (isnanpx(x.p) ? vrej : vexe), strlenof(vexe)),
-		strlenof(vexe));
-	len += (memcpy(buf + len, cont, conz), conz);
-	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, x.q);
-	buf[len++] = '\t';
-	len += pxtostr(buf + len, sizeof(buf) - len, x.p);
-	/* spread at the time */
-	buf[len++] = '\t';
-	len += pxtostr(buf + len, sizeof(buf) - len, x.s);
-	/* how long was quote standing */
-	buf[len++] = '\t';
-	len += tvtostr(buf + len, sizeof(buf) - len, x.g);
-	buf[len++] = '\n';
-	return fwrite(buf, 1, len, stdout);
-}
-
-static ssize_t
-send_acc(tv_t t, acc_t a)
+static void
+send_fill(void *UNUSED(clo), exe_t x, acc_t a)
 {
-	static const char verb[] = "ACC\t";
-	char buf[256U];
+	char buf[512U];
 	size_t len;
 
-	len = tvtostr(buf, sizeof(buf), t);
-	buf[len++] = '\t';
-	len += (memcpy(buf + len, verb, strlenof(verb)), strlenof(verb));
-	len += (memcpy(buf + len, cont, conz), conz);
-	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, a.base);
-	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, a.term);
-	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, a.comb);
-	buf[len++] = '\t';
-	len += qxtostr(buf + len, sizeof(buf) - len, a.comt);
-	buf[len++] = '\n';
-	return fwrite(buf, 1, len, stdout);
-}
-
-static exe_t
-try_exec(ord_t o, quo_t q)
-{
-/* this takes an order + quotes and executes it at market price */
-	const tv_t t = max_tv(o.t, q.t);
-	px_t p;
-	px_t s = q.a - q.b;
-	tv_t age = t - q.t;
-
-	switch (o.r) {
-	case RGM_LONG:
-	case RGM_SHORT:
-		if (o.q > 0.dd && (isnanpx(p = q.a) || p > o.lp)) {
-			/* no can do exec */
-			break;
-		} else if (o.q < 0.dd && (isnanpx(p = q.b) || p < o.lp)) {
-			/* no can do exec */
-			break;
-		}
-		return (exe_t){t, p, o.q, s, age};
-
-	case RGM_CANCEL:
-	case RGM_EMERGCLOSE:
-		if (o.q > 0.dd) {
-			p = q.b;
-		} else if (o.q < 0.dd) {
-			p = q.a;
-		} else {
-			break;
-		}
-		return (exe_t){t, p, -o.q, s, age};
-
-	default:
-		/* otherwise do nothing */
-		break;
-	}
-	return (exe_t){t, NANPX, o.q, s, age};
-}
-
-static acc_t
-alloc(acc_t a, exe_t x, px_t cb/*base comm*/, px_t ct/*terms coommission*/)
-{
-/* allocate execution X to account A. */
-	if (LIKELY(!isnanpx(x.p))) {
-		/* calc accounts */
-		a.base += x.q;
-		a.term -= x.q * x.p;
-		a.comb -= fabsd64(x.q) * cb;
-		a.comt -= fabsd64(x.q * x.p) * ct;
-
-		/* quantize to make them look nicer */
-		a.base = quantized64(a.base, 0.00dd);
-		a.term = quantized64(a.term, 0.00dd);
-		a.comb = quantized64(a.comb, 0.00dd);
-		a.comt = quantized64(a.comt, 0.00dd);
-	}
-	return a;
-}
-
-
-static ord_t
-yield_ord(FILE *ofp)
-{
-	static char *line;
-	static size_t llen;
-	char *on;
-	ord_t o;
-	tv_t t;
-
-retry:
-	if (UNLIKELY(getline(&line, &llen, ofp) <= 0)) {
-		free(line);
-		line = NULL;
-		llen = 0UL;
-		return (ord_t){NATV};
-	}
-	/* otherwise snarf the order line */
-	if (UNLIKELY((t = strtotv(line, &on)) == NATV || on++ == line)) {
-		goto retry;
-	}
-	/* read the order */
-	switch (*on) {
-		px_t p;
-		hx_t hx;
-
-	case 'L'/*ONG*/:
-		o = (ord_t){t, RGM_LONG, .q = qty, .lp = INFD32};
-		on += 4U;
-		goto ord;
-	case 'S'/*HORT*/:
-		o = (ord_t){t, RGM_SHORT, .q = -qty, .lp = -INFD32};
-		on += 5U;
-		goto ord;
-	case 'C'/*ANCEL*/:
-	case 'E'/*MERG*/:
-		on = strcws(on);
-		if (LIKELY(*on++ == '\t' && (hx = strtohx(on, &on)))) {
-			/* got a tab and a currency indicator */
-			if (UNLIKELY(hx != conx && conx)) {
-				/* but it's not for us */
-				goto retry;
-			}
-		}
-		o = (ord_t){t, RGM_CANCEL, .q = 0.dd};
-		break;
-	default:
-		goto retry;
-
-	ord:
-		if (UNLIKELY(*on++ != '\t')) {
-			break;
-		}
-		if (UNLIKELY(!(hx = strtohx(on, &on)))) {
-			/* no currency indicator */
-			break;
-		} else if (UNLIKELY(hx != conx && conx)) {
-			/* not for us this one isn't */
-			goto retry;
-		}
-		/* otherwise snarf the limit price */
-		if ((p = strtopx(++on, &on))) {
-			o.gtd = NATV;
-			o.lp = p;
-		}
-		if (*on != '\t' && (on = strchr(on, '\t')) == NULL) {
-			break;
-		}
-		/* oh and a target price */
-		o.tp = strtopx(++on, &on);
-		if (*on != '\t' && (on = strchr(on, '\t')) == NULL) {
-			break;
-		}
-		/* and finally a stop/loss */
-		o.sl = strtopx(++on, &on);
-		if (*on != '\t' && (on = strchr(on, '\t')) == NULL) {
-			break;
-		}
-	}
-	/* tune to exe delay */
-	o.t += exe_age;
-	o.gtd = o.gtd ?: rtry < NATV ? o.t + rtry : rtry;
-	return o;
-}
-
-static quo_t
-yield_quo(FILE *qfp)
-{
-	static char *line;
-	static size_t llen;
-	char *on;
-	quo_t q;
-	hx_t h;
-
-retry:
-	if (UNLIKELY(getline(&line, &llen, qfp) <= 0)) {
-		free(line);
-		line = NULL;
-		llen = 0UL;
-		return (quo_t){NATV};
-	}
-	/* otherwise snarf the quote line */
-	if (UNLIKELY((q.t = strtotv(line, &on)) == NATV || on++ == line)) {
-		goto retry;
-	}
-	/* instrument next */
-	if (UNLIKELY(!(h = strtohx(on, &on)) || *on != '\t')) {
-		goto retry;
-	} else if (UNLIKELY(h != conx && conx)) {
-		goto retry;
-	}
-	with (const char *str = ++on) {
-		q.b = strtopx(str, &on);
-		q.b = on > str ? q.b : NANPX;
-	}
-	with (const char *str = ++on) {
-		q.a = strtopx(str, &on);
-		q.a = on > str ? q.a : NANPX;
-	}
-	return q;
+	len = exetostr(buf, sizeof(buf), cont, conz, x);
+	len += acctostr(buf + len, sizeof(buf) - len, cont, conz, x.t, a);
+	fwrite(buf, 1, len, stdout);
+	return;
 }
 
-static int
-offline(FILE *qfp)
-{
-	acc_t acc = {
-		.base = 0.dd, .term = 0.dd, .comb = 0.dd, .comt = 0.dd,
-	};
-	ord_t _oq[256U], *oq = _oq;
-	size_t ioq = 0U, noq = 0U, zoq = countof(_oq);
-	quo_t q = {NATV, NANPX, NANPX};
-
-	/* we can't do nothing before the first quote, so read that one
-	 * as a reference and fast forward orders beyond that point */
-	for (quo_t newq; (newq = yield_quo(qfp)).t < NATV; q = newq) {
-	ord:
-		if (UNLIKELY(stdin == NULL)) {
-			/* order file is eof'd, skip fetching more */
-			goto exe;
-		}
-		for (ord_t newo;
-		     noq < zoq && (newo = yield_ord(stdin)).t < NATV;
-		     oq[noq++] = newo);
-		if (UNLIKELY(noq < zoq)) {
-			/* out of orders we are */
-			fclose(stdin);
-			stdin = NULL;
-		}
-
-	exe:
-		/* go through order queue and try exec'ing @q */
-		for (size_t i = ioq; i < noq && oq[i].t < newq.t; i++) {
-			exe_t x;
-
-			switch (oq[i].r) {
-			case RGM_UNK:
-				/* don't go for dead orders */
-				continue;
-			case RGM_CANCEL:
-			case RGM_EMERGCLOSE:
-				/* adjust for current account base */
-				oq[i].q = acc.base;
-				/* cancel all pending limit orders */
-				for (size_t j = ioq; j < noq; j++) {
-					if (i == j) {
-						continue;
-					} else if (oq[j].t > oq[i].t) {
-						continue;
-					}
-					/* otherwise shred him */
-					oq[j].r = RGM_UNK;
-				}
-			default:
-				break;
-			}
-			/* adapt cancellations to current accounts */
-			oq[i].q = (oq[i].r & RGM_CANCEL) == RGM_CANCEL
-				? acc.base
-				: oq[i].q;
-			/* try executing him */
-			x = try_exec(oq[i], q);
-			if (isnanpx(x.p) && oq[i].gtd > x.t) {
-				continue;
-			}
-			/* massage execution */
-			x.q -= !absq ||
-				(oq[i].r & RGM_CANCEL) == RGM_CANCEL ||
-				x.q > 0.dd && acc.base > 0.dd ||
-				x.q < 0.dd && acc.base < 0.dd ||
-				isnanpx(x.p)
-				? 0.dd
-				: acc.base;
-			x.q = !maxq || acc.base != x.q ? x.q : 0.dd;
-			/* otherwise send post-trade details */
-			send_exe(x);
-			acc = alloc(acc, x, comb, comt);
-			send_acc(x.t, acc);
-
-			/* check for brackets */
-			if (oq[i].tp) {
-				oq[noq++] = (ord_t){
-					x.t,
-					.r = (rgm_t)(oq[i].r ^ RGM_CANCEL),
-					.gtd = NATV,
-					.q = -x.q,
-					.lp = oq[i].tp,
-					.sl = oq[i].sl,
-				};
-			}
-			/* instead of dequeuing we're just setting
-			 * an order's regime */
-			oq[i].r = RGM_UNK;
-		}
-		/* fast forward dead orders */
-		for (; ioq < noq && !oq[ioq].r; ioq++);
-		/* gc'ing again */
-		if (UNLIKELY(ioq >= zoq / 2U)) {
-			memmove(oq, oq + ioq, (noq - ioq) * sizeof(*oq));
-			noq -= ioq;
-			ioq = 0U;
-		}
-		if (UNLIKELY(stdin == NULL)) {
-			/* order file is eof'd, skip fetching more */
-			;
-		} else if (UNLIKELY(!noq)) {
-			/* fill up the queue some more and do more exec'ing */
-			goto ord;
-		} else if (oq[noq - 1U].t < newq.t) {
-			/* there could be more orders between Q and NEWQ
-			 * try exec'ing those as well */
-			if (UNLIKELY(noq >= ioq + zoq / 2U)) {
-				/* resize :( */
-				ord_t *nuq = malloc((zoq *= 16U) * sizeof(*oq));
-				memcpy(nuq, oq + ioq, (noq - ioq) * sizeof(*oq));
-				noq -= ioq;
-				ioq = 0U;
-				if (oq != _oq) {
-					free(oq);
-				}
-				oq = nuq;
-			}
-			goto ord;
-		}
-	}
-
-	/* finalise with the last known quote */
-	if (acc.base) {
-		ord_t o = {q.t, RGM_CANCEL, .q = acc.base};
-		exe_t x = try_exec(o, q);
-		send_exe(x);
-		acc = alloc(acc, x, comb, comt);
-		send_acc(x.t, acc);
-	}
-	if (oq != _oq) {
-		free(oq);
-	}
-	return 0;
-}
 
-
 #include "sex1.yucc"
 
 int
@@ -551,12 +91,12 @@ Error: QUOTES file is mandatory.");
 	if (argi->pair_arg) {
 		cont = argi->pair_arg;
 		conz = strlen(cont);
-		conx = hash(cont, conz);
+		sex.conx = sex_conx(cont, conz);
 	}
 
 	if (argi->exe_delay_arg) {
-		exe_age = strtoul(argi->exe_delay_arg, NULL, 10);
-		exe_age *= USECS;
+		sex.exe_age = strtoul(argi->exe_delay_arg, NULL, 10);
+		sex.exe_age *= USECS;
 	}
 
 	if (argi->commission_arg) {
@@ -564,11 +104,11 @@ Error: QUOTES file is mandatory.");
 
 		switch (*on) {
 		default:
-			comb = strtopx(on, &on);
+			sex.comb = strtopx(on, &on);
 
 			if (*on == '/') {
 		case '/':
-			comt = strtopx(++on, &on);
+			sex.comt = strtopx(++on, &on);
 			if (*on == '/') {
 				errno = 0, serror("\
 Error: commission must be given as PXb[/PXt]");
@@ -581,17 +121,17 @@ Error: commission must be given as PXb[/PXt]");
 	}
 
 	if (argi->quantity_arg) {
-		qty = strtoqx(argi->quantity_arg, NULL);
+		sex.qty = strtoqx(argi->quantity_arg, NULL);
 	}
 
-	absq = argi->absqty_flag;
-	maxq = argi->maxqty_flag;
+	sex.absq = argi->absqty_flag;
+	sex.maxq = argi->maxqty_flag;
 
 	if (argi->retry_arg) {
 		if (argi->retry_arg != YUCK_OPTARG_NONE) {
-			rtry = strtoul(argi->retry_arg, NULL, 10);
+			sex.rtry = strtoul(argi->retry_arg, NULL, 10);
 		} else {
-			rtry = NATV;
+			sex.rtry = NATV;
 		}
 	}
 
@@ -603,7 +143,8 @@ Error: cannot open QUOTES file `%s'", *argi->args);
 	}
 
 	/* offline mode */
-	rc = offline(qfp);
+	sex.fill = send_fill;
+	rc = sex_offline(&sex, qfp, stdin);
 
 	fclose(qfp);
 out:
@@ -20,6 +20,7 @@
 #include "dfp754_d32.h"
 #include "dfp754_d64.h"
 #include "hash.h"
+#include "hxtbl.h"
 #include "tv.h"
 #include "nifty.h"
 
@@ -41,10 +42,6 @@ typedef struct {
 	px_t a;
 } quo_t;
 
-/* the name of the new contract */
-static char *cont;
-static size_t conz;
-
 
 static __attribute__((format(printf, 1, 2))) void
 serror(const char *fmt, ...)
@@ -103,7 +100,7 @@ strtohx(const char *x, char **on)
 
 
 static void
-send_sprd(tv_t metr, quo_t quo)
+send_sprd(tv_t metr, const char *cont, size_t conz, quo_t quo)
 {
 	char buf[256U];
 	size_t len;
@@ -123,24 +120,242 @@ send_sprd(tv_t metr, quo_t quo)
 }
 
 
+/* quanta finer than 10^-(NQEXP - 1) are lumped together */
+#define NQEXP		(32U)
+
+static inline __attribute__((const)) unsigned int
+qexp(px_t x)
+{
+/* index of X's quantum, 10^0 and coarser are 0 */
+	const int e = -quantexpd32(x);
+	return e <= 0 ? 0U : e < (int)NQEXP ? (unsigned int)e : NQEXP - 1U;
+}
+
+/* baskets */
+static struct bskt_s {
+	char *name;
+	size_t namz;
+	size_t nlegs;
+	/* number of legs with a quote */
+	size_t nseen;
+	/* bid and ask, sum of all leg contributions */
+	qx_t sumb;
+	qx_t suma;
+	/* number of leg contributions per quantum, bid and ask,
+	 * the sums are printed in the finest quantum currently in use */
+	unsigned int nqb[NQEXP];
+	unsigned int nqa[NQEXP];
+	/* tick that last saw this basket */
+	size_t tick;
+} *bskts;
+static size_t nbskts;
+
+/* legs of all baskets, basket by basket */
+static struct leg_s {
+	hx_t hx;
+	px_t lev;
+	/* last contribution to the basket's bid and ask */
+	px_t b;
+	px_t a;
+	bool seenp;
+	size_t bskt;
+} *legs;
 static size_t nlegs;
-static hx_t hxs[8U];
-static px_t lev[8U];
+
+/* instruments by hash, each with its run of legs in ILEGS,
+ * so an instrument's tick finds all baskets it affects */
+static struct hxtbl_s itbl;
+static struct ins_s {
+	/* start of the run in ILEGS */
+	size_t i;
+	size_t n;
+} *insts;
+static size_t *ilegs;
+
+static int
+add_bskt(const char *name, size_t namz, char *const *args, size_t nargs)
+{
+/* add a basket of NARGS legs +-[LEVER]PAIR, generate a name if NAME is
+ * NULL */
+	struct bskt_s *bk;
+	struct leg_s *l;
+
+	if (UNLIKELY(!nargs)) {
+		errno = 0, serror("\
+Error: spread instrument needs legs");
+		return -1;
+	}
+	bskts = realloc(bskts, (nbskts + 1U) * sizeof(*bskts));
+	legs = realloc(legs, (nlegs + nargs) * sizeof(*legs));
+	if (UNLIKELY(bskts == NULL || legs == NULL)) {
+		serror("\
+Error: cannot allocate legs");
+		return -1;
+	}
+	bk = bskts + nbskts;
+	l = legs + nlegs;
+	*bk = (struct bskt_s){.nlegs = nargs, .sumb = 0.dd, .suma = 0.dd};
+
+	for (size_t i = 0U; i < nargs; i++) {
+		const char *s = args[i];
+		char *on;
+
+		if (!(l[i].lev = strtopx(s, &on))) {
+			switch (*s) {
+			case '+':
+				l[i].lev = 1.df;
+				break;
+			case '-':
+				l[i].lev = -1.df;
+				break;
+			default:
+				errno = 0, serror("\
+Error: instrument must be prefixed with +-[LEVER]");
+				return -1;
+			}
+		}
+		l[i].hx = hash(on, strlen(on));
+		l[i].b = l[i].a = 0.df;
+		l[i].seenp = false;
+		l[i].bskt = nbskts;
+	}
+
+	/* generate the new name */
+	if (name == NULL) {
+		char buf[256U];
+		size_t bi = 0U;
+
+		/* leave room for a lever and a tad of the name */
+		for (size_t i = 0U; i < nargs && bi + 32U < sizeof(buf); i++) {
+			const char *arg = args[i];
+
+			/* overread numbers and stuff in arg */
+			for (; (unsigned)(*arg ^ '0') < 10U ||
+				     *arg == '+' || *arg == '-' ||
+				     *arg == '.'; arg++);
+			if (l[i].lev > 0.df) {
+				buf[bi++] = '+';
+			}
+			bi += pxtostr(buf + bi, sizeof(buf) - bi, l[i].lev);
+			bi += xstrlcpy(buf + bi, arg, sizeof(buf) - bi);
+		}
+		bk->name = strndup(buf, bk->namz = bi);
+	} else {
+		bk->name = strndup(name, bk->namz = namz);
+	}
+	nbskts++;
+	nlegs += nargs;
+	return 0;
+}
+
+static int
+rd_defs(const char *fn)
+{
+/* read basket definitions, NAME TAB LEGS..., from FN */
+	char *line = NULL;
+	size_t llen = 0UL;
+	char **args = NULL;
+	size_t nargs = 0U;
+	size_t nr = 0U;
+	ssize_t nrd;
+	FILE *fp;
+	int rc = 0;
+
+	if (UNLIKELY((fp = fopen(fn, "r")) == NULL)) {
+		serror("\
+Error: cannot open definitions file `%s'", fn);
+		return -1;
+	}
+	while ((nrd = getline(&line, &llen, fp)) > 0) {
+		char *name = line;
+		size_t namz;
+		char *on;
+		size_t n = 0U;
+
+		nr++;
+		if (*line == '#' || *line == '\n') {
+			continue;
+		} else if (UNLIKELY((on = strchr(line, '\t')) == NULL)) {
+			errno = 0, serror("\
+Error: no legs in line %zu of `%s'", nr, fn);
+			rc = -1;
+			break;
+		}
+		namz = on - name;
+		*on++ = '\0';
+		/* split legs on white space */
+		for (char *tok; (tok = strtok(on, " \t\n")) != NULL; on = NULL) {
+			if (n >= nargs) {
+				nargs = nargs ? 2U * nargs : 16U;
+				args = realloc(args, nargs * sizeof(*args));
+			}
+			args[n++] = tok;
+		}
+		if (UNLIKELY(add_bskt(namz ? name : NULL, namz, args, n) < 0)) {
+			errno = 0, serror("\
+Error: cannot add spread in line %zu of `%s'", nr, fn);
+			rc = -1;
+			break;
+		}
+	}
+	free(args);
+	free(line);
+	fclose(fp);
+	return rc;
+}
+
+static int
+make_htbl(void)
+{
+	size_t off = 0U;
+
+	/* number the instruments */
+	for (size_t i = 0U; i < nlegs; i++) {
+		(void)hxtbl_put(&itbl, legs[i].hx);
+	}
+	insts = calloc(itbl.n, sizeof(*insts));
+	ilegs = malloc(nlegs * sizeof(*ilegs));
+	if (UNLIKELY(insts == NULL || ilegs == NULL)) {
+		return -1;
+	}
+	/* count legs per instrument */
+	for (size_t i = 0U; i < nlegs; i++) {
+		insts[hxtbl_get(&itbl, legs[i].hx)].n++;
+	}
+	/* assign runs */
+	for (size_t k = 0U; k < itbl.n; k++) {
+		insts[k].i = off;
+		off += insts[k].n;
+		insts[k].n = 0U;
+	}
+	/* and fill them, in leg order */
+	for (size_t i = 0U; i < nlegs; i++) {
+		struct ins_s *x = insts + hxtbl_get(&itbl, legs[i].hx);
+
+		ilegs[x->i + x->n++] = i;
+	}
+	return 0;
+}
+
+static const struct ins_s*
+find_ins(hx_t hx)
+{
+	const size_t k = hxtbl_get(&itbl, hx);
+
+	/* not for us this isn't, is it? */
+	return k < itbl.n ? insts + k : NULL;
+}
 
 static int
 push_beef(char *ln, size_t UNUSED(lz))
 {
-	static px_t legquo[2U * countof(hxs)];
-	static uint64_t seen;
+	static size_t tick;
+	const struct ins_s *x;
+	const size_t *il;
 	char *on;
-	unsigned int which;
 	px_t b, a;
 	tv_t t;
 
-#define LEGBID(x)	(legquo[(x) * countof(hxs) + 0U])
-#define LEGASK(x)	(legquo[(x) * countof(hxs) + 1U])
-#define LEGQUO(x, y)	(legquo[(x) * countof(hxs) + (y)])
-
 	if (UNLIKELY((t = strtotv(ln, &on)) == NATV)) {
 		/* got metronome cock-up */
 		return -1;
@@ -149,35 +364,56 @@ push_beef(char *ln, size_t UNUSED(lz))
 	with (hx_t hx) {
 		if (UNLIKELY(!(hx = strtohx(++on, &on)) || *on != '\t')) {
 			return -1;
+		} else if ((x = find_ins(hx)) == NULL) {
+			return -1;
 		}
-		for (which = 0U; which < nlegs; which++) {
-			if (hx == hxs[which]) {
-				goto snarf;
-			}
-		}
-		/* not for us this isn't, is it? */
-		return -1;
 	}
-snarf:
+	il = ilegs + x->i;
 	/* snarf quotes */
 	if ((b = strtopx(++on, &on)) && *on == '\t' &&
 	    (a = strtopx(++on, &on)) && (*on == '\n' || *on == '\t')) {
-		LEGQUO(which, lev[which] < 0.df) = b * lev[which];
-		LEGQUO(which, lev[which] > 0.df) = a * lev[which];
-		seen |= 1ULL << which;
+		for (size_t j = 0U; j < x->n; j++) {
+			struct leg_s *l = legs + il[j];
+			struct bskt_s *bk = bskts + l->bskt;
+			const px_t lb = (l->lev > 0.df ? b : a) * l->lev;
+			const px_t la = (l->lev > 0.df ? a : b) * l->lev;
+
+			/* swap the leg's old contribution for the new one */
+			bk->sumb += (qx_t)lb - (qx_t)l->b;
+			bk->suma += (qx_t)la - (qx_t)l->a;
+			if (l->seenp) {
+				bk->nqb[qexp(l->b)]--;
+				bk->nqa[qexp(l->a)]--;
+			}
+			bk->nqb[qexp(lb)]++;
+			bk->nqa[qexp(la)]++;
+			l->b = lb;
+			l->a = la;
+			bk->nseen += !l->seenp;
+			l->seenp = true;
+		}
 	}
 
-	if (LIKELY((seen + 1ULL) >> nlegs)) {
-		/* generate spread */
-		b = 0.df;
-		a = 0.df;
-		for (size_t i = 0U; i < nlegs; i++) {
-			b += LEGBID(i);
-			a += LEGASK(i);
+	/* send off every basket with this instrument, once */
+	tick++;
+	for (size_t j = 0U; j < x->n; j++) {
+		struct bskt_s *bk = bskts + legs[il[j]].bskt;
+
+		if (bk->tick == tick) {
+			continue;
 		}
+		bk->tick = tick;
+		if (LIKELY(bk->nseen >= bk->nlegs)) {
+			unsigned int eb = NQEXP - 1U, ea = NQEXP - 1U;
 
-		/* and send him off */
-		send_sprd(t, (quo_t){b, a});
+			/* the sums carry every quantum they have ever seen,
+			 * fall back to the finest of the current legs */
+			for (; eb && !bk->nqb[eb]; eb--);
+			for (; ea && !bk->nqa[ea]; ea--);
+			b = quantized32((px_t)bk->sumb, scalbnd32(1.df, -(int)eb));
+			a = quantized32((px_t)bk->suma, scalbnd32(1.df, -(int)ea));
+			send_sprd(t, bk->name, bk->namz, (quo_t){b, a});
+		}
 	}
 	return 0;
 }
@@ -198,63 +434,27 @@ main(int argc, char *argv[])
 		goto out;
 	}
 
-	if (!argi->nargs || argi->nargs > countof(hxs)) {
-		errno = 0, serror("\
-Error: spread instrument needs legs, %zu max", countof(hxs));
-		rc = 1;
-		goto out;
-	}
+	if (argi->nargs || !argi->defs_arg) {
+		const char *name = argi->name_arg;
+		const size_t namz = name != NULL ? strlen(name) : 0U;
 
-	for (size_t i = 0U; i < argi->nargs; i++) {
-		const char *s = argi->args[i];
-		char *on;
-
-		if (!(lev[i] = strtopx(s, &on))) {
-			switch (*s) {
-			case '+':
-				lev[i] = 1.df;
-				break;
-			case '-':
-				lev[i] = -1.df;
-				break;
-			default:
-				errno = 0, serror("\
-Error: instrument must be prefixed with +-[LEVER]");
-				rc = 1;
-				goto out;
-			}
+		if (add_bskt(name, namz, argi->args, argi->nargs) < 0) {
+			rc = 1;
+			goto out;
 		}
-		hxs[i] = hash(on, strlen(on));
 	}
-
-	/* generate the new name */
-	if (argi->name_arg) {
-		cont = argi->name_arg;
-		conz = strlen(cont);
-	} else {
-		static char buf[128U];
-		size_t bi = 0U;
-
-		for (size_t i = 0U; i < argi->nargs && bi < sizeof(buf); i++) {
-			const char *arg = argi->args[i];
-
-			/* overread numbers and stuff in arg */
-			for (; (unsigned)(*arg ^ '0') < 10U ||
-				     *arg == '+' || *arg == '-' ||
-				     *arg == '.'; arg++);
-			if (lev[i] > 0.df) {
-				buf[bi++] = '+';
-			}
-			bi += pxtostr(buf + bi, sizeof(buf) - bi, lev[i]);
-			bi += xstrlcpy(buf + bi, arg, sizeof(buf) - bi);
-		}
-		/* set contract */
-		cont = buf;
-		conz = bi;
+	if (argi->defs_arg && rd_defs(argi->defs_arg) < 0) {
+		rc = 1;
+		goto out;
 	}
 
-	/* set up globals */
-	nlegs = argi->nargs;
+	/* set up the leg index */
+	if (UNLIKELY(make_htbl() < 0)) {
+		serror("\
+Error: cannot allocate leg table");
+		rc = 1;
+		goto out;
+	}
 	{
 		char *line = NULL;
 		size_t llen = 0UL;
@@ -268,6 +468,14 @@ Error: instrument must be prefixed with +-[LEVER]");
 	}
 
 out:
+	for (size_t i = 0U; i < nbskts; i++) {
+		free(bskts[i].name);
+	}
+	free(bskts);
+	free(ilegs);
+	free(insts);
+	hxtbl_fini(&itbl);
+	free(legs);
 	yuck_free(argi);
 	return rc;
 }
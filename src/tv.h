@@ -38,6 +38,10 @@
 #define INCLUDED_tv_h_
 #include <unistd.h>
 
+#if defined __cplusplus
+extern "C" {
+#endif	/* __cplusplus */
+
 #define NSECS	(1000000000)
 #define USECS	(1000000)
 #define MSECS	(1000)
@@ -63,7 +67,10 @@ typedef struct {
 extern tv_t strtotv(const char *ln, char **endptr);
 extern tvu_t strtotvu(const char *ln, char **endptr);
 
-extern ssize_t tvtostr(char *restrict buf, size_t bsz, tv_t t);
-extern ssize_t tvutostr(char *restrict buf, size_t bsz, tvu_t t);
+extern ssize_t tvtostr(char *buf, size_t bsz, tv_t t);
+
+#if defined __cplusplus
+}
+#endif	/* __cplusplus */
 
 #endif	/* INCLUDED_tv_h_ */
@@ -0,0 +1,393 @@
+/*** libttt_test.cc -- use libttt from C++
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <tv.h>
+#include <px.h>
+#include <cal.h>
+#include <bt.h>
+#include <cnd.h>
+#include <qd.h>
+#include <mi.h>
+
+static const char *const quos[] = {
+	"1461065877.910000000	1.13322	1.13324",
+	"1461065879.002000000	1.13323	1.13325",
+	"1461065882.511000000	1.13320	1.13326",
+	"1461065886.036000000	1.13325	1.13327",
+};
+
+struct clo_s {
+	size_t ncndl;
+	size_t nfill;
+	px_t minask[4U];
+	px_t fill[2U];
+	char buf[256U];
+	/* evaluations */
+	size_t neva;
+	qx_t nlv[8U];
+	/* distributions, all quotes folded into one candle */
+	size_t nqdc;
+	size_t nbid[4U];
+	struct qdc_s all;
+	/* impact */
+	size_t npnl;
+	px_t pnl[8U];
+	size_t nsum;
+	size_t nlag;
+};
+
+static void
+cndl(void *clo, size_t, tv_t end, const struct cndl_s *c)
+{
+	struct clo_s *x = static_cast<struct clo_s*>(clo);
+	ssize_t n = tvtostr(x->buf, sizeof(x->buf), end);
+
+	x->buf[n++] = '\t';
+	n += px_tostr(x->buf + n, sizeof(x->buf) - n, c->minask);
+	x->buf[n++] = '\t';
+	n += px_tostr(x->buf + n, sizeof(x->buf) - n, c->maxbid);
+	x->buf[n] = '\0';
+	puts(x->buf);
+	if (x->ncndl < 4U) {
+		x->minask[x->ncndl] = c->minask;
+	}
+	x->ncndl++;
+	return;
+}
+
+static void
+fill(void *clo, exe_t x, acc_t a)
+{
+	struct clo_s *c = static_cast<struct clo_s*>(clo);
+	size_t n = exetostr(c->buf, sizeof(c->buf), "EURUSD", 6U, x);
+
+	n += acctostr(c->buf + n, sizeof(c->buf) - n, "EURUSD", 6U, x.t, a);
+	fwrite(c->buf, 1, n, stdout);
+	if (c->nfill < 2U) {
+		c->fill[c->nfill] = x.p;
+	}
+	c->nfill++;
+	return;
+}
+
+static void
+eva(void *clo, size_t, eva_t v)
+{
+	struct clo_s *c = static_cast<struct clo_s*>(clo);
+	size_t n = evatostr(c->buf, sizeof(c->buf), "EURUSD", 6U, v);
+
+	fwrite(c->buf, 1, n, stdout);
+	if (c->neva < 8U) {
+		c->nlv[c->neva] = v.nlv;
+	}
+	c->neva++;
+	return;
+}
+
+static void
+qdc(void *clo, const struct qdc_s *c)
+{
+	struct clo_s *x = static_cast<struct clo_s*>(clo);
+	size_t n = 0U;
+
+	for (size_t i = 0U; i < (1U << c->bits); i++) {
+		n += c->bid[i];
+	}
+	if (x->nqdc < 4U) {
+		x->nbid[x->nqdc] = n;
+	}
+	x->nqdc++;
+	qdc_merge(&x->all, c);
+	return;
+}
+
+static void
+pnl(void *clo, tv_t top, tv_t now, px_t p)
+{
+	struct clo_s *c = static_cast<struct clo_s*>(clo);
+	ssize_t n = tvtostr(c->buf, sizeof(c->buf), now);
+
+	c->buf[n++] = '\t';
+	n += tvtostr(c->buf + n, sizeof(c->buf) - n, now - top);
+	c->buf[n++] = '\t';
+	n += px_tostr(c->buf + n, sizeof(c->buf) - n, p);
+	c->buf[n] = '\0';
+	puts(c->buf);
+	if (c->npnl < 8U) {
+		c->pnl[c->npnl] = p;
+	}
+	c->npnl++;
+	return;
+}
+
+static void
+sum(void *clo, tv_t lag, mom_t m)
+{
+	struct clo_s *c = static_cast<struct clo_s*>(clo);
+
+	c->nsum++;
+	c->nlag += m.n * (lag / NSECS);
+	return;
+}
+
+static int
+check_eva(struct clo_s *clo)
+{
+/* a long from the first quote, evaluated every second */
+	struct eva_s e = {};
+	const acc_t acc = {
+		qx_fromstr("1", NULL), qx_fromstr("-1.13324", NULL),
+		qx_t(), qx_t(),
+	};
+	int rc = 0;
+
+	e.intv = NSECS;
+	e.eva = eva;
+	e.clo = clo;
+	for (size_t i = 0U; i < 3U; i++) {
+		char *on;
+		tv_t t = strtotv(quos[i], &on);
+		px_t b = px_fromstr(++on, &on);
+		px_t a = px_fromstr(++on, &on);
+		quo_t q = {t, b, a};
+
+		eva_push_quo(&e, q);
+		if (!i) {
+			eva_push_acc(&e, 0U, t, acc);
+		}
+	}
+	eva_fini(&e);
+
+	/* 78 and 79 at the first bid, 80 to 82 at the second */
+	rc |= clo->neva != 5U;
+	rc |= clo->nlv[0U] != qx_fromstr("-0.00002", NULL);
+	rc |= clo->nlv[4U] != qx_fromstr("-0.00001", NULL);
+	/* longs are valued at the bid */
+	{
+		quo_t q = {NATV, px_fromstr("1.13325", NULL), px_t()};
+		eva_t v = eva_acc(q.t, acc, q);
+		rc |= v.nlv != qx_fromstr("0.00001", NULL);
+	}
+	return rc;
+}
+
+static int
+check_sum(void)
+{
+/* two identical round trips, summarised separately then merged */
+	struct sum_s s = {}, o = {};
+	const acc_t l = {
+		qx_fromstr("1", NULL), qx_fromstr("-1.13324", NULL),
+		qx_t(), qx_t(),
+	};
+	const acc_t f = {
+		qx_t(), qx_fromstr("0.00001", NULL), qx_t(), qx_t(),
+	};
+	const exe_t x = {
+		NSECS, px_fromstr("1.13325", NULL), qx_fromstr("-1", NULL),
+		px_fromstr("0.00002", NULL), 0U,
+	};
+	int rc = 0;
+
+	sum_init(&s);
+	sum_init(&o);
+	sum_push_acc(&s, NSECS, l);
+	sum_push_acc(&o, NSECS, l);
+	sum_push_exe(&s, x);
+	sum_push_exe(&o, x);
+	sum_push_acc(&s, 2ULL * NSECS, f);
+	sum_push_acc(&o, 2ULL * NSECS, f);
+	sum_merge(&s, &o);
+	sum_fini(&s);
+	sum_fini(&o);
+
+	/* the long won, twice, after one second each */
+	rc |= o.hits[1U] != 1U;
+	rc |= s.hits[1U] != 2U;
+	rc |= s.rpnl[1U] != qx_fromstr("0.00002", NULL);
+	rc |= s.tagg[1U] != 2ULL * NSECS;
+	return rc;
+}
+
+static int
+check_qd(struct clo_s *clo)
+{
+	struct qd_s q = {};
+	int rc = 0;
+
+	q.intv = strtotvu("5s", NULL);
+	q.bits = 5U;
+	q.cndl = qdc;
+	q.clo = clo;
+	if (qd_init(&q) < 0 || qdc_init(&clo->all, q.bits) < 0) {
+		return 1;
+	}
+	for (size_t i = 0U; i < sizeof(quos) / sizeof(*quos); i++) {
+		char *on;
+		tv_t t = strtotv(quos[i], &on);
+		px_t b = px_fromstr(++on, &on);
+		px_t a = px_fromstr(++on, &on);
+
+		qd_push(&q, t, "EURUSD", 6U, b, a,
+			qx_fromstr("1000000", NULL),
+			qx_fromstr("2000000", NULL));
+	}
+	qd_flush(&q);
+	qd_fini(&q);
+
+	/* same three candles as above */
+	rc |= clo->nqdc != 3U;
+	rc |= clo->nbid[0U] != 2U;
+	rc |= clo->nbid[1U] != 1U;
+	rc |= clo->nbid[2U] != 1U;
+	{
+		size_t nb = 0U, na = 0U, nt = 0U;
+
+		for (size_t i = 0U; i < (1U << clo->all.bits); i++) {
+			nb += clo->all.bsz[i];
+			na += clo->all.ask[i];
+		}
+		for (size_t i = 0U; i < clo->all.t.n; i++) {
+			nt += clo->all.t.cnt[i];
+		}
+		rc |= nb != 4U || na != 4U || nt != 4U;
+	}
+	qdc_fini(&clo->all);
+	return rc;
+}
+
+static int
+check_mi(struct clo_s *clo)
+{
+/* a long at the first quote, evaluated every second for 3 seconds */
+	static const char *const bas[][2U] = {
+		{"1.0", "1.2"}, {"1.1", "1.3"}, {"1.2", "1.4"},
+		{"1.3", "1.5"}, {"1.4", "1.6"}, {"1.5", "1.7"},
+	};
+	struct mi_s m = {};
+	int rc = 0;
+
+	m.intv = NSECS;
+	m.maxt = 3ULL * NSECS;
+	m.sump = 1U;
+	m.pnl = pnl;
+	m.sum = sum;
+	m.clo = clo;
+	if (mi_init(&m) < 0) {
+		return 1;
+	}
+	for (size_t i = 0U; i < sizeof(bas) / sizeof(*bas); i++) {
+		const tv_t t = (i + 1U) * NSECS;
+
+		rc |= mi_push_quo(&m, t, px_fromstr(bas[i][0U], NULL),
+				  px_fromstr(bas[i][1U], NULL));
+		if (!i) {
+			rc |= mi_push_opp(&m, t, px_t(HUGE_VALF));
+		}
+	}
+	mi_fini(&m);
+
+	/* bought at 1.2, then valued at the bids from 1.0 to 1.3 */
+	rc |= clo->npnl != 4U;
+	rc |= clo->pnl[0U] != px_fromstr("-0.2", NULL);
+	rc |= clo->pnl[3U] != px_fromstr("0.1", NULL);
+	/* lags 0s to 3s, once each */
+	rc |= clo->nsum != 4U;
+	rc |= clo->nlag != 0U + 1U + 2U + 3U;
+	return rc;
+}
+
+int
+main(void)
+{
+	struct clo_s clo = {};
+	struct cnd_s cnd = {};
+	struct sex_s sex = {};
+	int rc = 0;
+
+	cnd.nintv = 1U;
+	cnd.intv[0U] = strtotvu("5s", NULL);
+	cnd.cndl = cndl;
+	cnd.clo = &clo;
+	cnd_init(&cnd);
+
+	sex.qty = qx_fromstr("1", NULL);
+	sex.rtry = NATV;
+	sex.conx = sex_conx("EURUSD", 6U);
+	sex.fill = fill;
+	sex.clo = &clo;
+	sex_init(&sex);
+
+	for (size_t i = 0U; i < sizeof(quos) / sizeof(*quos); i++) {
+		char *on;
+		tv_t t = strtotv(quos[i], &on);
+		px_t b = px_fromstr(++on, &on);
+		px_t a = px_fromstr(++on, &on);
+		quo_t q = {t, b, a};
+
+		cnd_push(&cnd, t, "EURUSD", 6U, b, a, qx_t(), qx_t());
+		if (i == 1U) {
+			/* go long just before the third quote */
+			ord_t o = {t + 1U, RGM_LONG, NATV, sex.qty, px_t(1000)};
+			sex_push_ord(&sex, o);
+		}
+		sex_push_quo(&sex, q);
+	}
+	cnd_fini(&cnd);
+	sex_fini(&sex);
+
+	/* three candles */
+	rc |= clo.ncndl != 3U;
+	rc |= clo.minask[0U] != px_fromstr("1.13324", NULL);
+	rc |= clo.minask[1U] != px_fromstr("1.13326", NULL);
+	rc |= clo.minask[2U] != px_fromstr("1.13327", NULL);
+	/* the long and the flattening at the end */
+	rc |= clo.nfill != 2U;
+	/* bought at the ask standing then, sold at the last bid */
+	rc |= clo.fill[0U] != px_fromstr("1.13325", NULL);
+	rc |= clo.fill[1U] != px_fromstr("1.13325", NULL);
+
+	rc |= check_eva(&clo);
+	rc |= check_sum();
+	rc |= check_qd(&clo);
+	rc |= check_mi(&clo);
+	return rc;
+}
+
+/* libttt_test.cc ends here */
@@ -0,0 +1,94 @@
+/*** mom_test.c -- batched and merged moments against mom_push()
+ *
+ * Copyright (C) 2014-2018 Sebastian Freundt
+ *
+ * Author:  Sebastian Freundt <freundt@ga-group.nl>
+ *
+ * This file is part of ttt.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the author nor the names of any contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED.  IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ ***/
+#include <stdio.h>
+/* the unit under test, verbatim */
+#include "mom.c"
+
+static int
+eq(double x, double y)
+{
+	const double d = x > y ? x - y : y - x;
+	const double m = x > 0 ? x : -x;
+	return d <= 1e-9 * (m > 1 ? m : 1);
+}
+
+static int
+cmp(const char *what, mom_t x, mom_t y)
+{
+	if (x.n != y.n ||
+	    !eq(x.m1, y.m1) || !eq(x.m2, y.m2) ||
+	    !eq(x.m3, y.m3) || !eq(x.m4, y.m4)) {
+		fprintf(stderr, "%s: %zu %g %g %g %g  !=  %zu %g %g %g %g\n",
+			what, x.n, x.m1, x.m2, x.m3, x.m4,
+			y.n, y.m1, y.m2, y.m3, y.m4);
+		return 1;
+	}
+	return 0;
+}
+
+int
+main(void)
+{
+	/* odd sizes so the tails of the batched lanes are used */
+	static double x[1000U + 777U];
+	const size_t na = 1000U, nb = 777U;
+	unsigned long s = 42U;
+	mom_t p = {.n = 0U}, pa = {.n = 0U};
+	mom_t a, b;
+	int rc = 0;
+
+	for (size_t i = 0U; i < countof(x); i++) {
+		/* skewed values, roughly pnls of a few pips */
+		s = s * 6364136223846793005UL + 1442695040888963407UL;
+		x[i] = (double)(s >> 40U) / (double)(1UL << 24U);
+		x[i] = x[i] * x[i] * x[i] / 1000 - 0.0002;
+		p = mom_push(p, x[i]);
+		if (i < na) {
+			pa = mom_push(pa, x[i]);
+		}
+	}
+	a = mom_batch(x, na);
+	b = mom_batch(x + na, nb);
+
+	rc |= cmp("batch", a, pa);
+	rc |= cmp("merge", mom_merge(a, b), p);
+	rc |= cmp("merge-empty", mom_merge(a, mom_batch(x, 0U)), pa);
+	rc |= cmp("empty-merge", mom_merge(mom_batch(x, 0U), a), pa);
+	return rc;
+}
+
+/* mom_test.c ends here */